@@ -0,0 +1,60 @@
+import sys
+import time
+import mmap
+import struct
+import numpy as np
+
+# Follows a running simulation through the file written by /LiveExport/fileName
+# (layout documented in include/LiveExport.hh).
+#
+#   python3 LiveView.py /dev/shm/G4_HPGe.live          prints events and rate
+#   python3 LiveView.py /dev/shm/G4_HPGe.live --plot   shows the spectrum
+
+HEADER = struct.Struct("<8sIIQddQdddd")
+
+def read(buffer):
+    # seqlock: retry while the simulation is writing
+    while True:
+        before = struct.unpack_from("<Q", buffer, 16)[0]
+        if before % 2 == 1:
+            time.sleep(0.001)
+            continue
+        data = bytes(buffer)
+        after = struct.unpack_from("<Q", buffer, 16)[0]
+        if before == after:
+            break
+
+    magic, version, nBins, sequence, Emin, Emax, runID, events, rate, runTime, updateTime = HEADER.unpack_from(data)
+    if magic != b"G4HPGeLV" or version != 1:
+        raise RuntimeError("not a live export file (version 1)")
+    contents = np.frombuffer(data, dtype="<f8", count=nBins+2, offset=HEADER.size)
+    return dict(nBins=nBins, Emin=Emin, Emax=Emax, runID=runID, events=events, rate=rate,
+                runTime=runTime, updateTime=updateTime, contents=contents)
+
+file = sys.argv[1]
+plot = "--plot" in sys.argv
+
+with open(file, "rb") as f:
+    buffer = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+if plot:
+    import matplotlib.pyplot as plt
+    plt.ion()
+    fig, ax = plt.subplots()
+
+while True:
+    snapshot = read(buffer)
+    print("run {}: {:.0f} events, {:.0f} events/s, {:.0f} s (updated {:.1f} s ago)".format(
+        snapshot["runID"], snapshot["events"], snapshot["rate"], snapshot["runTime"],
+        time.time() - snapshot["updateTime"]))
+
+    if plot:
+        edges = np.linspace(snapshot["Emin"], snapshot["Emax"], snapshot["nBins"]+1)
+        ax.clear()
+        ax.stairs(snapshot["contents"][1:-1], edges)
+        ax.set_yscale("log")
+        ax.set_xlabel("Energy [MeV]")
+        ax.set_ylabel("Counts")
+        plt.pause(2)
+    else:
+        time.sleep(2)
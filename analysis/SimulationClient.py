@@ -0,0 +1,88 @@
+"""Client of the simulation server (G4_HPGe --serve <socket>).
+
+The server keeps geometry, physics and threads set up, so that a job only
+simulates events:
+
+    from SimulationClient import SimulationClient
+
+    client = SimulationClient("/tmp/g4hpge.sock")
+    results = client.run([
+        "/PrimaryGenerator/GammaDecayScheme/position 0.3 -1.2 -2.1 cm",
+        "/run/beamOn 100000",
+    ])
+    counts = results[0]["h1"].contents[7750:7850].sum()
+
+Every /run/beamOn of a job gives one result, a dictionary of the spectra by
+name ("h1", "h1w", "h1_<component>"). Jobs of several clients are run one
+after the other.
+"""
+
+import socket
+
+import numpy as np
+
+
+class Spectrum:
+    """A spectrum sent by the server, energies in MeV."""
+
+    def __init__(self, nBins, Emin, Emax, entries, contents):
+        self.nBins = nBins
+        self.Emin = Emin
+        self.Emax = Emax
+        self.entries = entries
+        self.underflow = contents[0]
+        self.overflow = contents[-1]
+        self.contents = contents[1:-1]
+
+    def energies(self):
+        """Lower edges of the bins."""
+        return self.Emin + (self.Emax - self.Emin)*np.arange(self.nBins)/self.nBins
+
+
+class SimulationClient:
+    def __init__(self, socket_name):
+        self.socket_name = socket_name
+
+    def run(self, commands):
+        """Runs the commands as one job, returns the spectra of every /run/beamOn."""
+        connection = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            connection.connect(self.socket_name)
+            connection.sendall(("\n".join(commands) + "\n").encode())
+            connection.shutdown(socket.SHUT_WR)
+            return self._receive(connection.makefile("rb"))
+        finally:
+            connection.close()
+
+    def shutdown(self):
+        """Stops the server."""
+        self.run(["shutdown"])
+
+    @staticmethod
+    def _receive(stream):
+        results = []
+        previous = None
+        while True:
+            line = stream.readline().decode()
+            if not line:
+                raise ConnectionError("The server closed the connection before the end of the job.")
+            fields = line.split()
+            if fields[0] == "done":
+                return results
+            if fields[0] == "error":
+                raise RuntimeError("Job failed: " + line[len("error "):].strip())
+            if fields[0] != "spectrum":
+                raise ConnectionError("Unexpected answer of the server: " + line.strip())
+
+            name = fields[1]
+            nBins = int(fields[2])
+            size = (nBins + 2)*8
+            data = stream.read(size)
+            if len(data) != size:
+                raise ConnectionError("The server closed the connection within a spectrum.")
+            contents = np.frombuffer(data, dtype=np.float64)
+            # every /run/beamOn starts again with h1
+            if name == "h1" or previous is None:
+                results.append({})
+            results[-1][name] = Spectrum(nBins, float(fields[3]), float(fields[4]), float(fields[5]), contents)
+            previous = name
@@ -0,0 +1,151 @@
+"""In-process interface to the simulation (libg4hpge, see include/api/g4hpge.h).
+
+The geometry and physics are set up once, after which every call of run()
+only simulates events, e.g. for a scan of the source position:
+
+    import numpy as np
+    import g4hpge
+
+    sim = g4hpge.Simulation("mac/setup.mac", threads=6)
+    sim.select("GammaDecayScheme")
+    sim.command("/PrimaryGenerator/GammaDecayScheme/levelFile data/14N.txt")
+    sim.command("/PrimaryGenerator/GammaDecayScheme/excitedState 7824 keV")
+    for x in np.arange(-3, 3.1, 0.3):
+        sim.set_position(x, 0, -2.1, "cm")
+        sim.run(100000)
+        counts = sim.spectrum()[7750:7850].sum()
+
+The spectra are NumPy arrays that view the bins of the histograms in the
+simulation, without a copy: the next run overwrites them, use .copy() to keep
+a result. Only one simulation can exist per process, and it cannot be set up
+again once closed.
+
+The library is looked for in $G4HPGE_LIBRARY, next to this file and in the
+current directory.
+"""
+
+import ctypes
+import os
+
+import numpy as np
+
+
+def _load_library():
+    candidates = []
+    if "G4HPGE_LIBRARY" in os.environ:
+        candidates.append(os.environ["G4HPGE_LIBRARY"])
+    for directory in (os.path.dirname(os.path.abspath(__file__)), os.getcwd()):
+        candidates.append(os.path.join(directory, "libg4hpge.so"))
+        candidates.append(os.path.join(directory, "libg4hpge.dylib"))
+
+    for candidate in candidates:
+        if os.path.exists(candidate):
+            library = ctypes.CDLL(candidate, mode=ctypes.RTLD_GLOBAL)
+            break
+    else:
+        raise OSError("libg4hpge not found, set G4HPGE_LIBRARY (tried {})".format(", ".join(candidates)))
+
+    library.g4hpge_initialize.argtypes = [ctypes.c_char_p, ctypes.c_int, ctypes.c_long, ctypes.c_char_p]
+    library.g4hpge_initialize.restype = ctypes.c_int
+    library.g4hpge_command.argtypes = [ctypes.c_char_p]
+    library.g4hpge_command.restype = ctypes.c_int
+    library.g4hpge_run.argtypes = [ctypes.c_longlong]
+    library.g4hpge_run.restype = ctypes.c_int
+    library.g4hpge_spectrum.argtypes = [ctypes.c_char_p, ctypes.POINTER(ctypes.c_int),
+                                        ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double),
+                                        ctypes.POINTER(ctypes.c_double)]
+    library.g4hpge_spectrum.restype = ctypes.POINTER(ctypes.c_double)
+    library.g4hpge_finalize.argtypes = []
+    library.g4hpge_finalize.restype = ctypes.c_int
+    library.g4hpge_last_error.argtypes = []
+    library.g4hpge_last_error.restype = ctypes.c_char_p
+    return library
+
+
+_library = None
+
+
+class Simulation:
+    """The simulation of this process."""
+
+    def __init__(self, setup_macro=None, threads=0, seed=0, output=None):
+        """Sets up geometry, physics and threads.
+
+        setup_macro -- commands before /run/initialize (geometry), initialized
+                       afterwards unless the macro does it
+        threads     -- number of worker threads (0: Geant4 default)
+        seed        -- seed of the random engine (0: default seeds)
+        output      -- ROOT file written when the simulation is closed
+        """
+        global _library
+        if _library is None:
+            _library = _load_library()
+        self._generator = None
+        self._check(_library.g4hpge_initialize(_encode(setup_macro), threads, seed, _encode(output)))
+
+    def command(self, command):
+        """Applies a macro command."""
+        self._check(_library.g4hpge_command(_encode(command)))
+
+    def select(self, generator):
+        """Selects the primary generator, whose position set_position() sets."""
+        self.command("/PrimaryGenerator/select {}".format(generator))
+        self._generator = generator
+
+    def set_position(self, x, y, z, unit="mm"):
+        """Sets the source position of the selected generator."""
+        if self._generator is None:
+            raise RuntimeError("Select a generator first.")
+        self.command("/PrimaryGenerator/{}/position {} {} {} {}".format(self._generator, x, y, z, unit))
+
+    def set_dimension(self, geometry_object, dimension, value_mm):
+        """Changes a registered dimension (in mm), the geometry is rebuilt before the next run."""
+        self.command("/Geometry/{}/setDimension {} {} mm".format(geometry_object, dimension, value_mm))
+        self.command("/run/reinitializeGeometry")
+
+    def run(self, events):
+        """Clears the spectra and simulates events."""
+        self._check(_library.g4hpge_run(events))
+
+    def spectrum(self, name="h1", with_flow=False):
+        """Spectrum "h1", "h1w" or "h1_<component>" as a view into the simulation.
+
+        Bin i covers [Emin + i*width, Emin + (i+1)*width), see energies().
+        With with_flow the underflow and overflow bins are included.
+        """
+        contents = self._contents(name)[0]
+        return contents if with_flow else contents[1:-1]
+
+    def entries(self, name="h1"):
+        """Number of events in the spectrum."""
+        return self._contents(name)[1]
+
+    def energies(self, name="h1"):
+        """Lower edges of the bins of the spectrum, in MeV."""
+        nBins, Emin, Emax = self._contents(name)[2:]
+        return Emin + (Emax - Emin)*np.arange(nBins)/nBins
+
+    def close(self):
+        """Deletes the run manager and writes the output file."""
+        self._check(_library.g4hpge_finalize())
+
+    def _contents(self, name):
+        nBins = ctypes.c_int()
+        Emin = ctypes.c_double()
+        Emax = ctypes.c_double()
+        entries = ctypes.c_double()
+        pointer = _library.g4hpge_spectrum(_encode(name), ctypes.byref(nBins), ctypes.byref(Emin),
+                                           ctypes.byref(Emax), ctypes.byref(entries))
+        if not pointer:
+            raise RuntimeError(_library.g4hpge_last_error().decode())
+        contents = np.ctypeslib.as_array(pointer, shape=(nBins.value + 2,))
+        return contents, entries.value, nBins.value, Emin.value, Emax.value
+
+    @staticmethod
+    def _check(status):
+        if status != 0:
+            raise RuntimeError(_library.g4hpge_last_error().decode())
+
+
+def _encode(text):
+    return None if text is None else text.encode()
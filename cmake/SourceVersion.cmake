@@ -0,0 +1,26 @@
+# Writes the version of the code into OUTPUT, run at every build by the
+# target g4hpge_version: the git description and a hash of all sources, so
+# that every edit changes the keys of the result cache (ResultCache).
+#
+#     cmake -DSOURCE_DIR=<source> -DOUTPUT=<header> -P SourceVersion.cmake
+
+execute_process(COMMAND git describe --always --dirty
+                WORKING_DIRECTORY ${SOURCE_DIR}
+                OUTPUT_VARIABLE G4HPGE_DESCRIPTION
+                OUTPUT_STRIP_TRAILING_WHITESPACE ERROR_QUIET)
+if(NOT G4HPGE_DESCRIPTION)
+  set(G4HPGE_DESCRIPTION "unknown")
+endif()
+
+file(GLOB_RECURSE version_files RELATIVE ${SOURCE_DIR}
+     ${SOURCE_DIR}/src/*.cc ${SOURCE_DIR}/include/*.hh ${SOURCE_DIR}/CMakeLists.txt)
+list(SORT version_files)
+set(version_hashes "")
+foreach(version_file ${version_files})
+  file(SHA1 ${SOURCE_DIR}/${version_file} version_hash)
+  set(version_hashes "${version_hashes}${version_file} ${version_hash}\n")
+endforeach()
+string(SHA1 G4HPGE_SOURCE_HASH "${version_hashes}")
+
+# only rewritten if the version changed, so nothing is recompiled otherwise
+configure_file(${SOURCE_DIR}/cmake/G4HPGeVersion.hh.in ${OUTPUT} @ONLY)
@@ -2,19 +2,35 @@
 #define ActionInitialization_hh
 
 #include "G4VUserActionInitialization.hh"
+#include "AsyncWriter.hh"
 #include "EnergyHistogram.hh"
+#include "DecayChainLimits.hh"
+#include "LiveExport.hh"
+#include "PhaseSpaceRecorder.hh"
+#include "RunControl.hh"
 
 class ActionInitialization : public G4VUserActionInitialization
 {
 public:
-    ActionInitialization();
+    ActionInitialization(const G4String& outputFileName = "./sim.root");
     virtual ~ActionInitialization();
 
     virtual void BuildForMaster() const;
     virtual void Build() const;
 
+    EnergyHistogram* GetEnergyHistogram() const
+    {
+        return m_energyHistogram;
+    }
+
 private:
     EnergyHistogram *m_energyHistogram = nullptr;
+    RunControl *m_runControl = nullptr;
+    LiveExport *m_liveExport = nullptr;
+    DecayChainLimits *m_decayChainLimits = nullptr;
+    PhaseSpaceRecorder *m_phaseSpaceRecorder = nullptr;
+    AsyncWriter *m_asyncWriter = nullptr;
+    G4String m_outputFileName;
 };
 
 #endif // #ifndef ActionInitialization_hh
@@ -0,0 +1,38 @@
+#ifndef AdjointPhysicsList_hh
+#define AdjointPhysicsList_hh
+
+#include "G4VUserPhysicsList.hh"
+#include "globals.hh"
+#include "G4SystemOfUnits.hh"
+
+/// Physics list of the reverse Monte Carlo (adjoint) mode, "--adjoint".
+///
+/// The forward processes are the standard electromagnetic ones of photons,
+/// electrons and positrons, which track the forward gamma in the crystal.
+/// The photon processes are registered with the G4AdjointCSManager, which
+/// derives the adjoint cross sections from them. Adjoint gammas scatter by
+/// reverse Compton scattering; photoelectric absorption and pair production
+/// only enter their weights, through the difference of the forward and the
+/// adjoint total cross sections (G4AdjointAlongStepWeightCorrection).
+/// Adjoint electrons are not transported.
+///
+/// The adjoint models cover 1 keV to 20 MeV, enough for the lines of 12C.
+
+class AdjointPhysicsList : public G4VUserPhysicsList
+{
+public:
+    AdjointPhysicsList();
+    virtual ~AdjointPhysicsList() {}
+
+    virtual void ConstructParticle();
+    virtual void ConstructProcess();
+    virtual void SetCuts();
+
+    /// Upper limit of the adjoint models
+    static G4double GetMaxEnergy()
+    {
+        return 20*CLHEP::MeV;
+    }
+};
+
+#endif // AdjointPhysicsList_hh
@@ -0,0 +1,154 @@
+#ifndef AdjointSimulation_hh
+#define AdjointSimulation_hh
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+#include <map>
+using std::map;
+#include <memory>
+using std::shared_ptr;
+#include <vector>
+using std::vector;
+
+class G4LogicalVolume;
+class G4Step;
+class G4VPhysicalVolume;
+class G4UIcmdWithAString;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithoutParameter;
+
+class DetectorConstruction;
+class EnergyHistogram;
+
+/// Detector response to gamma lines from activity distributed in the
+/// GeometryObjects, for all objects in one reverse Monte Carlo (adjoint) run.
+///
+/// Needs "--adjoint", which selects the AdjointPhysicsList and the sequential
+/// run manager. "/Adjoint/beamOn N" runs N events of G4AdjointSimManager:
+/// an adjoint gamma starts on the outer surface of the germanium crystal and
+/// is followed back towards the sources, gaining energy in reverse Compton
+/// scatterings, until it leaves the geometry (or exceeds the upper limit of
+/// the adjoint models, 20 MeV). Then the equivalent forward gamma is tracked
+/// from the surface into the crystal and gives the deposit. Geant4 only runs
+/// the forward phase for adjoint tracks that reached the external source, so
+/// the tracks are not ended at the highest line; they only stop scoring
+/// there. Events that scored without reaching it are counted and reported.
+///
+/// The track length of the adjoint gammas in the volumes of an object,
+/// within an energy window around a line, estimates the response to that
+/// line emitted in the object. With the normalisation of the adjoint weights
+/// (response = weight x directional flux per steradian, as in the Geant4
+/// example rmc01), a line emitted uniformly in the mass M of an object gives
+/// the response per emitted gamma
+///
+///     (1/N) sum weight x length x density / (4 pi M window)
+///
+/// The spectrum "h1_adjoint_<object>" holds it at the deposit of the forward
+/// phase, summed over the lines with their yields: counts per decay. The
+/// total response and the full-energy peak of every line are printed after
+/// the run, with their statistical uncertainties.
+///
+///     /Adjoint/line 1173.2 keV 0.9985
+///     /Adjoint/line 1332.5 keV 0.9998
+///     /Adjoint/beamOn 1000000
+///
+/// mac/adjointCheck.mac checks the normalisation for one object and line
+/// against a forward run with the IsotropicGun confined to the object.
+///
+/// Only photons are followed back, electrons from the sources (betas,
+/// bremsstrahlung) are not covered. Activity in the crystal itself lies
+/// within the adjoint source and is not scored.
+
+class AdjointSimulation : public G4UImessenger
+{
+public:
+    AdjointSimulation(DetectorConstruction* detectorConstruction, EnergyHistogram* energyHistogram);
+    virtual ~AdjointSimulation()
+    {
+        s_instance = nullptr;
+    }
+
+    void SetNewValue(G4UIcommand* command, G4String newValue);
+
+    void BeamOn(G4int nEvents);
+
+    /// Whether the program runs in the adjoint mode
+    static G4bool IsEnabled()
+    {
+        return s_instance != nullptr;
+    }
+
+    /// Called for every step, scores those of the adjoint phase and returns
+    /// whether the step belonged to it
+    static G4bool Step(const G4Step* step);
+
+    /// Called at the end of every event with the deposit in the active
+    /// volume, returns whether the event belonged to an adjoint run
+    static G4bool EndOfEvent(G4double edep);
+
+private:
+    struct Line
+    {
+        G4double energy;
+        G4double yield;
+    };
+
+    struct Object
+    {
+        G4String name;
+        G4double mass;
+    };
+
+    struct Score
+    {
+        G4int object;
+        G4int line;
+        G4double energy;
+        G4double value;
+    };
+
+    /// Assigns the volumes to the objects, weighs them and defines the
+    /// adjoint and the external source
+    void Prepare();
+
+    /// Adds the masses of physical and its daughters to their objects
+    void AddMasses(G4VPhysicalVolume* physical, G4double copies);
+
+    void PrintResults() const;
+
+    static AdjointSimulation* s_instance;
+
+    DetectorConstruction* m_detectorConstruction;
+    EnergyHistogram* m_energyHistogram;
+
+    vector<Line> m_lines;
+    G4double m_window;
+    G4double m_minEnergy;
+    // highest energy that scores, the upper edge of the highest line window
+    G4double m_maxEnergy = 0;
+
+    vector<Object> m_objects;
+    map<const G4LogicalVolume*, G4int> m_objectIndex;
+
+    G4bool m_running = false;
+    G4int m_nEvents = 0;
+    // events that scored but had no forward phase
+    G4int m_lostEvents = 0;
+    // scores of the current event
+    vector<Score> m_eventScores;
+    vector<G4double> m_eventTotal;
+    vector<G4double> m_eventPeak;
+    // by object*nLines + line, summed over the events, and their squares
+    vector<G4double> m_total, m_total2;
+    vector<G4double> m_peak, m_peak2;
+
+    shared_ptr<G4UIcmdWithAString> m_lineCmd;
+    shared_ptr<G4UIcmdWithoutParameter> m_clearLinesCmd;
+    shared_ptr<G4UIcmdWithADoubleAndUnit> m_windowCmd;
+    shared_ptr<G4UIcmdWithADoubleAndUnit> m_minEnergyCmd;
+    shared_ptr<G4UIcmdWithAnInteger> m_beamOnCmd;
+};
+
+#endif // AdjointSimulation_hh
@@ -0,0 +1,170 @@
+#ifndef AsyncWriter_hh
+#define AsyncWriter_hh
+
+#include "G4UImessenger.hh"
+#include "G4AutoLock.hh"
+#include "globals.hh"
+
+#include <atomic>
+#include <memory>
+using std::shared_ptr;
+using std::unique_ptr;
+#include <thread>
+#include <vector>
+using std::vector;
+
+class G4UIcmdWithABool;
+class G4UIcmdWithAnInteger;
+
+class TFile;
+class TTree;
+class TH1D;
+
+class EnergyHistogram;
+
+/// Writes the event tree "t1" from a separate thread, so that the memory
+/// use does not grow with the run length and writing does not stall the
+/// event loop or the next run.
+///
+/// Every thread collects the energies of its events in a buffer of its own.
+/// Full buffers are passed as blocks through a bounded lock-free queue to
+/// the writer thread, which streams them into the output file. If the queue
+/// is full, the threads wait for the writer (backpressure), so at most
+/// queueSize + number of threads blocks exist at any time. The partial
+/// buffers are passed on by the master at the end of every run.
+///
+///     /Output/async true          t1 through the writer thread
+///     /Output/perRun true         one file per run (<output>_run<N>.root,
+///                                 with h1 and t1 of the run only)
+///     /Output/queueSize 64        blocks of 4096 events
+///
+/// Without perRun the tree goes into the normal output file, to which the
+/// spectra are added at the end. Without async everything is kept in
+/// memory and written at the end, as before. The spectra of a run file are
+/// the difference of the spectra at the end and at the start of the run,
+/// while the spectra of the normal output file still add up all runs.
+///
+/// There is nothing to write without an output file (server mode, library
+/// without output name), so async is refused there. An error of the writer
+/// thread (e.g. a file that cannot be created) stops the writing and is
+/// raised on the master at the end of the run.
+
+class AsyncWriter : public G4UImessenger
+{
+public:
+    /// Per-thread buffer of the events
+    class Buffer
+    {
+    public:
+        Buffer(AsyncWriter* writer);
+
+        void Add(const G4double energy)
+        {
+            if (!m_writer->m_enabled)
+            {
+                return;
+            }
+            m_energies.push_back(energy);
+            if (m_energies.size() >= blockSize)
+            {
+                Flush();
+            }
+        }
+
+        void Flush();
+
+    private:
+        AsyncWriter* m_writer;
+        vector<G4double> m_energies;
+    };
+
+    AsyncWriter(EnergyHistogram* energyHistogram, const G4String& outputFileName);
+    virtual ~AsyncWriter();
+
+    void SetNewValue(G4UIcommand* command, G4String newValue);
+
+    /// Buffer of the calling (worker) thread, owned by the writer
+    Buffer* CreateBuffer();
+
+    // Called by the master at the beginning and the end of every run
+    void BeginOfRun(G4int runID);
+    void EndOfRun();
+
+    /// Passes on what is left and waits for the writer thread to finish.
+    void Stop();
+
+    /// Whether the tree was written into the normal output file, which the
+    /// spectra then have to be added to
+    G4bool HasWrittenOutputFile() const
+    {
+        return m_outputFileWritten;
+    }
+
+    static const size_t blockSize = 4096;
+
+private:
+    struct Job
+    {
+        enum Type {jobEvents, jobEndOfRun, jobStop} type;
+        G4int runID;
+        G4bool perRun;
+        vector<G4double> energies;
+        vector<unique_ptr<TH1D>> histograms;
+    };
+
+    // bounded multi-producer queue (D. Vyukov), the writer is the consumer
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        Job* job;
+    };
+
+    void Push(Job* job);
+    Job* Pop();
+
+    void Start();
+    void FlushBuffers();
+    void Loop();
+    void Process(Job* job);
+    void OpenFile(const Job* job);
+    void CloseFile();
+
+    /// Throws the error of the writer thread, if there was one
+    void CheckWriter() const;
+
+    EnergyHistogram* m_energyHistogram;
+    G4String m_outputFileName;
+
+    G4bool m_enabled = false;
+    G4bool m_perRun = false;
+    G4int m_queueSize = 64;
+    std::atomic<G4int> m_runID{0};
+
+    vector<Cell> m_cells;
+    size_t m_mask = 0;
+    std::atomic<size_t> m_pushPosition{0};
+    std::atomic<size_t> m_popPosition{0};
+    std::atomic<long> m_stalls{0};
+
+    // spectra at the start of the run, subtracted from the run file
+    vector<unique_ptr<TH1D>> m_runStart;
+
+    std::thread m_thread;
+    std::atomic<G4bool> m_failed{false};
+    G4String m_error;
+    G4Mutex m_buffersMutex = G4MUTEX_INITIALIZER;
+    vector<unique_ptr<Buffer>> m_buffers;
+
+    // used by the writer thread only
+    G4String m_fileName;
+    TFile* m_file = nullptr;
+    TTree* m_tree = nullptr;
+    G4double m_energy = 0;
+    G4bool m_outputFileWritten = false;
+
+    shared_ptr<G4UIcmdWithABool> m_asyncCmd;
+    shared_ptr<G4UIcmdWithABool> m_perRunCmd;
+    shared_ptr<G4UIcmdWithAnInteger> m_queueSizeCmd;
+};
+
+#endif // AsyncWriter_hh
@@ -28,11 +28,39 @@
 #define BiasedRDPhysics_h 1
 
 #include "G4VPhysicsConstructor.hh"
+#include "G4UImessenger.hh"
 
+#include <memory>
+using std::shared_ptr;
 
 class G4Radioactivation;
+class G4UIcmdWithABool;
+class G4UIcmdWithAString;
 
-class BiasedRDPhysics : public G4VPhysicsConstructor
+/// Radioactive decay with the variance reduction of G4Radioactivation,
+/// configured before /run/initialize:
+///
+///     /BiasedRD/branchingRatioBias true    all branches equally likely
+///     /BiasedRD/nucleusLimits 1 140 1 60   only nuclei in Amin Amax Zmin Zmax decay
+///     /BiasedRD/sourceTimeProfile file     time profile of the source
+///     /BiasedRD/decayBiasProfile file      decay time windows
+///
+/// The decay products carry the weights, which end up in the weighted
+/// spectrum "h1w". Without any of these commands the decays are analogue.
+///
+/// The splitting of G4Radioactivation is not offered: the copies of a decay
+/// are tracked in the same event, so their deposits would be summed like a
+/// coincidence instead of counting as independent decays.
+///
+/// An event has one weight, the mean of the weights of its deposits weighted
+/// by their energy (EventAction). It is exact when all deposits of an event
+/// carry the same weight, e.g. the biased decay of a single nucleus. When a
+/// chain of several biased decays deposits in the same event, the deposits
+/// of the later decays carry products of the weights, and the mean is only
+/// an approximation: limit the chain with /BiasedRD/nucleusLimits or the
+/// DecayChainLimits (/DecayChain/) so that every event holds one decay.
+
+class BiasedRDPhysics : public G4VPhysicsConstructor, public G4UImessenger
 {
   public: 
     BiasedRDPhysics(G4int verbose = 1);
@@ -47,6 +75,20 @@ class BiasedRDPhysics : public G4VPhysicsConstructor
     // registered to the process manager of each particle type 
     virtual void ConstructProcess();
 
+    void SetNewValue(G4UIcommand* command, G4String newValue);
+
+  private:
+    G4bool IsBiased() const;
+
+    G4bool m_branchingRatioBias = false;
+    G4int m_aMin = 0, m_aMax = 0, m_zMin = 0, m_zMax = 0;
+    G4String m_sourceTimeProfile;
+    G4String m_decayBiasProfile;
+
+    shared_ptr<G4UIcmdWithABool> m_branchingRatioBiasCmd;
+    shared_ptr<G4UIcmdWithAString> m_nucleusLimitsCmd;
+    shared_ptr<G4UIcmdWithAString> m_sourceTimeProfileCmd;
+    shared_ptr<G4UIcmdWithAString> m_decayBiasProfileCmd;
 };
 
 #endif
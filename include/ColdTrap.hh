@@ -12,6 +12,8 @@ class ColdTrap : public GeometryObject {
         G4VPhysicalVolume *Construct();
         void ConstructSDandField() {};
 
+        G4VSolid *ConstructHull();
+
         virtual void SetNewValue(G4UIcommand* command, G4String value);
 
     private:
@@ -0,0 +1,55 @@
+#ifndef DeadLayerRecord_hh
+#define DeadLayerRecord_hh
+
+#include "globals.hh"
+
+#include <map>
+using std::map;
+#include <vector>
+using std::vector;
+
+/// Per-event record of the energy deposited in the whole Ge crystal, binned
+/// by the depth below each of the four crystal surfaces that carry a dead
+/// layer (front, outside, inside, back).
+///
+/// The depth of a deposit below a surface is the thickness that the dead
+/// layer on that surface would need to make the deposit inactive. The four
+/// depth bins are packed into one 32-bit key (8 bits each, front in the
+/// lowest byte). Bin k covers [k, k+1) bin widths, the last bin (255) holds
+/// everything deeper. Deposits with the same key are summed, so most events
+/// only need a handful of entries.
+///
+/// A deposit counts as active for dead layers (f, o, i, b) if all its depth
+/// bins are at least (f, o, i, b) divided by the bin width.
+
+class DeadLayerRecord
+{
+public:
+    enum {surfaceFront, surfaceOutside, surfaceInside, surfaceBack, nSurfaces};
+
+    static const unsigned int nDepthBins = 256;
+
+    DeadLayerRecord() {}
+    ~DeadLayerRecord() {}
+
+    void SetBinWidth(G4double binWidth) {m_binWidth = binWidth;}
+    G4double GetBinWidth() const {return m_binWidth;}
+
+    void Clear() {m_deposits.clear();}
+    G4bool IsEmpty() const {return m_deposits.empty();}
+
+    void Add(const G4double depths[nSurfaces], G4double edep);
+
+    void GetEntries(vector<unsigned int> &keys, vector<float> &edeps) const;
+
+    static unsigned int GetDepthBin(unsigned int key, G4int surface)
+    {
+        return (key >> (8*surface)) & 0xFF;
+    }
+
+private:
+    G4double m_binWidth = 0.0;
+    map<unsigned int, G4double> m_deposits;
+};
+
+#endif // DeadLayerRecord_hh
@@ -0,0 +1,79 @@
+#ifndef DecayChainLimits_hh
+#define DecayChainLimits_hh
+
+#include "G4UImessenger.hh"
+#include "G4AutoLock.hh"
+#include "globals.hh"
+
+#include <map>
+using std::map;
+#include <memory>
+using std::shared_ptr;
+
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAnInteger;
+
+/// Ends radioactive decay chains that leave the acquisition window.
+///
+/// The StackingAction kills all products of decays that happen later than
+/// the time window after the first decay of the event (usually that of the
+/// primary nuclide, whose own lifetime does not matter), or that are deeper
+/// in the chain than the maximum depth. The depth counts the changes of the
+/// nuclide: the decay of the primary nuclide has depth 1, and the
+/// de-excitation of the levels it populates keeps that depth. The cut decays
+/// are counted per decaying nuclide and listed at the end of the run. Both
+/// limits are off by default.
+///
+///     /DecayChain/timeWindow 10 us
+///     /DecayChain/maxDepth 1
+///
+/// keeps, for example, both Ni-60 gammas of Co-60 and no later decays.
+
+class DecayChainLimits : public G4UImessenger
+{
+public:
+    DecayChainLimits();
+    virtual ~DecayChainLimits() {}
+
+    void SetNewValue(G4UIcommand* command, G4String newValue);
+
+    G4bool IsEnabled() const
+    {
+        return m_timeWindow > 0 || m_maxDepth > 0;
+    }
+
+    G4bool IsOutsideTimeWindow(const G4double delay) const
+    {
+        return m_timeWindow > 0 && delay > m_timeWindow;
+    }
+
+    G4bool IsTooDeep(const G4int depth) const
+    {
+        return m_maxDepth > 0 && depth > m_maxDepth;
+    }
+
+    // Called by the stacking actions of all threads for every cut decay
+    void AddCut(const G4String& nuclide, const G4bool byTime);
+
+    // Called by the master at the beginning and the end of every run
+    void BeginOfRun();
+    void EndOfRun();
+
+private:
+    struct Cuts
+    {
+        G4long byTime = 0;
+        G4long byDepth = 0;
+    };
+
+    G4double m_timeWindow = 0;
+    G4int m_maxDepth = 0;
+
+    G4Mutex m_mutex = G4MUTEX_INITIALIZER;
+    map<G4String, Cuts> m_cuts;
+
+    shared_ptr<G4UIcmdWithADoubleAndUnit> m_timeWindowCmd;
+    shared_ptr<G4UIcmdWithAnInteger> m_maxDepthCmd;
+};
+
+#endif // DecayChainLimits_hh
@@ -4,8 +4,12 @@
 #include "G4VUserDetectorConstruction.hh"
 #include "globals.hh"
 
+#include <vector>
+using std::vector;
+
 class G4VPhysicalVolume;
 class G4LogicalVolume;
+class GeometryObject;
 class HPGeDetector;
 class TargetHolderC12;
 class TargetChamberC12;
@@ -18,6 +22,9 @@ public:
     DetectorConstruction();
     virtual ~DetectorConstruction();
 
+    /// Builds the world and all geometry objects on the first call. Later
+    /// calls (after /run/reinitializeGeometry) only rebuild the objects that
+    /// were modified since and return the same world.
     virtual G4VPhysicalVolume* Construct();
 
     G4LogicalVolume* GetScoringVolume() const
@@ -25,13 +32,42 @@ public:
         return m_scoringVolume;
     }
 
+    HPGeDetector* GetHPGeDetector() const
+    {
+        return m_hpgeDetector;
+    }
+
+    /// Geometry object by name, nullptr if there is none
+    GeometryObject* GetGeometryObject(const G4String& name) const;
+
+    const vector<GeometryObject*>& GetGeometryObjects() const
+    {
+        return m_geometryObjects;
+    }
+
+    /// Null before the geometry is constructed
+    G4VPhysicalVolume* GetWorldVolume() const
+    {
+        return m_worldPhysical;
+    }
+
+    /// Incremented whenever the geometry is (re)built, to invalidate cached volumes
+    G4int GetGeometryVersion() const
+    {
+        return m_geometryVersion;
+    }
+
 protected:
     HPGeDetector *m_hpgeDetector = nullptr;
     TargetHolderC12 *m_targetHolder = nullptr;
     TargetChamberC12 *m_targetChamber = nullptr;
     ColdTrap *m_coldTrap = nullptr;
 
+    vector<GeometryObject*> m_geometryObjects;
+
+    G4VPhysicalVolume* m_worldPhysical = nullptr;
     G4LogicalVolume* m_scoringVolume = nullptr;
+    G4int m_geometryVersion = 0;
 };
 
 #endif // #ifndef DetectorConstruction_hh
@@ -0,0 +1,111 @@
+#ifndef EfficiencyMap_hh
+#define EfficiencyMap_hh
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+#include <cmath>
+#include <map>
+using std::map;
+#include <memory>
+using std::shared_ptr;
+#include <utility>
+using std::pair;
+#include <vector>
+using std::vector;
+
+class G4UIcmdWithAString;
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAnInteger;
+
+class EnergyHistogram;
+
+/// Maps the full-energy-peak efficiency over the (x, y) position of the
+/// source within one process, refining the grid only where needed.
+///
+/// The map starts from a coarse grid of cells. A cell is split into four
+/// while the efficiencies at its corners differ by more than the gradient
+/// threshold (relative to their mean) and by more than twice their
+/// uncertainty, as long as the refinement depth allows it.
+/// Points whose efficiency is less precise than the uncertainty threshold
+/// are simulated again and the runs are combined. With /RunControl/precision
+/// the runs of every point also stop early.
+///
+/// The source is moved with a command template in which "xxx" and "yyy" are
+/// replaced by the coordinates, given in the unit of the template (as in
+/// analysis/Run.py):
+///
+///     /EfficiencyMap/positionCommand /PrimaryGenerator/GammaDecayScheme/position xxx yyy -2.1 cm
+///     /EfficiencyMap/region -3 3 -3 3
+///     /EfficiencyMap/line 7556 keV
+///     /EfficiencyMap/run 1000000
+///
+/// The result is written as a tree "map" of the irregular points (x, y,
+/// efficiency, error, events, depth), a TGraph2D "efficiency" that
+/// interpolates between them (Delaunay) and a histogram "efficiency_grid"
+/// sampled from it on a regular grid with the finest cell size.
+
+class EfficiencyMap : public G4UImessenger
+{
+public:
+    EfficiencyMap(EnergyHistogram* energyHistogram);
+    virtual ~EfficiencyMap() {}
+
+    void SetNewValue(G4UIcommand* command, G4String newValue);
+
+private:
+    struct Point
+    {
+        G4double net = 0;
+        G4double variance = 0;
+        G4double events = 0;
+        G4int depth = 0;
+
+        G4double GetEfficiency() const {return events > 0 ? net/events : 0;}
+        G4double GetError() const {return events > 0 ? std::sqrt(variance)/events : 0;}
+    };
+
+    // Points are addressed on the lattice of the finest cells
+    typedef pair<G4int, G4int> Node;
+
+    void Run(G4int eventsPerPoint);
+
+    // Simulates the point (again, if the precision is not reached yet)
+    const Point& Evaluate(const Node& node, G4int depth, G4int eventsPerPoint);
+    void Simulate(const Node& node, Point& point, G4int events);
+
+    G4double GetX(const Node& node) const;
+    G4double GetY(const Node& node) const;
+
+    void Write() const;
+
+    EnergyHistogram* m_energyHistogram;
+
+    G4String m_positionCommand;
+    G4double m_xMin = -3, m_xMax = 3, m_yMin = -3, m_yMax = 3;
+    G4int m_coarseCells = 4;
+    G4int m_maxDepth = 3;
+    G4double m_line = 0;
+    G4double m_peakHalfWidth;
+    G4double m_gradientThreshold = 0.02;
+    G4double m_uncertaintyThreshold = 0.01;
+    G4int m_maxRepeats = 3;
+    G4String m_fileName = "./map.root";
+
+    map<Node, Point> m_points;
+
+    shared_ptr<G4UIcmdWithAString> m_positionCommandCmd;
+    shared_ptr<G4UIcmdWithAString> m_regionCmd;
+    shared_ptr<G4UIcmdWithAnInteger> m_coarseCellsCmd;
+    shared_ptr<G4UIcmdWithAnInteger> m_maxDepthCmd;
+    shared_ptr<G4UIcmdWithADoubleAndUnit> m_lineCmd;
+    shared_ptr<G4UIcmdWithADoubleAndUnit> m_peakHalfWidthCmd;
+    shared_ptr<G4UIcmdWithADouble> m_gradientThresholdCmd;
+    shared_ptr<G4UIcmdWithADouble> m_uncertaintyThresholdCmd;
+    shared_ptr<G4UIcmdWithAnInteger> m_maxRepeatsCmd;
+    shared_ptr<G4UIcmdWithAString> m_fileNameCmd;
+    shared_ptr<G4UIcmdWithAnInteger> m_runCmd;
+};
+
+#endif // EfficiencyMap_hh
@@ -0,0 +1,57 @@
+#ifndef EmissionBias_hh
+#define EmissionBias_hh
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <memory>
+using std::shared_ptr;
+#include <vector>
+using std::vector;
+
+/// Samples the emission directions of the sources from an importance map
+/// over the directions instead of isotropically, with weights that keep the
+/// spectra unbiased (h1w holds the weighted spectrum).
+///
+/// The directions are divided into nCosTheta x nPhi cells of equal solid
+/// angle. A cell is chosen with probability
+///
+///     q = (1 - mixture) importance/sum + mixture/nCells
+///
+/// and the direction is uniform within it, the weight is (1/nCells)/q. The
+/// uniform part (mixture > 0) keeps every direction possible, so the result
+/// stays correct even if the map belongs to another source position.
+///
+/// The map in use is shared by all threads and set on the master between
+/// runs (RayTraceEstimator, /RayTrace/bias). The IsotropicGun and
+/// GammaDecayScheme generators take their directions from SampleDirection().
+
+class EmissionBias
+{
+public:
+    EmissionBias(G4int nCosTheta, G4int nPhi, const vector<G4double>& importance, G4double mixture);
+
+    /// Direction of one particle, its weight is multiplied into weight
+    G4ThreeVector Sample(G4double& weight) const;
+
+    /// Direction from the current map, isotropic (weight 1) without one
+    static G4ThreeVector SampleDirection(G4double& weight);
+
+    static shared_ptr<const EmissionBias> GetCurrent();
+    static void SetCurrent(const shared_ptr<const EmissionBias>& bias);
+
+    /// Direction within cell i*nPhi + j, which covers cos(theta) in
+    /// [-1 + 2i/nCosTheta, -1 + 2(i+1)/nCosTheta) and phi in
+    /// [2 pi j/nPhi, 2 pi (j+1)/nPhi); u and v in [0, 1) place it in the cell
+    static G4ThreeVector GetDirection(G4int nCosTheta, G4int nPhi, G4int cell, G4double u, G4double v);
+
+private:
+    G4int m_nCosTheta;
+    G4int m_nPhi;
+    vector<G4double> m_cumulative;
+    vector<G4double> m_weights;
+
+    static shared_ptr<const EmissionBias> s_current;
+};
+
+#endif // EmissionBias_hh
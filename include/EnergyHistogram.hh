@@ -6,10 +6,18 @@
 #include "TTree.h"
 #include "TH1D.h"
 
+#include "DeadLayerRecord.hh"
+
+#include <memory>
+using std::unique_ptr;
 #include <string>
 using std::string;
+#include <vector>
+using std::vector;
 #include <fstream>
 using std::ofstream;
+#include <map>
+using std::map;
 
 class EnergyHistogram
 {
@@ -18,7 +26,21 @@ public:
     ~EnergyHistogram();
 
     void Reset();
-    void Fill(const double value);
+
+    /// Fills the energy of one event. The spectrum "h1" counts events, the
+    /// weighted spectrum "h1w" is only created once the first event with a
+    /// weight other than 1 arrives (variance reduction).
+    void Fill(const double value, const double weight = 1);
+
+    /// Fills the spectrum "h1_<component>" of the component of a composite
+    /// source (CompositeGen) that generated the event, created with its
+    /// first event. Filled with the event weight like "h1w";
+    /// AdjointSimulation fills its spectra here as well.
+    void FillComponent(const string& component, const double value, const double weight = 1);
+
+    /// Stores the depth record of one event in the "dl" tree, which is only
+    /// created once the first record arrives.
+    void FillDeadLayerRecord(const DeadLayerRecord& record);
 
     int GetNbins() const
     {
@@ -35,7 +57,72 @@ public:
         return m_Emax;
     }
 
-    void Write(const string fileName) const;
+    const TH1D* GetHistogram() const
+    {
+        return h1;
+    }
+
+    /// Null as long as all events had unit weight
+    const TH1D* GetWeightedHistogram() const
+    {
+        return h1w;
+    }
+
+    /// Spectrum of a component of a composite source, null before its first event
+    const TH1D* GetComponentHistogram(const string& component) const
+    {
+        const auto histogram = m_components.find(component);
+        return (histogram != m_components.end()) ? histogram->second : nullptr;
+    }
+
+    /// Names of the components that have a spectrum
+    void GetComponentNames(vector<string>& components) const
+    {
+        components.clear();
+        for (const auto& component : m_components)
+        {
+            components.push_back(component.first);
+        }
+    }
+
+    /// Bin of the spectrum that holds energy
+    int FindBin(const double energy) const;
+
+    /// Sum of the bins [firstBin, lastBin] (clipped to the histogram),
+    /// safe to call while other threads fill.
+    double Integral(int firstBin, int lastBin);
+
+    /// Net counts of the full-energy peak at energy and their uncertainty:
+    /// the counts within energy +- halfWidth minus a linear background from
+    /// two side bands of the same width.
+    void GetPeak(const double energy, const double halfWidth, double& net, double& sigma);
+
+    /// Copies the contents of all bins including underflow and overflow
+    /// (nBins+2 values) and the number of entries.
+    void GetContents(vector<double>& contents, double& entries);
+
+    /// Copies of "h1", "h1w" and the component spectra that belong to no file
+    void CloneHistograms(vector<unique_ptr<TH1D>>& histograms);
+
+    /// Adds spectra named like those of CloneHistograms() (e.g. read back from
+    /// a file), creating "h1w" and the component spectra where needed
+    void Add(const vector<unique_ptr<TH1D>>& histograms);
+
+    /// Accounts for a two-tier run (TwoTierRun) that screened screened events
+    /// and replayed replayed of them: the entries of "h1" and "h1w" count the
+    /// screened events, and their number is written as "screenedEvents".
+    void AddScreenedEvents(const long screened, const long replayed);
+
+    /// Whether Fill() stores the events in the in-memory tree "t1"; off
+    /// while the AsyncWriter streams them into a file instead.
+    void SetFillTree(const bool fillTree)
+    {
+        m_fillTree = fillTree;
+    }
+
+    /// Writes everything into fileName, which is added to with update
+    /// (where the AsyncWriter wrote the tree before)
+    void Write(const string fileName, const bool update = false) const;
 
 private:
     const int m_nBins;
@@ -44,9 +131,19 @@ private:
     G4Mutex m_mutex = G4MUTEX_INITIALIZER;
 
     double Energy = 0;
+    bool m_fillTree = true;
 
     TH1D* h1;
+    TH1D* h1w = nullptr;
     TTree* t1;
+    map<string, TH1D*> m_components;
+
+    vector<unsigned int> m_dlKeys;
+    vector<float> m_dlEdeps;
+    double m_dlBinWidth = 0;
+    TTree* dl = nullptr;
+
+    long m_screenedEvents = 0;
 
 };
 
@@ -4,26 +4,48 @@
 #include "G4UserEventAction.hh"
 #include "globals.hh"
 
+#include "AsyncWriter.hh"
 #include "EnergyHistogram.hh"
+#include "DeadLayerRecord.hh"
+#include "PhaseSpaceRecorder.hh"
+
+class RunControl;
 
 
 class EventAction : public G4UserEventAction
 {
 public:
-    EventAction(EnergyHistogram* energyHistogram);
+    EventAction(EnergyHistogram* energyHistogram, RunControl* runControl,
+                PhaseSpaceRecorder::Writer* phaseSpaceWriter, AsyncWriter::Buffer* outputBuffer);
     virtual ~EventAction();
 
     virtual void BeginOfEventAction(const G4Event* /*event*/);
     virtual void EndOfEventAction(const G4Event* /*event*/);
 
-    void AddEdep(const G4double edep)
+    void AddEdep(const G4double edep, const G4double weight = 1)
     {
         m_Edep += edep;
+        m_weightedEdep += weight*edep;
+    }
+
+    void AddDepthDeposit(const G4double depths[4], const G4double edep);
+
+    /// A particle of the event reached the crystal (two-tier screening)
+    void SetNearDetector()
+    {
+        m_nearDetector = true;
     }
 
 private:
     EnergyHistogram* m_energyHistogram = nullptr;
+    RunControl* m_runControl = nullptr;
+    PhaseSpaceRecorder::Writer* m_phaseSpaceWriter = nullptr;
+    AsyncWriter::Buffer* m_outputBuffer = nullptr;
     G4double m_Edep = 0.0;
+    G4double m_weightedEdep = 0.0;
+    G4bool m_nearDetector = false;
+
+    DeadLayerRecord m_deadLayerRecord;
 };
 
 #endif // #ifndef EventAction_hh
@@ -11,6 +11,7 @@
 
 #include "G4UIdirectory.hh"
 #include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADouble.hh"
 #include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UIcmdWith3VectorAndUnit.hh"
 #include "G4UIcmdWithAString.hh"
@@ -19,10 +20,14 @@
     using std::map;
 #include <set>
     using std::set;
+#include <vector>
+    using std::vector;
 #include <stdexcept>
     using std::runtime_error;
 
 class G4PVPlacement;
+class G4Material;
+class G4VSolid;
 
 class GeometryObject : public G4VUserDetectorConstruction, public G4UImessenger {
 
@@ -33,6 +38,45 @@ class GeometryObject : public G4VUserDetectorConstruction, public G4UImessenger
         G4String GetName() {return m_name;}
 
         virtual void Build();
+
+        // Removes all volumes placed by this object from their mothers and
+        // deletes them and the solids created in Build(), so that the object
+        // can be built again.
+        void Clear();
+
+        // True if a command changed the object since it was last built
+        G4bool IsModified() {return m_modified;}
+
+        // Level of detail: the full model, a simplified model (objects that
+        // do not provide one build the full model) or a single volume of
+        // the object's hull filled with a homogenized material of the same
+        // mass.
+        enum Detail {detailFull, detailSimplified, detailHomogenized};
+
+        Detail GetDetail() {return m_detail;}
+        void SetDetail(Detail detail);
+
+        // False for objects that can only be built in full
+        G4bool HasDetail() {return m_cmdDetail != nullptr;}
+
+        static G4String GetDetailName(Detail detail);
+        static G4bool GetDetailFromName(const G4String &name, Detail &detail);
+
+        G4double GetDimension(G4String name);
+        void SetDimension(G4String name, G4double value);
+
+        G4ThreeVector GetPosition() {return m_position;}
+        G4RotationMatrix *GetRotation() {return m_rotation;}
+
+        // Changes position and rotation without marking the object as
+        // modified; UpdatePlacement() applies them to the built volumes.
+        void SetPlacement(const G4ThreeVector &position, const G4RotationMatrix &rotation);
+
+        // Moves the already built volumes to the current placement and
+        // re-voxelizes only their mother volumes. Returns false if
+        // checkOverlaps is set and a moved volume overlaps.
+        G4bool UpdatePlacement(G4bool checkOverlaps = false);
+
         virtual G4VPhysicalVolume *Construct() = 0;
         virtual void ConstructSDandField() = 0;
 
@@ -42,9 +86,6 @@ class GeometryObject : public G4VUserDetectorConstruction, public G4UImessenger
 
 
     protected:
-        G4ThreeVector GetPosition() {return m_position;}
-        G4RotationMatrix *GetRotation() {return m_rotation;}
-
         G4Transform3D GetTransform3D(G4RotationMatrix ownRotation, G4ThreeVector relativePosition);
 
         const char *CreateSolidName(G4String inName) {
@@ -65,14 +106,70 @@ class GeometryObject : public G4VUserDetectorConstruction, public G4UImessenger
         virtual void SetNewValue(G4UIcommand* command, G4String value);
 
         void RegisterDimension(G4String name, G4double defaultValue);
-        G4double GetDimension(G4String name);
-        void SetDimension(G4String name, G4double value);
+
+        void SetModified() {m_modified = true;}
+
+        // Removes the detail command, the object is always built in full
+        void DisableDetail();
+
+        // Solid in the frame of the object that encloses all its volumes,
+        // used for the homogenized level of detail. The default (nullptr)
+        // is the bounding box, objects that surround others (e.g. a beam
+        // pipe) have to keep the space of the others free.
+        virtual G4VSolid *ConstructHull() {return nullptr;}
+
+        // Materials shared by several objects, built only once
+        static G4Material *GetSteel316();
 
         void CheckForUnusedDimensions();
 
     private:
         G4String m_name;
         G4bool m_enable = false;
+        G4bool m_modified = true;
+
+        // build inside a tight box, so the mother only sees one daughter
+        G4bool m_useEnvelope = false;
+        G4double m_smartless = -1;
+
+        Detail m_detail = detailFull;
+
+        // materials cannot be deleted, the homogenized ones are reused when
+        // a rebuild gives the same mixture
+        struct HomogenizedMaterial {
+            map<G4Material*, G4double> fractions;
+            G4double density;
+            G4Material *material;
+        };
+        vector<HomogenizedMaterial> m_homogenizedMaterials;
+        G4Material *GetHomogenizedMaterial(const map<G4Material*, G4double> &fractions, G4double density);
+
+        void BuildInEnvelope();
+        void BuildHomogenized();
+
+        // Bounding box of all daughters of volume in its frame
+        static void GetDaughterLimits(G4LogicalVolume *volume, G4ThreeVector &lower, G4ThreeVector &upper);
+
+        // Adds the masses of the materials in volume and all its daughters
+        static void AddMaterialMasses(G4LogicalVolume *volume, map<G4Material*, G4double> &masses);
+
+        vector<G4VPhysicalVolume*> m_placedVolumes;
+
+        // solids created by the last Build(), found as the new entries of
+        // the solid store
+        set<G4VSolid*> m_solids;
+        set<G4VSolid*> m_solidsBeforeBuild;
+        void TrackNewSolids();
+
+        // volumes placed relative to the object's position and rotation
+        struct Placement {
+            G4VPhysicalVolume *volume;
+            G4RotationMatrix ownRotation;
+            G4ThreeVector relativePosition;
+        };
+        vector<Placement> m_placements;
+        // rotations for volumes that were placed without one
+        vector<G4RotationMatrix*> m_placementRotations;
 
         G4LogicalVolume *m_motherVolume = nullptr;
 
@@ -87,6 +184,9 @@ class GeometryObject : public G4VUserDetectorConstruction, public G4UImessenger
         G4UIcmdWithADoubleAndUnit* m_cmdRotateX;
         G4UIcmdWithADoubleAndUnit* m_cmdRotateY;
         G4UIcmdWithADoubleAndUnit* m_cmdRotateZ;
+        G4UIcmdWithABool* m_cmdEnvelope;
+        G4UIcmdWithADouble* m_cmdSmartless;
+        G4UIcmdWithAString* m_cmdDetail;
 
         map<G4String, G4double> m_dimensions;
         set<G4String> m_unusedDimensions;
@@ -5,6 +5,8 @@
 
 class G4MultiFunctionalDetector;
 class G4VPrimitiveScorer;
+class G4GenericPolycone;
+class G4VSolid;
 
 #include "CLHEP/Units/SystemOfUnits.h"
     using CLHEP::um;
@@ -12,9 +14,14 @@ class G4VPrimitiveScorer;
 
 #include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithABool.hh"
 
 #include <map>
     using std::map;
+#include <memory>
+    using std::shared_ptr;
+#include <vector>
+    using std::vector;
 
 class HPGeDetector : public GeometryObject
 {
@@ -27,8 +34,66 @@ class HPGeDetector : public GeometryObject
 
         G4LogicalVolume *GetScoringVolume() {return m_scoringVolume;}
 
+        // Full crystal (active volume and dead layers)
+        G4LogicalVolume *GetCrystalVolume() {return m_crystalVolume;}
+
+        // Bin width of the per-event dead-layer depth records, 0 if disabled
+        G4double GetDepthRecordBinWidth() const {return m_depthRecordBinWidth;}
+
+        // Depths of a point (in the frame of the full crystal) below the front,
+        // outside, inside and back surface, i.e. the dead layer thicknesses
+        // that would make the point inactive.
+        void GetDeadLayerDepths(const G4ThreeVector &position, G4double depths[4]) const;
+
+        virtual void SetNewValue(G4UIcommand* command, G4String value);
+
     private:
         G4LogicalVolume *m_scoringVolume = nullptr;
+        G4LogicalVolume *m_crystalVolume = nullptr;
+
+        shared_ptr<G4UIcmdWithADoubleAndUnit> m_depthRecordCmd;
+        G4double m_depthRecordBinWidth = 0.0;
+
+        // Crystal shape, see /Geometry/HPGeDetector/crystalShape
+        enum {crystalBoolean, crystalPolycone} m_crystalShape = crystalBoolean;
+        G4double m_roundedEdgeTolerance = 1*um;
+        G4bool m_validateCrystal = false;
+
+        shared_ptr<G4UIcmdWithAString> m_crystalShapeCmd;
+        shared_ptr<G4UIcmdWithADoubleAndUnit> m_roundedEdgeToleranceCmd;
+        shared_ptr<G4UIcmdWithABool> m_validateCrystalCmd;
+
+        // Rotationally symmetric model of the full or active crystal, in the
+        // frame of its cylindrical part
+        struct CrystalModel {
+            G4double outerRadius;
+            G4double backHeight;        // length of the cylindrical part
+            G4double edgeRadius;
+            G4double zFrontCut;         // front face (front dead layer cut)
+            G4double holeRadius;
+            G4double holeCenterDepth;   // depth of the center of the half sphere
+        };
+
+        CrystalModel GetCrystalModel(G4bool active);
+        static G4double GetCrystalModelVolume(const CrystalModel &model);
+
+        void ConstructBooleanCrystal(G4VSolid* &fullDetectorSolid, G4VSolid* &activeDetectorSolid);
+        void ConstructPolyconeCrystal(G4VSolid* &fullDetectorSolid, G4VSolid* &activeDetectorSolid);
+
+        void AddArc(vector<G4double> &r, vector<G4double> &z,
+                    G4double rCenter, G4double zCenter, G4double radius,
+                    G4double angleFrom, G4double angleTo) const;
+        G4GenericPolycone* CreateCrystalProfile(G4String name, const CrystalModel &model);
+        static G4double GetProfileVolume(const G4GenericPolycone *solid);
+
+        void PrintCrystalValidation(G4VSolid *fullDetectorSolid, G4VSolid *activeDetectorSolid, G4double density);
+
+        // Crystal dimensions, cached at construction for use on the worker threads
+        G4double m_crystalRadius = 0.0;
+        G4double m_crystalBackHeight = 0.0;
+        G4double m_crystalEdgeRadius = 0.0;
+        G4double m_holeRadius = 0.0;
+        G4double m_holeDepth = 0.0;
 };
 
 #endif // HPGeDetector_hh
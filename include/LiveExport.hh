@@ -0,0 +1,109 @@
+#ifndef LiveExport_hh
+#define LiveExport_hh
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+using std::shared_ptr;
+#include <mutex>
+#include <thread>
+#include <vector>
+using std::vector;
+
+class G4UIcmdWithAString;
+class G4UIcmdWithADoubleAndUnit;
+
+class EnergyHistogram;
+
+/// Publishes the spectrum during the run into a memory-mapped file, so that
+/// a separate process (e.g. analysis/LiveView.py) can follow long runs.
+///
+/// While a run is going on, a thread of the master copies the shared
+/// spectrum every interval and writes it into the file; the fill path of
+/// the workers is not changed. The file keeps the last snapshot after the
+/// run. Layout (native byte order, i.e. little endian on x86):
+///
+///     offset  type        content
+///          0  char[8]     magic "G4HPGeLV"
+///          8  uint32      version (1)
+///         12  uint32      nBins
+///         16  uint64      sequence number (seqlock, odd while writing)
+///         24  float64     Emin [MeV]
+///         32  float64     Emax [MeV]
+///         40  uint64      run ID
+///         48  float64     events
+///         56  float64     event rate since the last update [1/s]
+///         64  float64     time since the start of the run [s]
+///         72  float64     time of the update [s since the epoch]
+///         80  float64[nBins+2]  underflow, bins, overflow
+///
+/// Readers never block the writer: read the sequence number, skip if it is
+/// odd, copy everything and accept the copy only if the sequence number is
+/// still the same.
+///
+///     /LiveExport/fileName /dev/shm/G4_HPGe.live
+///     /LiveExport/interval 2 s
+
+class LiveExport : public G4UImessenger
+{
+public:
+    LiveExport(EnergyHistogram* energyHistogram);
+    virtual ~LiveExport();
+
+    void SetNewValue(G4UIcommand* command, G4String newValue);
+
+    // Called by the master at the beginning and the end of every run
+    void BeginOfRun(G4int runID);
+    void EndOfRun();
+
+private:
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t nBins;
+        std::atomic<uint64_t> sequence;
+        double Emin;
+        double Emax;
+        uint64_t runID;
+        double events;
+        double rate;
+        double runTime;
+        double updateTime;
+    };
+
+    void Open();
+    void Close();
+
+    void Loop();
+    void Publish();
+
+    EnergyHistogram* m_energyHistogram;
+
+    G4String m_fileName;
+    G4double m_interval;
+
+    void* m_map = nullptr;
+    size_t m_mapSize = 0;
+
+    std::thread m_thread;
+    std::mutex m_threadMutex;
+    std::condition_variable m_wakeUp;
+    G4bool m_stop = false;
+
+    vector<double> m_contents;
+    uint64_t m_runID = 0;
+    std::chrono::steady_clock::time_point m_startTime;
+    std::chrono::steady_clock::time_point m_lastTime;
+    double m_lastEvents = 0;
+
+    shared_ptr<G4UIcmdWithAString> m_fileNameCmd;
+    shared_ptr<G4UIcmdWithADoubleAndUnit> m_intervalCmd;
+};
+
+#endif // LiveExport_hh
@@ -0,0 +1,114 @@
+#ifndef PhaseSpaceRecorder_hh
+#define PhaseSpaceRecorder_hh
+
+#include "G4UImessenger.hh"
+#include "G4AutoLock.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include "generator/EventFileGun/EventFileFormat.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+using std::shared_ptr;
+using std::unique_ptr;
+#include <vector>
+using std::vector;
+
+class G4Step;
+class G4UIcmdWithAString;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWith3VectorAndUnit;
+
+/// Records the particles leaving a cylinder around the target region into an
+/// event file, which the EventFileGun replays into other setups (first stage
+/// of a two-stage simulation).
+///
+/// The cylinder is parallel to the z axis (the beam axis). A particle is
+/// recorded (position on the surface, direction, energy, time and weight)
+/// and killed when it leaves the cylinder, so the first stage never
+/// transports anything outside. The cylinder must contain the source and
+/// everything that is the same in all setups, and nothing else. Every source
+/// event becomes one event of the file, also if nothing left the cylinder,
+/// so that N replayed events correspond to N source events.
+///
+///     /PhaseSpace/center 0 0 -37.5 mm
+///     /PhaseSpace/radius 40 mm
+///     /PhaseSpace/halfLength 32.5 mm
+///     /PhaseSpace/file target.evt
+///     /run/beamOn 10000000
+///
+/// Every thread writes its part into a temporary file, the master combines
+/// them into the event file at the end of the run.
+
+class PhaseSpaceRecorder : public G4UImessenger
+{
+public:
+    /// Per-thread part of the phase space
+    class Writer
+    {
+    public:
+        Writer(const PhaseSpaceRecorder* recorder, const G4int index);
+        ~Writer();
+
+        /// Records and kills the track if the step leaves the cylinder
+        void Step(const G4Step* step);
+        void EndOfEvent();
+
+    private:
+        friend class PhaseSpaceRecorder;
+
+        void Open();
+        void Close();
+
+        const PhaseSpaceRecorder* m_recorder;
+        const G4int m_index;
+        G4String m_fileName;
+        FILE* m_file = nullptr;
+
+        // primaries of the current event and of all finished events
+        uint64_t m_primaries = 0;
+        vector<uint64_t> m_eventPrimaries;
+    };
+
+    PhaseSpaceRecorder();
+    virtual ~PhaseSpaceRecorder();
+
+    void SetNewValue(G4UIcommand* command, G4String newValue);
+
+    G4bool IsEnabled() const
+    {
+        return !m_fileName.empty();
+    }
+
+    /// Writer of the calling (worker) thread, owned by the recorder
+    Writer* CreateWriter();
+
+    // Called by the master at the beginning and the end of every run
+    void BeginOfRun();
+    void EndOfRun();
+
+private:
+    G4String m_fileName;
+    G4bool IsInside(const G4ThreeVector& position) const
+    {
+        return position.perp2() < m_radius*m_radius && std::abs(position.z()) < m_halfLength;
+    }
+
+    G4ThreeVector m_center;
+    G4double m_radius;
+    G4double m_halfLength;
+    G4bool m_gammasOnly = true;
+
+    G4Mutex m_mutex = G4MUTEX_INITIALIZER;
+    vector<unique_ptr<Writer>> m_writers;
+
+    shared_ptr<G4UIcmdWithAString> m_fileCmd;
+    shared_ptr<G4UIcmdWith3VectorAndUnit> m_centerCmd;
+    shared_ptr<G4UIcmdWithADoubleAndUnit> m_radiusCmd;
+    shared_ptr<G4UIcmdWithADoubleAndUnit> m_halfLengthCmd;
+    shared_ptr<G4UIcmdWithAString> m_particlesCmd;
+};
+
+#endif // PhaseSpaceRecorder_hh
@@ -11,6 +11,8 @@
 #include <memory>
 using std::shared_ptr;
 using std::make_shared;
+#include <vector>
+using std::vector;
 
 class G4Event;
 class G4UIcmdWithAString;
@@ -20,6 +22,9 @@ class IsotropicGunGen;
 class GammaDecaySchemeGen;
 class PositronGunGen;
 class NuclideGunGen;
+class EventFileGunGen;
+class CompositeGen;
+class BackgroundGunGen;
 
 /// The primary generator action manager.
 ///
@@ -38,16 +43,23 @@ public:
 
     void SetNewValue(G4UIcommand* command, G4String newValue);
 
+    /// Energies of the gammas emitted by the selected generator, as far as
+    /// the generator knows them (empty otherwise).
+    void GetGammaLines(vector<G4double>& lines) const;
+
 private:
     shared_ptr<G4UIcmdWithAString> m_selectPGcmd;
 
-  enum {pgIsotropicGun, pgGammaDecayScheme, pgPositronGun, pgNuclideGun, pgUndefined,pgPrimaryGun} m_selectedPG = pgUndefined;
+  enum {pgIsotropicGun, pgGammaDecayScheme, pgPositronGun, pgNuclideGun, pgUndefined,pgPrimaryGun, pgEventFileGun, pgComposite, pgBackgroundGun} m_selectedPG = pgUndefined;
 
     shared_ptr<IsotropicGunGen>     m_pgIsotropicGun;
     shared_ptr<GammaDecaySchemeGen> m_pgGammaDecayScheme;
     shared_ptr<PositronGunGen> m_pgPositronGun;
     shared_ptr<NuclideGunGen> m_pgNuclideGun;
     shared_ptr<PrimaryGunGen> m_pgPrimaryGun;
+    shared_ptr<EventFileGunGen> m_pgEventFileGun;
+    shared_ptr<CompositeGen> m_pgComposite;
+    shared_ptr<BackgroundGunGen> m_pgBackgroundGun;
 
 };
 
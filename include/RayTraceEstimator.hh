@@ -0,0 +1,94 @@
+#ifndef RayTraceEstimator_hh
+#define RayTraceEstimator_hh
+
+#include "G4UImessenger.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <memory>
+using std::shared_ptr;
+#include <utility>
+using std::pair;
+#include <vector>
+using std::vector;
+
+class G4UIcmdWithAString;
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWith3VectorAndUnit;
+class G4UIcmdWithoutParameter;
+
+class DetectorConstruction;
+
+/// Estimates the detection efficiency of a point source in seconds, without
+/// Monte Carlo, by tracing rays through the constructed geometry.
+///
+/// Rays leave the source through the centers of nCosTheta x nPhi cells of
+/// equal solid angle. Along every ray the navigator finds the volumes it
+/// crosses, and the total attenuation coefficients of their materials at the
+/// gamma energy (G4EmCalculator) give the probability that the gamma arrives
+/// at each point. The estimate is the probability that the first interaction
+/// of the gamma is inside the active germanium, averaged over the rays. It
+/// follows the full-energy-peak efficiency over the source position but is
+/// larger, as not every interacting gamma deposits its full energy.
+///
+///     /RayTrace/energy 7824 keV
+///     /RayTrace/estimate 0.3 -1.2 -2.1 cm
+///
+/// /RayTrace/map writes the estimate on a grid of source positions, by
+/// default the one of analysis/Run.py and analysis/results (x and y from -3
+/// to 3 cm in steps of 0.3 cm), as lines "x y efficiency" (x and y in cm).
+///
+/// /RayTrace/bias uses the probabilities of the rays from a position as the
+/// importance map of the emission directions (EmissionBias).
+///
+/// The rays are traced in the master thread, the navigator used for them is
+/// not the one of the tracking.
+
+class RayTraceEstimator : public G4UImessenger
+{
+public:
+    RayTraceEstimator(DetectorConstruction* detectorConstruction);
+    virtual ~RayTraceEstimator() {}
+
+    void SetNewValue(G4UIcommand* command, G4String newValue);
+
+    /// Efficiency at the source position, the probabilities of the rays
+    /// (cell i*nPhi + j, see EmissionBias) go into rays if given
+    G4double Estimate(const G4ThreeVector& position, vector<G4double>* rays = nullptr);
+
+private:
+    /// Closes the geometry and computes the attenuation coefficients of all materials
+    void Prepare();
+
+    void WriteMap(const G4String& fileName);
+
+    DetectorConstruction* m_detectorConstruction;
+
+    G4double m_energy;
+    G4int m_nCosTheta = 64;
+    G4int m_nPhi = 128;
+    G4double m_xMin, m_xMax, m_yMin, m_yMax;
+    G4double m_spacing;
+    G4double m_z;
+    G4double m_mixture = 0.1;
+
+    // by material index, at m_energy
+    vector<G4double> m_attenuation;
+    // spheres (center, radius) around the placements of the active volume,
+    // rays that miss all of them are not traced
+    vector<pair<G4ThreeVector, G4double>> m_targets;
+
+    shared_ptr<G4UIcmdWithADoubleAndUnit> m_energyCmd;
+    shared_ptr<G4UIcmdWithAString> m_directionsCmd;
+    shared_ptr<G4UIcmdWith3VectorAndUnit> m_estimateCmd;
+    shared_ptr<G4UIcmdWithAString> m_regionCmd;
+    shared_ptr<G4UIcmdWithADoubleAndUnit> m_spacingCmd;
+    shared_ptr<G4UIcmdWithADoubleAndUnit> m_zCmd;
+    shared_ptr<G4UIcmdWithAString> m_mapCmd;
+    shared_ptr<G4UIcmdWith3VectorAndUnit> m_biasCmd;
+    shared_ptr<G4UIcmdWithADouble> m_mixtureCmd;
+    shared_ptr<G4UIcmdWithoutParameter> m_noBiasCmd;
+};
+
+#endif // RayTraceEstimator_hh
@@ -0,0 +1,77 @@
+#ifndef ResultCache_hh
+#define ResultCache_hh
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+#include <cstdint>
+#include <memory>
+using std::shared_ptr;
+using std::unique_ptr;
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+class TH1D;
+
+class EnergyHistogram;
+
+/// Keeps the spectra of finished runs in a directory, addressed by a hash of
+/// everything that determines them, so that repeated configurations are not
+/// simulated again.
+///
+/// Runs through the cache use "/Cache/beamOn N" instead of "/run/beamOn N".
+/// The key covers:
+///  - all commands applied so far (with whitespace normalized), except those
+///    that cannot change the spectra, such as /control/, /vis/ and /Output/
+///    (see /Cache/ignore)
+///  - the contents of files named in the commands (level schemes, event files)
+///  - the state of the random engine
+///  - the binning of the spectra and the versions of G4_HPGe and Geant4
+///
+/// An entry with at least N events is returned without simulating. With
+/// fewer events only the missing ones are simulated and added to the entry.
+/// The runs are seeded from the key and the number of events already stored,
+/// and the engine is seeded from the key again afterwards, so that the keys of
+/// the following runs do not depend on whether this one was found.
+///
+/// Like the other ways of running a job (scans, efficiency maps), the
+/// spectra are cleared first. The cache stores "h1", "h1w" and the
+/// component spectra, not the event tree.
+
+class ResultCache : public G4UImessenger
+{
+public:
+    ResultCache(EnergyHistogram* energyHistogram);
+    virtual ~ResultCache() {}
+
+    void SetNewValue(G4UIcommand* command, G4String newValue);
+
+    /// Fills the spectra with at least nEvents events of the current configuration
+    void BeamOn(G4int nEvents);
+
+private:
+    /// Canonical text of the configuration
+    string GetState() const;
+
+    /// Events in the entry (0 if there is none or it belongs to another state)
+    G4long Load(const string& fileName, const string& state, vector<unique_ptr<TH1D>>& histograms) const;
+    void Store(const string& fileName, const string& state, G4long events) const;
+
+    static uint64_t Hash(const string& text);
+    static void SeedEngine(uint64_t key, G4long events);
+
+    EnergyHistogram* m_energyHistogram;
+
+    G4String m_directory = "./cache";
+    vector<string> m_ignored;
+
+    shared_ptr<G4UIcmdWithAString> m_directoryCmd;
+    shared_ptr<G4UIcmdWithAString> m_ignoreCmd;
+    shared_ptr<G4UIcmdWithAnInteger> m_beamOnCmd;
+};
+
+#endif // ResultCache_hh
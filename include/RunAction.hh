@@ -0,0 +1,38 @@
+#ifndef RunAction_hh
+#define RunAction_hh
+
+#include "G4UserRunAction.hh"
+#include "globals.hh"
+
+class RunControl;
+class LiveExport;
+class DecayChainLimits;
+class PhaseSpaceRecorder;
+class AsyncWriter;
+
+/// Starts and finishes the run control, the live export, the decay chain
+/// limits, the phase-space recording and the asynchronous output on the
+/// master, and reports the live time of the BackgroundGun and the events per
+/// second of the workers; the worker instances (needed in sequential mode,
+/// where the only run action is the master's) only time their share of the
+/// run for the ThreadPlacement.
+
+class RunAction : public G4UserRunAction
+{
+public:
+    RunAction(RunControl* runControl, LiveExport* liveExport, DecayChainLimits* decayChainLimits,
+              PhaseSpaceRecorder* phaseSpaceRecorder, AsyncWriter* asyncWriter);
+    virtual ~RunAction();
+
+    virtual void BeginOfRunAction(const G4Run* run);
+    virtual void EndOfRunAction(const G4Run* run);
+
+private:
+    RunControl* m_runControl;
+    LiveExport* m_liveExport;
+    DecayChainLimits* m_decayChainLimits;
+    PhaseSpaceRecorder* m_phaseSpaceRecorder;
+    AsyncWriter* m_asyncWriter;
+};
+
+#endif // #ifndef RunAction_hh
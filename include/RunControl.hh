@@ -0,0 +1,94 @@
+#ifndef RunControl_hh
+#define RunControl_hh
+
+#include "G4UImessenger.hh"
+#include "G4AutoLock.hh"
+#include "globals.hh"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+using std::shared_ptr;
+#include <vector>
+using std::vector;
+
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithoutParameter;
+
+class EnergyHistogram;
+
+/// Stops a run once the full-energy peaks are known well enough.
+///
+/// Every checkInterval events (counted over all threads) the net counts of
+/// the full-energy peaks are estimated from the shared spectrum: the counts
+/// in a window around each line minus the background taken from two side
+/// bands of the same width. The run is aborted softly (the events in flight
+/// are finished) once the relative uncertainty of every line is below the
+/// target precision, or once the wall-time budget is used up. Both criteria
+/// are off by default, /run/beamOn N then always runs N events.
+///
+/// The lines are the gamma energies of the selected generator (the
+/// transitions of the level scheme below the excited state, or the energy
+/// of the isotropic gun if it shoots gammas), unless lines are given with
+/// /RunControl/addLine.
+///
+///     /RunControl/precision 0.01
+///     /RunControl/timeLimit 10 min
+///     /run/beamOn 100000000
+
+class RunControl : public G4UImessenger
+{
+public:
+    RunControl(EnergyHistogram* energyHistogram);
+    virtual ~RunControl() {}
+
+    void SetNewValue(G4UIcommand* command, G4String newValue);
+
+    // Called by the master at the beginning and the end of every run
+    void BeginOfRun();
+    void EndOfRun();
+
+    // Called by every thread after the event was filled into the spectrum
+    void EndOfEvent();
+
+private:
+    G4bool IsEnabled() const
+    {
+        return m_precision > 0 || m_timeLimit > 0;
+    }
+
+    // Explicit lines, or those of the generator of the calling thread
+    void GetLines(vector<G4double>& lines) const;
+
+    // Largest relative uncertainty of the net peak counts of all lines
+    G4double EstimatePrecision(const vector<G4double>& lines) const;
+
+    void Stop(const G4String& reason);
+
+    EnergyHistogram* m_energyHistogram;
+
+    G4double m_precision = 0;
+    G4double m_timeLimit = 0;
+    G4int m_checkInterval = 10000;
+    G4double m_peakHalfWidth;
+    vector<G4double> m_lines;
+
+    std::atomic<G4int> m_events{0};
+    std::atomic<G4bool> m_stopped{false};
+    std::chrono::steady_clock::time_point m_startTime;
+
+    G4Mutex m_mutex = G4MUTEX_INITIALIZER;
+    G4String m_stopReason;
+    G4double m_lastPrecision = -1;
+
+    shared_ptr<G4UIcmdWithADouble> m_precisionCmd;
+    shared_ptr<G4UIcmdWithADoubleAndUnit> m_timeLimitCmd;
+    shared_ptr<G4UIcmdWithAnInteger> m_checkIntervalCmd;
+    shared_ptr<G4UIcmdWithADoubleAndUnit> m_peakHalfWidthCmd;
+    shared_ptr<G4UIcmdWithADoubleAndUnit> m_addLineCmd;
+    shared_ptr<G4UIcmdWithoutParameter> m_clearLinesCmd;
+};
+
+#endif // RunControl_hh
@@ -0,0 +1,67 @@
+#ifndef RunSharding_hh
+#define RunSharding_hh
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+#include <memory>
+using std::shared_ptr;
+
+class G4UIcmdWithAnInteger;
+
+/// Splits one logical run into several independent processes.
+///
+/// The launcher forks one child process per shard before any Geant4 or ROOT
+/// state is created. Every child gets a seed pair derived from the base seed
+/// and its shard index, its own output file (sim_<shard>.root) and its own
+/// log file (shard_<shard>.log). The parent only waits for the children.
+///
+/// Macros run in sharded mode should use "/Shard/beamOn N" instead of
+/// "/run/beamOn N": the N events are then divided among the shards.
+/// The outputs can be combined with the G4_HPGe_merge tool.
+
+class RunSharding : public G4UImessenger
+{
+public:
+    RunSharding(G4int nShards, G4int shardIndex, G4long baseSeed);
+    virtual ~RunSharding() {}
+
+    /// Forks nShards children. Returns the shard index in the child processes.
+    /// In the parent process it waits for all children and calls exit() with
+    /// a non-zero status if any of them failed.
+    static G4int Launch(G4int nShards);
+
+    /// Seeds the random engine with the seed pair of this shard.
+    void SeedEngine() const;
+
+    G4String GetOutputFileName() const;
+
+    /// Number of events this shard has to process out of nEvents in total.
+    G4int GetShardEvents(G4int nEvents) const;
+
+    /// Shard of this process, for code without access to the instance
+    /// (e.g. generators dividing their input). 1 and 0 without sharding.
+    static G4int GetNumberOfShards()
+    {
+        return s_nShards;
+    }
+
+    static G4int GetCurrentShard()
+    {
+        return s_shardIndex;
+    }
+
+    void SetNewValue(G4UIcommand* command, G4String newValue);
+
+private:
+    G4int m_nShards;
+    G4int m_shardIndex;
+    G4long m_baseSeed;
+
+    static G4int s_nShards;
+    static G4int s_shardIndex;
+
+    shared_ptr<G4UIcmdWithAnInteger> m_beamOnCmd;
+};
+
+#endif // RunSharding_hh
@@ -0,0 +1,89 @@
+#ifndef ScanManager_hh
+#define ScanManager_hh
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+#include <memory>
+using std::shared_ptr;
+#include <vector>
+using std::vector;
+
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithoutParameter;
+class G4UIcmdWithABool;
+
+class DetectorConstruction;
+class GeometryObject;
+class EnergyHistogram;
+
+/// Scans geometry dimensions and placements within one process.
+///
+/// Every scan axis varies one dimension registered by a GeometryObject. The
+/// scan runs over all combinations of the axes (the last axis varies
+/// fastest). For each point only the modified objects are rebuilt through a
+/// geometry reinitialization, the physics tables are kept.
+///
+/// Placement axes move or rotate an object instead. As long as no dimension
+/// changes, only the transforms of the already built volumes are updated and
+/// only their mother volume is re-voxelized. The moved volumes are checked
+/// for overlaps (/Scan/checkOverlaps, on by default); overlapping points are
+/// not run, they get 0 events in the tree and no spectrum.
+///
+/// Detail axes switch the level of detail of an object (full, simplified,
+/// homogenized), the axis value is the index of the level.
+///
+/// All points go into one file: the spectrum of point n as "h1_<n>" and a
+/// tree "scan" with the point index, the number of events, the real time of
+/// the run in s and the values of all axes (in mm and deg).
+///
+///     /Scan/addDimension HPGeDetector detectorHoleDepth 70 80 2 mm
+///     /Scan/addRotation HPGeDetector y 0 30 10 deg
+///     /Scan/run 100000
+
+class ScanManager : public G4UImessenger
+{
+public:
+    ScanManager(DetectorConstruction* detectorConstruction, EnergyHistogram* energyHistogram);
+    virtual ~ScanManager() {}
+
+    void SetNewValue(G4UIcommand* command, G4String newValue);
+
+private:
+    struct Axis
+    {
+        enum {axisDimension, axisPosition, axisRotation, axisDetail} type;
+        GeometryObject* object;
+        G4String dimension;
+        G4int component;
+        vector<G4double> values;
+    };
+
+    // Reads "object dimension-or-axis from to step unit" into a new axis
+    G4bool ParseAxis(const G4String& parameters, Axis& axis);
+    void AddDimension(const G4String& parameters);
+    void AddPlacement(const G4String& parameters, G4bool rotation);
+    void AddDetail(const G4String& parameters);
+    G4String GetAxisName(const Axis& axis) const;
+    void Run(G4int eventsPerPoint);
+
+    DetectorConstruction* m_detectorConstruction;
+    EnergyHistogram* m_energyHistogram;
+
+    vector<Axis> m_axes;
+    G4String m_fileName = "./scan.root";
+
+    G4bool m_checkOverlaps = true;
+
+    shared_ptr<G4UIcmdWithAString> m_addDimensionCmd;
+    shared_ptr<G4UIcmdWithAString> m_addPositionCmd;
+    shared_ptr<G4UIcmdWithAString> m_addRotationCmd;
+    shared_ptr<G4UIcmdWithAString> m_addDetailCmd;
+    shared_ptr<G4UIcmdWithABool> m_checkOverlapsCmd;
+    shared_ptr<G4UIcmdWithoutParameter> m_clearCmd;
+    shared_ptr<G4UIcmdWithAString> m_fileNameCmd;
+    shared_ptr<G4UIcmdWithAnInteger> m_runCmd;
+};
+
+#endif // ScanManager_hh
@@ -0,0 +1,53 @@
+#ifndef SimulationServer_hh
+#define SimulationServer_hh
+
+#include "globals.hh"
+
+#include <string>
+using std::string;
+
+class EnergyHistogram;
+class TH1D;
+
+/// Runs the jobs of local clients on the initialized run manager, so that
+/// geometry, physics and threads are set up only once (G4_HPGe --serve).
+///
+/// The server listens on a unix socket (only accessible by the user) and
+/// handles one connection after the other, the waiting clients queue up in
+/// the listen backlog. A job is a macro fragment, one command per line,
+/// ended by closing the writing side of the connection or by a line "end":
+///
+///     /PrimaryGenerator/GammaDecayScheme/position 0.3 -1.2 -2.1 cm
+///     /run/beamOn 100000
+///
+/// The spectra are cleared before every /run/beamOn. After it, the server
+/// sends every spectrum as a line "spectrum <name> <nBins> <Emin> <Emax>
+/// <entries>" (energies in MeV) followed by the nBins+2 bin contents
+/// (including underflow and overflow) as native doubles. A failed command
+/// ends the job with "error <status> <command>", the end of the job is
+/// "done". A line "shutdown" stops the server after the job.
+/// analysis/SimulationClient.py is a client for Python.
+
+class SimulationServer
+{
+public:
+    SimulationServer(EnergyHistogram* energyHistogram);
+    ~SimulationServer();
+
+    /// Serves until a job asks for shutdown
+    void Serve(const G4String& socketName);
+
+private:
+    /// Runs one job, returns false if it asked for shutdown
+    G4bool HandleJob(int connection);
+
+    G4bool SendLine(int connection, const string& line);
+    G4bool SendSpectrum(int connection, const string& name, const TH1D* histogram);
+    G4bool Send(int connection, const void* data, size_t size);
+
+    EnergyHistogram* m_energyHistogram;
+    int m_socket = -1;
+    G4String m_socketName;
+};
+
+#endif // SimulationServer_hh
@@ -0,0 +1,54 @@
+#ifndef StackingAction_hh
+#define StackingAction_hh
+
+#include "G4UserStackingAction.hh"
+#include "globals.hh"
+
+#include <map>
+using std::map;
+#include <set>
+using std::set;
+
+class DecayChainLimits;
+class G4ParticleDefinition;
+
+/// Applies the decay chain limits: the products of a radioactive decay are
+/// killed when the decay lies outside the limits. The nuclei of the event
+/// are remembered with their depth in the chain, so that every cut decay is
+/// counted once for the decaying nuclide. A decay only goes one level deeper
+/// when it changes Z or A: excited and isomeric levels keep the depth of the
+/// decay that populated them, and so do their de-excitations (Co-60 -> Ni-60
+/// and the gammas of Ni-60 all have depth 1), while an isomer that decays
+/// into another nuclide starts the next level.
+
+class StackingAction : public G4UserStackingAction
+{
+public:
+    StackingAction(DecayChainLimits* decayChainLimits);
+    virtual ~StackingAction();
+
+    virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track);
+    virtual void PrepareNewEvent();
+
+private:
+    /// Whether the radioactive decay of parent, whose products are being
+    /// stacked, produced a nucleus of another Z or A
+    G4bool ChangesNuclide(const G4ParticleDefinition* parent) const;
+
+    struct Nucleus
+    {
+        const G4ParticleDefinition* definition;
+        G4int depth;
+    };
+
+    DecayChainLimits* m_decayChainLimits;
+
+    // nuclei of the current event by track ID
+    map<G4int, Nucleus> m_nuclei;
+    // depth of the decay of a nucleus by its track ID
+    map<G4int, G4int> m_decayDepths;
+    set<G4int> m_cutDecays;
+    G4double m_firstDecayTime = -1;
+};
+
+#endif // #ifndef StackingAction_hh
@@ -4,7 +4,11 @@
 #include "G4UserSteppingAction.hh"
 #include "globals.hh"
 
+#include "PhaseSpaceRecorder.hh"
+
 class EventAction;
+class DetectorConstruction;
+class HPGeDetector;
 
 class G4LogicalVolume;
 
@@ -12,14 +16,26 @@ class G4LogicalVolume;
 class SteppingAction : public G4UserSteppingAction
 {
 public:
-    SteppingAction(EventAction* eventAction);
+    SteppingAction(EventAction* eventAction, PhaseSpaceRecorder::Writer* phaseSpaceWriter);
     virtual ~SteppingAction();
 
     virtual void UserSteppingAction(const G4Step* step);
 
 private:
     EventAction* m_eventAction;
+    PhaseSpaceRecorder::Writer* m_phaseSpaceWriter;
     G4LogicalVolume* m_scoringVolume;
+
+    // the volumes are looked up again whenever the geometry was rebuilt
+    const DetectorConstruction* m_detectorConstruction;
+    G4int m_geometryVersion;
+
+    // full crystal (dead layers included), whose particles end a screened event
+    G4LogicalVolume* m_detectorVolume;
+
+    // only set if the dead-layer depth records are enabled
+    HPGeDetector* m_hpgeDetector;
+    G4LogicalVolume* m_crystalVolume;
 };
 
 #endif // #ifndef SteppingAction_hh
@@ -3,6 +3,8 @@
 
 #include "GeometryObject.hh"
 
+class G4Polycone;
+
 class TargetChamberC12 : public GeometryObject {
 
     public:
@@ -12,9 +14,14 @@ class TargetChamberC12 : public GeometryObject {
         G4VPhysicalVolume *Construct();
         void ConstructSDandField() {};
 
+        G4VSolid *ConstructHull();
+
         virtual void SetNewValue(G4UIcommand* command, G4String value);
 
     private:
+        // Flanges and tube as one solid, used by the simplified model and
+        // as the hull of the homogenized one
+        G4Polycone *ConstructMergedSolid();
 };
 
 #endif
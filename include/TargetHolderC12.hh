@@ -17,6 +17,8 @@ class TargetHolderC12 : public GeometryObject {
         G4VPhysicalVolume *Construct();
         void ConstructSDandField() {};
 
+        G4VSolid *ConstructHull();
+
         virtual void SetNewValue(G4UIcommand* command, G4String value);
 
     private:
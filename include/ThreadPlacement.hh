@@ -0,0 +1,119 @@
+#ifndef ThreadPlacement_hh
+#define ThreadPlacement_hh
+
+#include "G4UImessenger.hh"
+#include "G4AutoLock.hh"
+#include "globals.hh"
+
+#include <chrono>
+#include <memory>
+using std::shared_ptr;
+#include <vector>
+using std::vector;
+
+class G4UIcmdWithAString;
+class G4UIcmdWithABool;
+
+/// Pins the worker threads to logical CPUs following the topology of the
+/// machine, and reports the events per second each worker achieved.
+///
+/// Without pinning the scheduler moves the workers between cores and, on
+/// machines with several sockets, between NUMA nodes, away from the memory
+/// their thread-local data lives in. "/Threads/pin" places worker i on the
+/// i-th CPU of an order built from /sys/devices/system/cpu, restricted to
+/// the CPUs the process may run on (taskset, cgroups):
+///
+///     none          the scheduler decides (default)
+///     cores         one worker per physical core, node by node; the other
+///                   hyperthreads of the cores only once every core has one
+///     hyperthreads  both hyperthreads of a core before the next core, node
+///                   by node: pairs of workers share their core's caches
+///     scatter       as cores, but alternating between the NUMA nodes
+///
+/// With more workers than CPUs the order starts over. The workers pin
+/// themselves when they start, before they build their user actions, so the
+/// memory they touch first (their event buffers, the phase-space and tree
+/// buffers, the Geant4 allocators of tracks and steps) is taken from their
+/// own NUMA node by the kernel's first-touch policy. Set the policy before
+/// the first run: a later change moves the workers at the start of the next
+/// run, but not the memory they have already touched. The spectra are shared
+/// by all workers and stay where the master allocated them.
+///
+/// "/Threads/report true" prints, after every run, the CPU and NUMA node of
+/// every worker at the end of the run, its events and its events per second,
+/// and the spread over the workers; mac/benchmarkAffinity.mac compares the
+/// policies. Shards are separate processes: pinned shards need disjoint CPU
+/// sets (taskset), otherwise they share the first CPUs of the order.
+///
+/// Pinning needs Linux, elsewhere only "none" is available.
+
+class ThreadPlacement : public G4UImessenger
+{
+public:
+    ThreadPlacement();
+    virtual ~ThreadPlacement()
+    {
+        s_instance = nullptr;
+    }
+
+    void SetNewValue(G4UIcommand* command, G4String newValue);
+
+    /// Called by every worker thread when it starts and at the start of
+    /// every run, pins it following the current policy
+    static void PinWorker();
+
+    /// Called by the workers at the start and the end of every run
+    static void BeginOfWorkerRun();
+    static void EndOfWorkerRun(G4int nEvents);
+
+    /// Called on the master at the start and the end of every run, the end
+    /// prints the report
+    static void BeginOfRun();
+    static void EndOfRun();
+
+private:
+    enum Policy {policyNone, policyCores, policyHyperthreads, policyScatter};
+
+    struct Cpu
+    {
+        G4int id;
+        G4int package;
+        G4int core;
+        G4int node;
+        // position among the hyperthreads of its core
+        G4int sibling;
+    };
+
+    struct WorkerRecord
+    {
+        std::chrono::steady_clock::time_point start;
+        G4double seconds = 0;
+        G4int events = -1;
+        G4int cpu = -1;
+    };
+
+    /// Reads the CPUs the process may run on and their topology
+    void ReadTopology();
+
+    /// Sorts the CPUs into the order of the policy
+    void UpdateOrder();
+
+    G4int GetNode(G4int cpu) const;
+
+    static ThreadPlacement* s_instance;
+
+    Policy m_policy = policyNone;
+    G4bool m_report = false;
+
+    vector<Cpu> m_cpus;
+    vector<G4int> m_order;
+
+    G4Mutex m_mutex = G4MUTEX_INITIALIZER;
+    // by thread ID
+    vector<WorkerRecord> m_workers;
+
+    shared_ptr<G4UIcmdWithAString> m_pinCmd;
+    shared_ptr<G4UIcmdWithABool> m_reportCmd;
+};
+
+#endif // ThreadPlacement_hh
@@ -0,0 +1,125 @@
+#ifndef TwoTierRun_hh
+#define TwoTierRun_hh
+
+#include "G4UImessenger.hh"
+#include "G4AutoLock.hh"
+#include "globals.hh"
+
+#include <atomic>
+#include <memory>
+using std::shared_ptr;
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+class G4Event;
+class EnergyHistogram;
+class G4UIcmdWithAString;
+class G4UIcmdWithADouble;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithoutParameter;
+
+/// Runs every event first with cheap settings and simulates again, at full
+/// fidelity, only the events that came near the detector.
+///
+/// "/TwoTier/beamOn N" applies the screening commands and screens N events.
+/// An event is kept if a particle reaches the germanium crystal (dead layers
+/// included); it is aborted at that point, as the screening has no further
+/// use for it. Kept events are recorded by the state of the random engine
+/// before their primaries were generated. Then the full-fidelity commands
+/// are applied and only the kept events are run again, from the recorded
+/// states, so that they start with identical primaries.
+///
+/// Events that were not kept are replayed with the probability of the
+/// roulette fraction f and the weight 1/f (Russian roulette), so that the
+/// weighted spectrum "h1w" stays unbiased even for events the screening
+/// misjudges: its weights add up to N on average. The roulette draws from an
+/// engine of its own, seeded by the master for every run and by the event
+/// ID, as the engine of the event continues with the stream the replay
+/// restores. With f = 0 these events
+/// are dropped. The spectra are then biased by the fraction of events that
+/// would have reached the crystal at full fidelity but did not in the
+/// screening, which the runs with f > 0 measure (printed at the end).
+///
+///     /TwoTier/screenCommand /run/setCut 5 mm
+///     /TwoTier/screenCommand /process/em/fluo false
+///     /TwoTier/screenCommand /Geometry/TargetHolderC12/detail simplified
+///     /TwoTier/screenCommand /run/reinitializeGeometry
+///     /TwoTier/fullCommand /run/setCut 0.1 mm
+///     /TwoTier/fullCommand /process/em/fluo true
+///     /TwoTier/fullCommand /Geometry/TargetHolderC12/detail full
+///     /TwoTier/fullCommand /run/reinitializeGeometry
+///     /TwoTier/beamOn 10000000
+///
+/// The screening fills no spectra, tree or phase space. The replayed events
+/// are filled like the events of /run/beamOn. Afterwards the entries of "h1"
+/// and "h1w" count the N screened events, and N is written into the output
+/// as "screenedEvents". The contents of "h1" count the roulette events with
+/// weight 1 and are biased; "h1w" is the spectrum of a two-tier run.
+
+class TwoTierRun : public G4UImessenger
+{
+public:
+    TwoTierRun(EnergyHistogram* energyHistogram);
+    virtual ~TwoTierRun()
+    {
+        s_instance = nullptr;
+    }
+
+    void SetNewValue(G4UIcommand* command, G4String newValue);
+
+    void BeamOn(G4int nEvents);
+
+    /// Whether the current run is the screening pass
+    static G4bool IsScreening()
+    {
+        return s_instance && s_instance->m_mode == modeScreen;
+    }
+
+    /// Called by the generator (any thread) before the primaries are
+    /// generated: in the replay, sets the engine to the state of the kept
+    /// event with the index of the event ID and returns its weight, 1 otherwise
+    static G4double BeginOfPrimaries(const G4Event* event);
+
+    /// Called at the end of every event (any thread) with the deposit in the
+    /// active volume and whether a particle reached the crystal
+    static void EndOfEvent(const G4Event* event, G4double edep, G4bool nearDetector);
+
+private:
+    enum Mode {modeOff, modeScreen, modeReplay};
+
+    struct Record
+    {
+        string engineStatus;
+        G4double weight;
+        G4bool nearDetector;
+    };
+
+    void ApplyCommands(const vector<G4String>& commands) const;
+
+    /// Uniform number for the roulette of the screened event
+    G4double DrawRoulette(G4int eventID) const;
+
+    static TwoTierRun* s_instance;
+
+    EnergyHistogram* m_energyHistogram;
+    std::atomic<int> m_mode{modeOff};
+    G4double m_rouletteFraction = 0.01;
+    long m_rouletteSeed = 0;
+    vector<G4String> m_screenCommands;
+    vector<G4String> m_fullCommands;
+
+    G4Mutex m_mutex = G4MUTEX_INITIALIZER;
+    vector<Record> m_records;
+    // replayed roulette events that deposited energy
+    std::atomic<size_t> m_missedEvents{0};
+
+    shared_ptr<G4UIcmdWithAString> m_screenCommandCmd;
+    shared_ptr<G4UIcmdWithAString> m_fullCommandCmd;
+    shared_ptr<G4UIcmdWithoutParameter> m_clearCommandsCmd;
+    shared_ptr<G4UIcmdWithADouble> m_rouletteFractionCmd;
+    shared_ptr<G4UIcmdWithAnInteger> m_beamOnCmd;
+};
+
+#endif // TwoTierRun_hh
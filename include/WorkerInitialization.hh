@@ -0,0 +1,19 @@
+#ifndef WorkerInitialization_hh
+#define WorkerInitialization_hh
+
+#include "G4UserWorkerInitialization.hh"
+
+/// Pins every worker thread with the ThreadPlacement as soon as it starts,
+/// before the worker run manager and the user actions are created, so that
+/// the thread-local memory comes from the NUMA node it runs on.
+
+class WorkerInitialization : public G4UserWorkerInitialization
+{
+public:
+    WorkerInitialization() = default;
+    virtual ~WorkerInitialization() = default;
+
+    virtual void WorkerInitialize() const;
+};
+
+#endif // WorkerInitialization_hh
@@ -0,0 +1,48 @@
+/// \file g4hpge.h
+/// \brief C interface of the simulation, for use from Python (analysis/g4hpge.py)
+
+#ifndef g4hpge_h
+#define g4hpge_h 1
+
+/// The simulation is set up once per process (geometry, physics, threads)
+/// and then driven by commands and runs, without output files in between.
+/// The spectra are handed out as pointers to the bin contents of the
+/// histograms themselves: they stay valid until g4hpge_finalize() and show
+/// the result of the latest run.
+///
+/// All functions except g4hpge_spectrum() return 0 on success and -1 on
+/// failure, with the reason in g4hpge_last_error().
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Creates the run manager with nThreads worker threads (0: default),
+/// executes setupMacro (may be null, e.g. the geometry commands) and
+/// initializes the run manager unless the macro did. A seed of 0 keeps the
+/// default seeds. The spectra are written to outputFileName at the end, an
+/// empty name or null writes nothing.
+int g4hpge_initialize(const char* setupMacro, int nThreads, long seed, const char* outputFileName);
+
+/// Applies a macro command, e.g. "/PrimaryGenerator/GammaDecayScheme/position 0 0 -2.1 cm"
+int g4hpge_command(const char* command);
+
+/// Clears the spectra and simulates events
+int g4hpge_run(long long events);
+
+/// Bin contents of the spectrum "h1", "h1w" or "h1_<component>", nBins+2
+/// values including underflow and overflow (energies in MeV). Null if the
+/// spectrum does not exist (yet).
+const double* g4hpge_spectrum(const char* name, int* nBins, double* Emin, double* Emax, double* entries);
+
+/// Deletes the run manager (and writes the output file); the simulation
+/// cannot be initialized again in the same process.
+int g4hpge_finalize();
+
+const char* g4hpge_last_error();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,108 @@
+/// \file BackgroundGunGen.hh
+/// \brief Definition of the BackgroundGunGen class
+
+#ifndef BackgroundGunGen_h
+#define BackgroundGunGen_h 1
+
+#include "G4VUserPrimaryGeneratorAction.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include "G4UImessenger.hh"
+
+#include <atomic>
+#include <memory>
+using std::shared_ptr;
+
+class G4UIcmdWith3Vector;
+class G4UIcmdWith3VectorAndUnit;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithADouble;
+class G4UIcmdWithAString;
+
+class G4ParticleGun;
+class G4Event;
+
+/// Background from outside the setup: cosmic-ray muons or the gammas of the
+/// room walls, emitted only on trajectories that cross a sphere (the
+/// envelope) around the detector and the shielding.
+///
+/// For every event the direction is drawn from the angular distribution of
+/// the field, then the trajectory is placed uniformly on the disk of the
+/// envelope's radius R perpendicular to it, starting on the plane that
+/// touches the envelope. All trajectories that miss the envelope are thus
+/// left out analytically: with the intensity I per area, time and solid
+/// angle, the rate of the generated particles is
+///
+///     muons:  I(theta) = I0 cos^2(theta)  ->  rate = I0 (2 pi/3) pi R^2
+///     gammas: I = flux/(4 pi), isotropic  ->  rate = flux pi R^2
+///
+/// (theta from the vertical /up). N events correspond to a live time of
+/// N/rate, which is printed at the end of every run.
+///
+///     /PrimaryGenerator/select BackgroundGun
+///     /PrimaryGenerator/BackgroundGun/source muon
+///     /PrimaryGenerator/BackgroundGun/up 0 1 0
+///
+/// The muons have one energy (4 GeV by default, about the mean at sea
+/// level), mu+ and mu- in the ratio 1.27; the default vertical intensity is
+/// the PDG value above 1 GeV, 70 per m^2 s sr. The wall gammas have the
+/// energy and the omnidirectional flux (per cm^2 s) of one line.
+///
+/// Without /radius the envelope is the sphere around the bounding boxes of
+/// all volumes placed in the world, updated when the geometry changes.
+
+class BackgroundGunGen : public G4VUserPrimaryGeneratorAction, public G4UImessenger
+{
+public:
+  BackgroundGunGen(const G4String& commandDir = "/PrimaryGenerator/BackgroundGun/");
+  virtual ~BackgroundGunGen();
+
+  virtual void GeneratePrimaries(G4Event* event);
+
+  void SetNewValue(G4UIcommand* command, G4String newValue);
+
+  /// Called on the master at the start and the end of every run, the end
+  /// prints the live time of the events generated in all threads
+  static void BeginOfRun();
+  static void EndOfRun();
+
+private:
+  enum Source {sourceMuon, sourceGamma};
+
+  /// Sets the envelope to the sphere around everything in the world
+  void UpdateEnvelope();
+
+  /// Generated particles per second
+  G4double GetRate() const;
+
+  G4ParticleGun* fParticleGun = nullptr;
+
+  Source m_source = sourceMuon;
+  G4double m_muonEnergy;
+  G4double m_intensity;
+  G4double m_gammaEnergy;
+  G4double m_flux;
+  G4ThreeVector m_up;
+
+  // a radius of 0 follows the geometry
+  G4double m_radius = 0;
+  G4ThreeVector m_center;
+  G4int m_geometryVersion = -1;
+  G4double m_envelopeRadius = 0;
+  G4ThreeVector m_envelopeCenter;
+
+  static std::atomic<G4long> s_events;
+  static std::atomic<G4double> s_rate;
+
+  shared_ptr<G4UIcmdWithAString> m_sourceCmd;
+  shared_ptr<G4UIcmdWithADoubleAndUnit> m_muonEnergyCmd;
+  shared_ptr<G4UIcmdWithADouble> m_intensityCmd;
+  shared_ptr<G4UIcmdWithADoubleAndUnit> m_gammaEnergyCmd;
+  shared_ptr<G4UIcmdWithADouble> m_fluxCmd;
+  shared_ptr<G4UIcmdWith3Vector> m_upCmd;
+  shared_ptr<G4UIcmdWithADoubleAndUnit> m_radiusCmd;
+  shared_ptr<G4UIcmdWith3VectorAndUnit> m_centerCmd;
+};
+
+#endif
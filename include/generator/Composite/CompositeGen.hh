@@ -0,0 +1,107 @@
+/// \file CompositeGen.hh
+/// \brief Definition of the CompositeGen class
+
+#ifndef CompositeGen_h
+#define CompositeGen_h 1
+
+#include "G4VUserPrimaryGeneratorAction.hh"
+#include "G4VUserEventInformation.hh"
+#include "globals.hh"
+
+#include "G4UImessenger.hh"
+
+#include <memory>
+using std::shared_ptr;
+#include <vector>
+using std::vector;
+
+class G4UIcmdWithAString;
+class G4UIcmdWithoutParameter;
+
+class G4Event;
+
+/// Mixes several sources in one run: every event is generated by one of the
+/// components, chosen at random in proportion to their weights.
+///
+/// Every component is a generator of its own (any of the generators of the
+/// PrimaryGeneratorManager) with its commands in
+/// /PrimaryGenerator/Composite/<name>/. As these commands only exist once the
+/// component is added, they are given through set, which also works in
+/// multi-threaded mode where the worker threads add the components at the
+/// start of the next run:
+///
+///     /PrimaryGenerator/Composite/add 13C GammaDecayScheme 1
+///     /PrimaryGenerator/Composite/set 13C levelFile data/13N.txt
+///     /PrimaryGenerator/Composite/set 13C excitedState 2324 keV
+///     /PrimaryGenerator/Composite/add 27Al GammaDecayScheme 0.5
+///     /PrimaryGenerator/Composite/set 27Al levelFile data/28Si.txt
+///     /PrimaryGenerator/Composite/set 27Al excitedState 11900 keV
+///     /PrimaryGenerator/select Composite
+///
+/// The events are tagged with their component (CompositeEventInformation),
+/// and the EventAction fills a spectrum "h1_<name>" per component.
+
+class CompositeGen : public G4VUserPrimaryGeneratorAction, public G4UImessenger
+{
+public:
+  CompositeGen();
+  virtual ~CompositeGen();
+
+  virtual void GeneratePrimaries(G4Event* event);
+
+  void SetNewValue(G4UIcommand* command, G4String newValue);
+
+  /// Gamma lines of all components
+  void GetGammaLines(vector<G4double>& lines) const;
+
+private:
+  struct Component
+  {
+    G4String name;
+    G4String type;
+    G4double weight;
+    shared_ptr<G4VUserPrimaryGeneratorAction> generator;
+  };
+
+  void Add(const G4String& name, const G4String& type, const G4double weight);
+  void Set(const G4String& name, const G4String& command);
+
+  vector<Component> m_components;
+  vector<G4double> m_cumulativeWeights;
+
+  shared_ptr<G4UIcmdWithAString> m_addCmd;
+  shared_ptr<G4UIcmdWithAString> m_setCmd;
+  shared_ptr<G4UIcmdWithoutParameter> m_clearCmd;
+};
+
+/// Component of the CompositeGen that generated the event
+class CompositeEventInformation : public G4VUserEventInformation
+{
+public:
+  CompositeEventInformation(const G4int component, const G4String& name)
+      : G4VUserEventInformation(),
+        m_component(component),
+        m_name(name)
+  {}
+
+  G4int GetComponent() const
+  {
+    return m_component;
+  }
+
+  const G4String& GetName() const
+  {
+    return m_name;
+  }
+
+  virtual void Print() const
+  {
+    G4cout << "Composite component " << m_component << " (" << m_name << ")" << G4endl;
+  }
+
+private:
+  const G4int m_component;
+  const G4String m_name;
+};
+
+#endif
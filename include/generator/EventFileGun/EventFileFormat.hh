@@ -0,0 +1,48 @@
+/// \file EventFileFormat.hh
+/// \brief Layout of the binary event files read by the EventFileGun
+
+#ifndef EventFileFormat_h
+#define EventFileFormat_h 1
+
+#include <cstdint>
+
+/// Binary event file, written by G4_HPGe_convert and memory-mapped by the
+/// EventFileGun. All numbers are in native byte order (little endian on x86):
+///
+///     EventFileHeader                    32 bytes
+///     uint64  firstPrimary[nEvents+1]    index of the first primary of every
+///                                        event, the last entry is nPrimaries
+///     EventFilePrimary[nPrimaries]       56 bytes each, ordered by event
+///
+/// Energies are kinetic energies in MeV, positions in mm, times in ns. The
+/// direction does not need to be normalized.
+
+namespace EventFile
+{
+    const char magic[8] = {'G', '4', 'H', 'P', 'G', 'e', 'E', 'V'};
+    const uint32_t version = 1;
+}
+
+struct EventFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t primarySize;   // sizeof(EventFilePrimary)
+    uint64_t nEvents;
+    uint64_t nPrimaries;
+};
+
+struct EventFilePrimary
+{
+    int32_t pdg;            // PDG code, ions as 100ZZZAAAI
+    float weight;
+    double energy;
+    double x, y, z;
+    float dx, dy, dz;
+    float time;
+};
+
+static_assert(sizeof(EventFileHeader) == 32, "EventFileHeader does not match the file layout");
+static_assert(sizeof(EventFilePrimary) == 56, "EventFilePrimary does not match the file layout");
+
+#endif
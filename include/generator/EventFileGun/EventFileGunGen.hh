@@ -0,0 +1,85 @@
+/// \file EventFileGunGen.hh
+/// \brief Definition of the EventFileGunGen class
+
+#ifndef EventFileGunGen_h
+#define EventFileGunGen_h 1
+
+#include "G4VUserPrimaryGeneratorAction.hh"
+#include "globals.hh"
+
+#include "G4UImessenger.hh"
+
+#include "generator/EventFileGun/EventFileFormat.hh"
+
+#include <map>
+#include <memory>
+using std::shared_ptr;
+
+class G4UIcmdWithAString;
+class G4UIcmdWith3VectorAndUnit;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithABool;
+
+class G4ParticleDefinition;
+class G4Event;
+
+/// Reads the primaries (particle, energy, direction, vertex, time, weight)
+/// of every event from a binary event file (see EventFileFormat.hh), e.g.
+/// reaction kinematics from external codes converted with G4_HPGe_convert.
+///
+/// Every thread maps the file read-only. The events of the file are divided
+/// evenly among the shards, and the event ID of the run selects the record
+/// within the share of this shard: event i of every run uses record i,
+/// whichever thread simulates it. No locks are needed, no record is used
+/// twice before the run has more events than the share, and a phase-space
+/// file (PhaseSpaceRecorder) is replayed one-to-one. Beyond the share the
+/// records are used again from its beginning, with a warning.
+///
+/// Phase-space files can be replayed several times: with reuse N every
+/// record is used by N consecutive events with the weights divided by N,
+/// and with rotate every use is rotated by a random angle around the z axis
+/// (the beam axis) before the offset is applied.
+///
+///     /PrimaryGenerator/select EventFileGun
+///     /PrimaryGenerator/EventFileGun/file reaction.evt
+///     /PrimaryGenerator/EventFileGun/offset 0 0 -2.1 cm
+///     /PrimaryGenerator/EventFileGun/reuse 10
+///     /PrimaryGenerator/EventFileGun/rotate true
+
+
+class EventFileGunGen : public G4VUserPrimaryGeneratorAction, public G4UImessenger
+{
+public:
+  EventFileGunGen(const G4String& commandDir = "/PrimaryGenerator/EventFileGun/");
+  virtual ~EventFileGunGen();
+
+  virtual void GeneratePrimaries(G4Event* event);
+
+  void SetNewValue(G4UIcommand* command, G4String newValue);
+
+private:
+  void Open(const G4String& fileName);
+  void Close();
+
+  G4ParticleDefinition* GetDefinition(const int32_t pdg);
+
+  G4String m_fileName;
+  G4ThreeVector m_offset;
+  G4int m_reuse = 1;
+  G4bool m_rotate = false;
+
+  void* m_map = nullptr;
+  size_t m_mapSize = 0;
+  uint64_t m_nEvents = 0;
+  const uint64_t* m_firstPrimary = nullptr;
+  const EventFilePrimary* m_primaries = nullptr;
+
+  std::map<int32_t, G4ParticleDefinition*> m_definitions;
+
+  shared_ptr<G4UIcmdWithAString> m_fileCmd;
+  shared_ptr<G4UIcmdWith3VectorAndUnit> m_offsetCmd;
+  shared_ptr<G4UIcmdWithAnInteger> m_reuseCmd;
+  shared_ptr<G4UIcmdWithABool> m_rotateCmd;
+};
+
+#endif
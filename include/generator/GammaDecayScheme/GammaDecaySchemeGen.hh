@@ -6,12 +6,12 @@
 #include "G4VUserPrimaryGeneratorAction.hh"
 #include "G4UImessenger.hh"
 
-#include "TRandom.h"
-
 #include "CLHEP/Units/SystemOfUnits.h"
 
 #include <memory>
 using std::shared_ptr;
+#include <vector>
+using std::vector;
 
 class G4UIcmdWith3VectorAndUnit;
 class G4UIcmdWithAString;
@@ -42,13 +42,16 @@ using CLHEP::mm;
 class GammaDecaySchemeGen : public G4VUserPrimaryGeneratorAction, public G4UImessenger
 {
 public:
-    GammaDecaySchemeGen();
+    GammaDecaySchemeGen(const G4String& commandDir = "/PrimaryGenerator/GammaDecayScheme/");
     virtual ~GammaDecaySchemeGen() {};
 
     void GeneratePrimaries(G4Event* anEvent);
 
     void SetNewValue(G4UIcommand* command, G4String newValue);
 
+    // Transition energies below the selected excited state
+    void GetGammaLines(vector<G4double>& lines) const;
+
 private:
     shared_ptr<LevelScheme> m_levels; // Level scheme with selected initial level, used to generate decay gammas
 
@@ -57,7 +60,6 @@ private:
 
     G4double beam_sigma = 1 * mm;
 
-    TRandom* rand;
     G4double theta;
     G4double offset;
     G4double offsetX;
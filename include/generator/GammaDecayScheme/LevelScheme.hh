@@ -28,8 +28,12 @@ class LevelScheme {
         G4bool IsAtEndState() const {return currentLevel->IsEndState();}
         G4double Decay();
 
+        // Energies of all transitions reachable from the start level
+        void GetTransitionEnergies(vector<G4double> &energies) const;
+
     private:
         void CheckConsistency(G4double startEnergy);
+        void AddTransitionEnergies(G4double energy, vector<G4double> &energies) const;
         map<G4double, shared_ptr<Level>> levels;
         shared_ptr<Level> startLevel, currentLevel;
 
@@ -11,12 +11,16 @@
 
 #include <memory>
 using std::shared_ptr;
+#include <vector>
 
 class G4UIcmdWith3VectorAndUnit;
 class G4UIcmdWithADoubleAndUnit;
 class G4UIcmdWithADouble;
+class G4UIcmdWithAString;
 
 class G4ParticleGun;
+class G4Navigator;
+class G4ParticleDefinition;
 class G4Event;
 
 /// The primary generator action class with particle gun.
@@ -27,28 +31,50 @@ class G4Event;
 /// energy and position of the gamma.
 /// The direction of the particle is sampled randomly for every event, thus
 /// setting the direction in the macro using /gun/direction will be disregarded.
+/// With /RayTrace/bias the directions favour the detector (EmissionBias).
+/// The particle is a gamma unless chosen otherwise with
+/// /PrimaryGenerator/IsotropicGun/particle (e.g. geantino for navigation
+/// benchmarks).
+/// With /PrimaryGenerator/IsotropicGun/confine <object> the vertex is drawn
+/// uniformly in the mass of the volumes of a GeometryObject that lie within
+/// the box "position" +- "halfSize", e.g. to check the adjoint responses
+/// (AdjointSimulation) with a forward run.
 
 
 class IsotropicGunGen : public G4VUserPrimaryGeneratorAction, public G4UImessenger
 {
 public:
-  IsotropicGunGen();
+  IsotropicGunGen(const G4String& commandDir = "/PrimaryGenerator/IsotropicGun/");
   virtual ~IsotropicGunGen();
 
   virtual void GeneratePrimaries(G4Event* event);
 
   void SetNewValue(G4UIcommand* command, G4String newValue);
+
+  // The gun energy if it shoots gammas
+  void GetGammaLines(std::vector<G4double>& lines) const;
   
 private:
+  // vertex uniform in the mass of the confining object
+  G4ThreeVector SampleConfinedPosition();
+
   G4ParticleGun*  fParticleGun;
+  G4Navigator* m_navigator = nullptr;
+
+  G4String m_confine;
+  G4ThreeVector m_halfSize;
 
   G4ThreeVector m_position;
-  G4double m_energy;
-  G4double m_number;
+  G4double m_energy = 0;
+  G4double m_number = 1;
+  G4ParticleDefinition* m_particle = nullptr;
 
   shared_ptr<G4UIcmdWith3VectorAndUnit> m_setPositionCmd;
   shared_ptr<G4UIcmdWithADoubleAndUnit> m_selectEnergyCmd;
   shared_ptr<G4UIcmdWithADouble> m_selectNParticlesCmd;
+  shared_ptr<G4UIcmdWithAString> m_selectParticleCmd;
+  shared_ptr<G4UIcmdWithAString> m_confineCmd;
+  shared_ptr<G4UIcmdWith3VectorAndUnit> m_halfSizeCmd;
 
 };
 
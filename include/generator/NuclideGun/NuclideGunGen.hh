@@ -36,7 +36,6 @@
 #include "G4VUserPrimaryGeneratorAction.hh"
 #include "G4ParticleGun.hh"
 #include "globals.hh"
-#include "TRandom.h"
 
 #include "G4UImessenger.hh"
 
@@ -55,7 +54,7 @@ class G4Event;
 class NuclideGunGen : public G4VUserPrimaryGeneratorAction, public G4UImessenger
 {
   public:
-    NuclideGunGen();    
+    NuclideGunGen(const G4String& commandDir = "/PrimaryGenerator/NuclideGun/");    
    ~NuclideGunGen();
 
   public:
@@ -72,7 +71,6 @@ class NuclideGunGen : public G4VUserPrimaryGeneratorAction, public G4UImessenger
 
     G4double beam_sigma = 6 * CLHEP::mm;
     
-    TRandom* rand;
     G4double theta;
     G4double offset;
     G4double offsetX;
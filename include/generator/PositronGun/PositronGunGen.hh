@@ -9,7 +9,6 @@
 #include "globals.hh"
 
 #include "TGraph.h"
-#include "TRandom.h"
 #include "TSpline.h"
 
 class G4ParticleGun;
@@ -33,7 +32,7 @@ using std::shared_ptr;
 class PositronGunGen : public G4VUserPrimaryGeneratorAction, public G4UImessenger
 {
 public:
-  PositronGunGen();
+  PositronGunGen(const G4String& commandDir = "/PrimaryGenerator/PositronGun/");
   virtual ~PositronGunGen();
 
   virtual void GeneratePrimaries(G4Event* event);
@@ -48,8 +47,6 @@ private:
   G4String m_file;
   TGraph* m_graph;
   TSpline3* m_pdf;
-  
-  TRandom* rand;
 
   G4double energy;
   G4double prob;
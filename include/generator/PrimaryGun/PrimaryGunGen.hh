@@ -38,7 +38,7 @@ class G4Event;
 class PrimaryGunGen : public G4VUserPrimaryGeneratorAction, public G4UImessenger
 {
 public:
-  PrimaryGunGen();
+  PrimaryGunGen(const G4String& commandDir = "/PrimaryGenerator/PrimaryGun/");
   virtual ~PrimaryGunGen();
 
   virtual void GeneratePrimaries(G4Event* event);
@@ -3,27 +3,50 @@
 #include "PrimaryGeneratorAction.hh"
 #include "PrimaryGeneratorManager.hh"
 #include "EventAction.hh"
+#include "RunAction.hh"
+#include "StackingAction.hh"
 #include "SteppingAction.hh"
+#include "AdjointSimulation.hh"
+
+#include "G4AdjointSimManager.hh"
 
 #include "G4SystemOfUnits.hh"
 using CLHEP::keV;
 
-ActionInitialization::ActionInitialization()
-    : G4VUserActionInitialization()
+ActionInitialization::ActionInitialization(const G4String& outputFileName)
+    : G4VUserActionInitialization(),
+      m_outputFileName(outputFileName)
 {
     m_energyHistogram = new EnergyHistogram(16384, 0.0, 16.3840);
+    m_runControl = new RunControl(m_energyHistogram);
+    m_liveExport = new LiveExport(m_energyHistogram);
+    m_decayChainLimits = new DecayChainLimits();
+    m_phaseSpaceRecorder = new PhaseSpaceRecorder();
+    m_asyncWriter = new AsyncWriter(m_energyHistogram, m_outputFileName);
 }
 
 
 ActionInitialization::~ActionInitialization()
 {
-    m_energyHistogram->Write("./sim.root");
+    // the tree may already be in the output file, written by the AsyncWriter
+    m_asyncWriter->Stop();
+    if (!m_outputFileName.empty())
+    {
+        m_energyHistogram->Write(m_outputFileName, m_asyncWriter->HasWrittenOutputFile());
+    }
+    delete m_asyncWriter;
+    delete m_phaseSpaceRecorder;
+    delete m_decayChainLimits;
+    delete m_liveExport;
+    delete m_runControl;
     delete m_energyHistogram;
 }
 
 
 void ActionInitialization::BuildForMaster() const
 {
+    SetUserAction(new RunAction(m_runControl, m_liveExport, m_decayChainLimits, m_phaseSpaceRecorder,
+                                m_asyncWriter));
 }
 
 
@@ -31,8 +54,28 @@ void ActionInitialization::Build() const
 {
     SetUserAction(new PrimaryGeneratorManager());
 
-    auto eventAction = new EventAction(m_energyHistogram);
+    auto runAction = new RunAction(m_runControl, m_liveExport, m_decayChainLimits, m_phaseSpaceRecorder,
+                                   m_asyncWriter);
+    SetUserAction(runAction);
+
+    auto phaseSpaceWriter = m_phaseSpaceRecorder->CreateWriter();
+
+    auto eventAction = new EventAction(m_energyHistogram, m_runControl, phaseSpaceWriter,
+                                       m_asyncWriter->CreateBuffer());
     SetUserAction(eventAction);
 
-    SetUserAction(new SteppingAction(eventAction));
+    auto steppingAction = new SteppingAction(eventAction, phaseSpaceWriter);
+    SetUserAction(steppingAction);
+
+    SetUserAction(new StackingAction(m_decayChainLimits));
+
+    // the reverse Monte Carlo swaps the user actions for its own during its
+    // runs and calls these from them, in both phases of an event
+    if (AdjointSimulation::IsEnabled())
+    {
+        G4AdjointSimManager* adjointSimManager = G4AdjointSimManager::GetInstance();
+        adjointSimManager->SetAdjointRunAction(runAction);
+        adjointSimManager->SetAdjointEventAction(eventAction);
+        adjointSimManager->SetAdjointSteppingAction(steppingAction);
+    }
 }
@@ -0,0 +1,106 @@
+#include "AdjointPhysicsList.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicsListHelper.hh"
+#include "G4ProcessManager.hh"
+
+#include "G4BosonConstructor.hh"
+#include "G4LeptonConstructor.hh"
+#include "G4BaryonConstructor.hh"
+#include "G4IonConstructor.hh"
+#include "G4AdjointGamma.hh"
+#include "G4AdjointElectron.hh"
+#include "G4Gamma.hh"
+#include "G4Electron.hh"
+#include "G4Positron.hh"
+
+#include "G4ComptonScattering.hh"
+#include "G4PhotoElectricEffect.hh"
+#include "G4GammaConversion.hh"
+#include "G4eMultipleScattering.hh"
+#include "G4eIonisation.hh"
+#include "G4eBremsstrahlung.hh"
+#include "G4eplusAnnihilation.hh"
+
+#include "G4AdjointCSManager.hh"
+#include "G4AdjointSimManager.hh"
+#include "G4AdjointComptonModel.hh"
+#include "G4eInverseCompton.hh"
+#include "G4AdjointAlongStepWeightCorrection.hh"
+
+AdjointPhysicsList::AdjointPhysicsList()
+    : G4VUserPhysicsList()
+{
+    SetVerboseLevel(1);
+}
+
+void AdjointPhysicsList::ConstructParticle()
+{
+    G4BosonConstructor bosonConstructor;
+    bosonConstructor.ConstructParticle();
+
+    G4LeptonConstructor leptonConstructor;
+    leptonConstructor.ConstructParticle();
+
+    G4BaryonConstructor baryonConstructor;
+    baryonConstructor.ConstructParticle();
+
+    G4IonConstructor ionConstructor;
+    ionConstructor.ConstructParticle();
+
+    G4AdjointGamma::AdjointGammaDefinition();
+    G4AdjointElectron::AdjointElectronDefinition();
+}
+
+void AdjointPhysicsList::ConstructProcess()
+{
+    AddTransportation();
+
+    G4PhysicsListHelper* helper = G4PhysicsListHelper::GetPhysicsListHelper();
+    G4AdjointCSManager* csManager = G4AdjointCSManager::GetAdjointCSManager();
+    csManager->RegisterAdjointParticle(G4AdjointGamma::AdjointGamma());
+
+    // forward photons, their cross sections define the adjoint ones
+    G4ParticleDefinition* gamma = G4Gamma::Gamma();
+    auto compton = new G4ComptonScattering();
+    auto photoElectric = new G4PhotoElectricEffect();
+    auto conversion = new G4GammaConversion();
+    helper->RegisterProcess(compton, gamma);
+    helper->RegisterProcess(photoElectric, gamma);
+    helper->RegisterProcess(conversion, gamma);
+    csManager->RegisterEmProcess(compton, gamma);
+    csManager->RegisterEmProcess(photoElectric, gamma);
+    csManager->RegisterEmProcess(conversion, gamma);
+
+    // forward electrons and positrons, only tracked in the forward phase
+    G4ParticleDefinition* electron = G4Electron::Electron();
+    helper->RegisterProcess(new G4eMultipleScattering(), electron);
+    helper->RegisterProcess(new G4eIonisation(), electron);
+    helper->RegisterProcess(new G4eBremsstrahlung(), electron);
+
+    G4ParticleDefinition* positron = G4Positron::Positron();
+    helper->RegisterProcess(new G4eMultipleScattering(), positron);
+    helper->RegisterProcess(new G4eIonisation(), positron);
+    helper->RegisterProcess(new G4eBremsstrahlung(), positron);
+    helper->RegisterProcess(new G4eplusAnnihilation(), positron);
+
+    // adjoint gammas: the scattered gamma becomes the incident one
+    auto comptonModel = new G4AdjointComptonModel();
+    comptonModel->SetLowEnergyLimit(1*keV);
+    comptonModel->SetHighEnergyLimit(GetMaxEnergy());
+    comptonModel->SetDirectProcess(compton);
+    comptonModel->SetUseMatrix(false);
+
+    G4ProcessManager* adjointGamma = G4AdjointGamma::AdjointGamma()->GetProcessManager();
+    adjointGamma->AddProcess(new G4AdjointAlongStepWeightCorrection(), -1, 1, 1);
+    adjointGamma->AddDiscreteProcess(new G4eInverseCompton(true, "Inv_Compt", comptonModel));
+
+    G4AdjointSimManager::GetInstance()->ConsiderParticleAsPrimary("gamma");
+}
+
+void AdjointPhysicsList::SetCuts()
+{
+    SetCutValue(0.01*mm, "e-");
+    SetCutValue(0.01*mm, "e+");
+    SetCutValue(0.01*mm, "gamma");
+}
@@ -0,0 +1,394 @@
+#include "AdjointSimulation.hh"
+
+#include "AdjointPhysicsList.hh"
+#include "DetectorConstruction.hh"
+#include "EnergyHistogram.hh"
+#include "GeometryObject.hh"
+#include "HPGeDetector.hh"
+
+#include "G4AdjointGamma.hh"
+#include "G4AdjointSimManager.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4Material.hh"
+#include "G4RunManager.hh"
+#include "G4Step.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+using CLHEP::keV;
+using CLHEP::kg;
+using CLHEP::pi;
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include <memory>
+using std::make_shared;
+
+#include <stdexcept>
+using std::runtime_error;
+
+namespace
+{
+    // Placement of volume below mother, null if there is none
+    G4VPhysicalVolume* FindPhysical(const G4LogicalVolume* mother, const G4LogicalVolume* volume)
+    {
+        for (size_t i = 0; i < mother->GetNoDaughters(); i++)
+        {
+            G4VPhysicalVolume* daughter = mother->GetDaughter(i);
+            if (daughter->GetLogicalVolume() == volume)
+            {
+                return daughter;
+            }
+            G4VPhysicalVolume* physical = FindPhysical(daughter->GetLogicalVolume(), volume);
+            if (physical)
+            {
+                return physical;
+            }
+        }
+        return nullptr;
+    }
+
+    // deposits this close to the energy of the adjoint gamma count as full-energy peak
+    const G4double peakTolerance = 1*keV;
+}
+
+AdjointSimulation* AdjointSimulation::s_instance = nullptr;
+
+AdjointSimulation::AdjointSimulation(DetectorConstruction* detectorConstruction, EnergyHistogram* energyHistogram)
+    : G4UImessenger(),
+      m_detectorConstruction(detectorConstruction),
+      m_energyHistogram(energyHistogram),
+      m_window(2*keV),
+      m_minEnergy(20*keV)
+{
+    s_instance = this;
+
+    m_lineCmd = make_shared<G4UIcmdWithAString>("/Adjoint/line", this);
+    m_lineCmd->SetGuidance("Add a gamma line of the sources: \"energy unit yield\" (gammas per decay).");
+    m_lineCmd->SetParameterName("line", false);
+    m_lineCmd->SetToBeBroadcasted(false);
+
+    m_clearLinesCmd = make_shared<G4UIcmdWithoutParameter>("/Adjoint/clearLines", this);
+    m_clearLinesCmd->SetGuidance("Forget the gamma lines.");
+    m_clearLinesCmd->SetToBeBroadcasted(false);
+
+    m_windowCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/Adjoint/window", this);
+    m_windowCmd->SetGuidance("Width of the energy window around each line (default 2 keV).");
+    m_windowCmd->SetParameterName("window", false);
+    m_windowCmd->SetRange("window > 0");
+    m_windowCmd->SetUnitCategory("Energy");
+    m_windowCmd->SetToBeBroadcasted(false);
+
+    m_minEnergyCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/Adjoint/minEnergy", this);
+    m_minEnergyCmd->SetGuidance("Lowest energy of the gammas entering the crystal (default 20 keV),");
+    m_minEnergyCmd->SetGuidance("the spectra miss the deposits below.");
+    m_minEnergyCmd->SetParameterName("energy", false);
+    m_minEnergyCmd->SetRange("energy > 0");
+    m_minEnergyCmd->SetUnitCategory("Energy");
+    m_minEnergyCmd->SetToBeBroadcasted(false);
+
+    m_beamOnCmd = make_shared<G4UIcmdWithAnInteger>("/Adjoint/beamOn", this);
+    m_beamOnCmd->SetGuidance("Run N adjoint events and print the response to the lines of every object.");
+    m_beamOnCmd->SetParameterName("N", false);
+    m_beamOnCmd->SetRange("N > 0");
+    m_beamOnCmd->SetToBeBroadcasted(false);
+}
+
+void AdjointSimulation::AddMasses(G4VPhysicalVolume* physical, const G4double copies)
+{
+    // the daughters displace the material of their mother
+    const G4LogicalVolume* logical = physical->GetLogicalVolume();
+    const G4double n = copies*physical->GetMultiplicity();
+    G4double ownVolume = logical->GetSolid()->GetCubicVolume();
+    for (size_t i = 0; i < logical->GetNoDaughters(); i++)
+    {
+        G4VPhysicalVolume* daughter = logical->GetDaughter(i);
+        ownVolume -= daughter->GetMultiplicity()*daughter->GetLogicalVolume()->GetSolid()->GetCubicVolume();
+        AddMasses(daughter, n);
+    }
+
+    const auto object = m_objectIndex.find(logical);
+    if (object != m_objectIndex.end())
+    {
+        m_objects[object->second].mass += n*std::max(ownVolume, 0.)*logical->GetMaterial()->GetDensity();
+    }
+}
+
+void AdjointSimulation::Prepare()
+{
+    // closes the geometry and builds the physics tables
+    G4RunManager::GetRunManager()->BeamOn(0);
+
+    // the volumes of an object are named "<object>_..._logical"
+    m_objects.clear();
+    m_objectIndex.clear();
+    HPGeDetector* hpgeDetector = m_detectorConstruction->GetHPGeDetector();
+    for (GeometryObject* geometryObject : m_detectorConstruction->GetGeometryObjects())
+    {
+        const G4String prefix = geometryObject->GetName() + "_";
+        const G4int index = static_cast<G4int>(m_objects.size());
+        m_objects.push_back({geometryObject->GetName(), 0});
+        for (const G4LogicalVolume* logical : *G4LogicalVolumeStore::GetInstance())
+        {
+            if (logical->GetName().compare(0, prefix.size(), prefix) == 0
+                && logical != hpgeDetector->GetCrystalVolume() && logical != hpgeDetector->GetScoringVolume())
+            {
+                m_objectIndex[logical] = index;
+            }
+        }
+    }
+
+    G4VPhysicalVolume* world = m_detectorConstruction->GetWorldVolume();
+    AddMasses(world, 1);
+
+    // adjoint gammas start on the crystal with the energies of the forward
+    // gammas entering it, and only score up to the highest line
+    G4double maxEnergy = 0;
+    for (const Line& line : m_lines)
+    {
+        maxEnergy = std::max(maxEnergy, line.energy + 0.5*m_window);
+    }
+    m_maxEnergy = maxEnergy;
+    if (m_minEnergy >= maxEnergy)
+    {
+        throw runtime_error("AdjointSimulation: the minimum energy is above all lines");
+    }
+
+    const G4VPhysicalVolume* crystal = FindPhysical(world->GetLogicalVolume(), hpgeDetector->GetCrystalVolume());
+    if (!crystal)
+    {
+        throw runtime_error("AdjointSimulation: the HPGe detector is not built");
+    }
+
+    G4AdjointSimManager* adjointSimManager = G4AdjointSimManager::GetInstance();
+    if (!adjointSimManager->DefineAdjointSourceOnTheExtSurfaceOfAVolume(crystal->GetName()))
+    {
+        throw runtime_error("AdjointSimulation: cannot place the adjoint source on " + crystal->GetName());
+    }
+    adjointSimManager->SetAdjointSourceEmin(m_minEnergy);
+    adjointSimManager->SetAdjointSourceEmax(maxEnergy);
+
+    // the external source only ends the adjoint tracks, a sphere just inside
+    // the world. Without reaching it an event has no forward phase and no
+    // deposit, so the tracks must not end above the highest line: a gamma
+    // that scored usually scatters to higher energies on its way out.
+    G4ThreeVector worldMin, worldMax;
+    world->GetLogicalVolume()->GetSolid()->BoundingLimits(worldMin, worldMax);
+    const G4ThreeVector halfSize = 0.5*(worldMax - worldMin);
+    const G4double radius = 0.99*std::min({halfSize.x(), halfSize.y(), halfSize.z()});
+    if (!adjointSimManager->DefineSphericalExtSourceWithCentreAtTheCentreOfAVolume(radius, world->GetName()))
+    {
+        throw runtime_error("AdjointSimulation: cannot define the external source");
+    }
+    adjointSimManager->SetExtSourceEmax(AdjointPhysicsList::GetMaxEnergy());
+}
+
+G4bool AdjointSimulation::Step(const G4Step* step)
+{
+    if (!s_instance || !s_instance->m_running || !G4AdjointSimManager::GetInstance()->GetAdjointTrackingMode())
+    {
+        return false;
+    }
+
+    AdjointSimulation* self = s_instance;
+    const G4StepPoint* preStepPoint = step->GetPreStepPoint();
+    if (step->GetTrack()->GetDefinition() != G4AdjointGamma::AdjointGamma())
+    {
+        return true;
+    }
+
+    const G4double energy = preStepPoint->GetKineticEnergy();
+    if (energy > self->m_maxEnergy)
+    {
+        return true;
+    }
+
+    const auto object = self->m_objectIndex.find(preStepPoint->GetTouchableHandle()->GetVolume()->GetLogicalVolume());
+    if (object == self->m_objectIndex.end() || self->m_objects[object->second].mass <= 0)
+    {
+        return true;
+    }
+
+    // track-length estimate of the response to a uniform, isotropic source
+    const G4double score = preStepPoint->GetWeight()*step->GetStepLength()*preStepPoint->GetMaterial()->GetDensity()
+                           /(4*pi*self->m_objects[object->second].mass*self->m_window);
+    for (size_t i = 0; i < self->m_lines.size(); i++)
+    {
+        if (std::abs(energy - self->m_lines[i].energy) <= 0.5*self->m_window)
+        {
+            self->m_eventScores.push_back({object->second, static_cast<G4int>(i), energy, score});
+        }
+    }
+    return true;
+}
+
+G4bool AdjointSimulation::EndOfEvent(const G4double edep)
+{
+    if (!s_instance || !s_instance->m_running)
+    {
+        return false;
+    }
+
+    AdjointSimulation* self = s_instance;
+    const size_t nLines = self->m_lines.size();
+    std::fill(self->m_eventTotal.begin(), self->m_eventTotal.end(), 0.);
+    std::fill(self->m_eventPeak.begin(), self->m_eventPeak.end(), 0.);
+    if (!self->m_eventScores.empty() && !G4AdjointSimManager::GetInstance()->GetDidAdjParticleReachTheExtSource())
+    {
+        // lost: the event had no forward phase
+        self->m_lostEvents++;
+    }
+    if (edep > 0)
+    {
+        for (const Score& score : self->m_eventScores)
+        {
+            const size_t i = score.object*nLines + score.line;
+            self->m_eventTotal[i] += score.value;
+            if (edep > score.energy - peakTolerance)
+            {
+                self->m_eventPeak[i] += score.value;
+            }
+        }
+    }
+    self->m_eventScores.clear();
+
+    for (size_t object = 0; object < self->m_objects.size(); object++)
+    {
+        G4double perDecay = 0;
+        for (size_t line = 0; line < nLines; line++)
+        {
+            const size_t i = object*nLines + line;
+            self->m_total[i] += self->m_eventTotal[i];
+            self->m_total2[i] += self->m_eventTotal[i]*self->m_eventTotal[i];
+            self->m_peak[i] += self->m_eventPeak[i];
+            self->m_peak2[i] += self->m_eventPeak[i]*self->m_eventPeak[i];
+            perDecay += self->m_lines[line].yield*self->m_eventTotal[i];
+        }
+        if (perDecay > 0)
+        {
+            self->m_energyHistogram->FillComponent("adjoint_" + self->m_objects[object].name, edep,
+                                                   perDecay/self->m_nEvents);
+        }
+    }
+    return true;
+}
+
+void AdjointSimulation::BeamOn(const G4int nEvents)
+{
+    if (m_lines.empty())
+    {
+        throw runtime_error("AdjointSimulation: no lines given (/Adjoint/line)");
+    }
+
+    Prepare();
+
+    const size_t nScores = m_objects.size()*m_lines.size();
+    m_eventScores.clear();
+    m_eventTotal.assign(nScores, 0);
+    m_eventPeak.assign(nScores, 0);
+    m_total.assign(nScores, 0);
+    m_total2.assign(nScores, 0);
+    m_peak.assign(nScores, 0);
+    m_peak2.assign(nScores, 0);
+
+    m_energyHistogram->Reset();
+    m_nEvents = nEvents;
+    m_lostEvents = 0;
+    m_running = true;
+    try
+    {
+        G4AdjointSimManager::GetInstance()->RunAdjointSimulation(nEvents);
+    }
+    catch (...)
+    {
+        m_running = false;
+        throw;
+    }
+    m_running = false;
+
+    PrintResults();
+}
+
+void AdjointSimulation::PrintResults() const
+{
+    // mean over the events and its standard deviation
+    const G4double n = m_nEvents;
+    auto mean = [n](const G4double sum) {return sum/n;};
+    auto sigma = [n](const G4double sum, const G4double sum2)
+    {
+        return std::sqrt(std::max(sum2/n - (sum/n)*(sum/n), 0.)/n);
+    };
+
+    G4cout << "AdjointSimulation: response per emitted gamma after " << m_nEvents << " events" << G4endl;
+    if (m_lostEvents > 0)
+    {
+        G4cout << "AdjointSimulation: " << m_lostEvents << " events with scores did not reach the external source"
+               << " and are missing, the responses are low by about that fraction of the scoring events" << G4endl;
+    }
+    const size_t nLines = m_lines.size();
+    for (size_t object = 0; object < m_objects.size(); object++)
+    {
+        if (m_objects[object].mass <= 0)
+        {
+            continue;
+        }
+
+        G4cout << "  " << m_objects[object].name << " (" << m_objects[object].mass/kg << " kg)" << G4endl;
+        G4double total = 0, peak = 0;
+        for (size_t line = 0; line < nLines; line++)
+        {
+            const size_t i = object*nLines + line;
+            G4cout << "    " << m_lines[line].energy/keV << " keV: total " << mean(m_total[i])
+                   << " +- " << sigma(m_total[i], m_total2[i]) << ", full-energy peak " << mean(m_peak[i])
+                   << " +- " << sigma(m_peak[i], m_peak2[i]) << G4endl;
+            total += m_lines[line].yield*mean(m_total[i]);
+            peak += m_lines[line].yield*mean(m_peak[i]);
+        }
+        G4cout << "    per decay: total " << total << ", full-energy peaks " << peak << G4endl;
+    }
+}
+
+void AdjointSimulation::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_lineCmd.get())
+    {
+        std::istringstream input(newValue);
+        G4double energy, yield;
+        G4String unit;
+        if (!(input >> energy >> unit >> yield) || energy <= 0 || yield < 0)
+        {
+            G4cerr << "Expected \"energy unit yield\", got '" << newValue << "'." << G4endl;
+            return;
+        }
+        m_lines.push_back({energy*G4UIcommand::ValueOf(unit), yield});
+    }
+    else if (command == m_clearLinesCmd.get())
+    {
+        m_lines.clear();
+    }
+    else if (command == m_windowCmd.get())
+    {
+        m_window = m_windowCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_minEnergyCmd.get())
+    {
+        m_minEnergy = m_minEnergyCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_beamOnCmd.get())
+    {
+        BeamOn(m_beamOnCmd->GetNewIntValue(newValue));
+    }
+    else
+    {
+        throw runtime_error("Unknown command in AdjointSimulation::SetNewValue()");
+    }
+}
@@ -0,0 +1,430 @@
+#include "AsyncWriter.hh"
+
+#include "EnergyHistogram.hh"
+
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+#include "TROOT.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TH1D.h"
+
+#include <chrono>
+#include <cstring>
+
+#include <memory>
+using std::make_shared;
+
+#include <stdexcept>
+using std::runtime_error;
+
+AsyncWriter::Buffer::Buffer(AsyncWriter* writer)
+    : m_writer(writer)
+{
+    m_energies.reserve(blockSize);
+}
+
+void AsyncWriter::Buffer::Flush()
+{
+    if (m_energies.empty())
+    {
+        return;
+    }
+
+    auto job = new Job();
+    job->type = Job::jobEvents;
+    job->runID = m_writer->m_runID;
+    job->perRun = m_writer->m_perRun;
+    job->energies.swap(m_energies);
+    m_energies.reserve(blockSize);
+    m_writer->Push(job);
+}
+
+AsyncWriter::AsyncWriter(EnergyHistogram* energyHistogram, const G4String& outputFileName)
+    : G4UImessenger(),
+      m_energyHistogram(energyHistogram),
+      m_outputFileName(outputFileName)
+{
+    m_asyncCmd = make_shared<G4UIcmdWithABool>("/Output/async", this);
+    m_asyncCmd->SetGuidance("Write the event tree t1 from a separate thread while the run goes on,");
+    m_asyncCmd->SetGuidance("instead of keeping it in memory until the end.");
+    m_asyncCmd->SetParameterName("async", false);
+    m_asyncCmd->SetToBeBroadcasted(false);
+
+    m_perRunCmd = make_shared<G4UIcmdWithABool>("/Output/perRun", this);
+    m_perRunCmd->SetGuidance("Write h1 and t1 of every run into a file of its own, <output>_run<N>.root");
+    m_perRunCmd->SetGuidance("(with /Output/async only).");
+    m_perRunCmd->SetParameterName("perRun", false);
+    m_perRunCmd->SetToBeBroadcasted(false);
+
+    m_queueSizeCmd = make_shared<G4UIcmdWithAnInteger>("/Output/queueSize", this);
+    m_queueSizeCmd->SetGuidance("Number of blocks of 4096 events waiting for the writer thread, before");
+    m_queueSizeCmd->SetGuidance("the event loops wait (rounded up to a power of 2). Only before the first");
+    m_queueSizeCmd->SetGuidance("asynchronous run.");
+    m_queueSizeCmd->SetParameterName("blocks", false);
+    m_queueSizeCmd->SetRange("blocks >= 2");
+    m_queueSizeCmd->SetToBeBroadcasted(false);
+}
+
+AsyncWriter::~AsyncWriter()
+{
+    Stop();
+}
+
+AsyncWriter::Buffer* AsyncWriter::CreateBuffer()
+{
+    G4AutoLock lock(&m_buffersMutex);
+    m_buffers.emplace_back(new Buffer(this));
+    return m_buffers.back().get();
+}
+
+void AsyncWriter::BeginOfRun(const G4int runID)
+{
+    m_runID = runID;
+    m_stalls = 0;
+    m_energyHistogram->SetFillTree(!m_enabled);
+    if (m_enabled)
+    {
+        Start();
+    }
+
+    m_runStart.clear();
+    if (m_enabled && m_perRun)
+    {
+        m_energyHistogram->CloneHistograms(m_runStart);
+    }
+}
+
+void AsyncWriter::EndOfRun()
+{
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+
+    FlushBuffers();
+    if (m_enabled && m_perRun)
+    {
+        auto job = new Job();
+        job->type = Job::jobEndOfRun;
+        job->runID = m_runID;
+        job->perRun = true;
+        m_energyHistogram->CloneHistograms(job->histograms);
+
+        // the spectra add up all runs, the file gets this run's share
+        for (auto& histogram : job->histograms)
+        {
+            for (const auto& start : m_runStart)
+            {
+                if (std::strcmp(start->GetName(), histogram->GetName()) != 0)
+                {
+                    continue;
+                }
+                const G4double entries = histogram->GetEntries() - start->GetEntries();
+                const G4bool sumw2 = histogram->GetSumw2N() > 0 && start->GetSumw2N() > 0;
+                for (G4int bin = 0; bin <= histogram->GetNbinsX() + 1; bin++)
+                {
+                    histogram->SetBinContent(bin, histogram->GetBinContent(bin) - start->GetBinContent(bin));
+                    if (sumw2)
+                    {
+                        (*histogram->GetSumw2())[bin] -= (*start->GetSumw2())[bin];
+                    }
+                }
+                histogram->ResetStats();
+                histogram->SetEntries(entries);
+                break;
+            }
+        }
+        m_runStart.clear();
+        Push(job);
+    }
+
+    CheckWriter();
+
+    if (m_stalls > 0)
+    {
+        G4cout << "AsyncWriter: the event loops waited " << m_stalls
+               << " times for the writer thread, consider a larger /Output/queueSize" << G4endl;
+    }
+}
+
+void AsyncWriter::CheckWriter() const
+{
+    if (m_failed)
+    {
+        throw runtime_error(m_error);
+    }
+}
+
+void AsyncWriter::Stop()
+{
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+
+    FlushBuffers();
+    auto job = new Job();
+    job->type = Job::jobStop;
+    job->runID = m_runID;
+    job->perRun = m_perRun;
+    Push(job);
+    m_thread.join();
+
+    if (m_failed)
+    {
+        G4cerr << m_error << G4endl;
+    }
+}
+
+void AsyncWriter::Start()
+{
+    if (m_thread.joinable())
+    {
+        return;
+    }
+
+    // TFile and TTree are used in two threads from now on
+    ROOT::EnableThreadSafety();
+
+    size_t capacity = 2;
+    while (capacity < static_cast<size_t>(m_queueSize))
+    {
+        capacity *= 2;
+    }
+    m_cells = vector<Cell>(capacity);
+    for (size_t i = 0; i < capacity; i++)
+    {
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    m_mask = capacity - 1;
+    m_pushPosition = 0;
+    m_popPosition = 0;
+
+    m_thread = std::thread(&AsyncWriter::Loop, this);
+}
+
+void AsyncWriter::FlushBuffers()
+{
+    // the event loops of all threads are finished, their buffers hold the
+    // last events of the run
+    G4AutoLock lock(&m_buffersMutex);
+    for (auto& buffer : m_buffers)
+    {
+        buffer->Flush();
+    }
+}
+
+void AsyncWriter::Push(Job* job)
+{
+    G4bool stalled = false;
+    size_t position = m_pushPosition.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell& cell = m_cells[position & m_mask];
+        const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (difference == 0)
+        {
+            if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                cell.job = job;
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return;
+            }
+        }
+        else if (difference < 0)
+        {
+            // full, wait for the writer
+            if (!stalled)
+            {
+                m_stalls++;
+                stalled = true;
+            }
+            std::this_thread::yield();
+            position = m_pushPosition.load(std::memory_order_relaxed);
+        }
+        else
+        {
+            position = m_pushPosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+AsyncWriter::Job* AsyncWriter::Pop()
+{
+    size_t position = m_popPosition.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell& cell = m_cells[position & m_mask];
+        const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+        if (difference == 0)
+        {
+            if (m_popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                Job* job = cell.job;
+                cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+                return job;
+            }
+        }
+        else if (difference < 0)
+        {
+            return nullptr;
+        }
+        else
+        {
+            position = m_popPosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void AsyncWriter::Loop()
+{
+    for (;;)
+    {
+        Job* job = Pop();
+        if (!job)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        // after an error the jobs are only taken off the queue, so that the
+        // event loops do not wait forever
+        const G4bool stop = (job->type == Job::jobStop);
+        if (!m_failed)
+        {
+            try
+            {
+                Process(job);
+            }
+            catch (const std::exception& error)
+            {
+                m_error = error.what();
+                m_failed = true;
+            }
+        }
+        delete job;
+        if (stop)
+        {
+            return;
+        }
+    }
+}
+
+void AsyncWriter::Process(Job* job)
+{
+    switch (job->type)
+    {
+    case Job::jobEvents:
+        OpenFile(job);
+        for (const G4double energy : job->energies)
+        {
+            m_energy = energy;
+            m_tree->Fill();
+        }
+        break;
+
+    case Job::jobEndOfRun:
+        OpenFile(job);
+        m_file->cd();
+        for (const auto& histogram : job->histograms)
+        {
+            histogram->Write();
+        }
+        CloseFile();
+        break;
+
+    case Job::jobStop:
+        CloseFile();
+        break;
+    }
+}
+
+void AsyncWriter::OpenFile(const Job* job)
+{
+    G4String fileName = m_outputFileName;
+    if (job->perRun)
+    {
+        const G4String suffix = ".root";
+        if (fileName.size() > suffix.size() && fileName.compare(fileName.size() - suffix.size(), suffix.size(), suffix) == 0)
+        {
+            fileName.erase(fileName.size() - suffix.size());
+        }
+        fileName += "_run" + std::to_string(job->runID) + ".root";
+    }
+
+    if (m_file && fileName == m_fileName)
+    {
+        return;
+    }
+    CloseFile();
+
+    // the output file is only added to if it was closed before (perRun
+    // switched on and off again)
+    const G4bool update = (fileName == m_outputFileName && m_outputFileWritten);
+    m_file = new TFile(fileName.c_str(), update ? "UPDATE" : "RECREATE");
+    if (m_file->IsZombie())
+    {
+        throw runtime_error("AsyncWriter: could not create " + fileName);
+    }
+    m_fileName = fileName;
+    if (fileName == m_outputFileName)
+    {
+        m_outputFileWritten = true;
+    }
+
+    // the baskets are written whenever they are full, the memory use stays
+    // the same however long the run is
+    m_tree = new TTree("t1", "t1");
+    m_tree->Branch("Energy", &m_energy, "Energy/D");
+}
+
+void AsyncWriter::CloseFile()
+{
+    if (!m_file)
+    {
+        return;
+    }
+
+    m_file->cd();
+    m_tree->Write();
+    m_file->Close();
+    delete m_file;
+    m_file = nullptr;
+    m_tree = nullptr;
+    m_fileName = "";
+}
+
+void AsyncWriter::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_asyncCmd.get())
+    {
+        const G4bool enabled = m_asyncCmd->GetNewBoolValue(newValue);
+        if (enabled && m_outputFileName.empty())
+        {
+            G4cerr << "AsyncWriter: there is no output file to write the tree into." << G4endl;
+            return;
+        }
+        m_enabled = enabled;
+    }
+    else if (command == m_perRunCmd.get())
+    {
+        m_perRun = m_perRunCmd->GetNewBoolValue(newValue);
+    }
+    else if (command == m_queueSizeCmd.get())
+    {
+        if (m_thread.joinable())
+        {
+            G4cerr << "AsyncWriter: the queue size can only be changed before the first asynchronous run." << G4endl;
+            return;
+        }
+        m_queueSize = m_queueSizeCmd->GetNewIntValue(newValue);
+    }
+    else
+    {
+        throw runtime_error("Unknown command in AsyncWriter::SetNewValue()");
+    }
+}
@@ -37,6 +37,19 @@
 #include "G4NuclearLevelData.hh"
 #include "G4DeexPrecoParameters.hh"
 #include "G4NuclideTable.hh"
+#include "G4NucleusLimits.hh"
+#include "G4ApplicationState.hh"
+
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAString.hh"
+
+#include <memory>
+using std::make_shared;
+
+#include <sstream>
+
+#include <stdexcept>
+using std::runtime_error;
 
 // factory
 #include "G4PhysicsConstructorFactory.hh"
@@ -52,6 +65,35 @@ BiasedRDPhysics::BiasedRDPhysics(G4int)
   deex->SetStoreICLevelData(true);
   deex->SetMaxLifeTime(G4NuclideTable::GetInstance()->GetThresholdOfHalfLife()
                        /std::log(2.));
+
+  // the settings are read when the processes are constructed
+  m_branchingRatioBiasCmd = make_shared<G4UIcmdWithABool>("/BiasedRD/branchingRatioBias", this);
+  m_branchingRatioBiasCmd->SetGuidance("Sample all decay branches with equal probability, weighted");
+  m_branchingRatioBiasCmd->SetGuidance("with their branching ratios.");
+  m_branchingRatioBiasCmd->SetParameterName("bias", false);
+  m_branchingRatioBiasCmd->AvailableForStates(G4State_PreInit);
+  m_branchingRatioBiasCmd->SetToBeBroadcasted(false);
+
+  m_nucleusLimitsCmd = make_shared<G4UIcmdWithAString>("/BiasedRD/nucleusLimits", this);
+  m_nucleusLimitsCmd->SetGuidance("Let only the nuclei within \"Amin Amax Zmin Zmax\" decay,");
+  m_nucleusLimitsCmd->SetGuidance("which ends the decay chains outside.");
+  m_nucleusLimitsCmd->SetParameterName("limits", false);
+  m_nucleusLimitsCmd->AvailableForStates(G4State_PreInit);
+  m_nucleusLimitsCmd->SetToBeBroadcasted(false);
+
+  m_sourceTimeProfileCmd = make_shared<G4UIcmdWithAString>("/BiasedRD/sourceTimeProfile", this);
+  m_sourceTimeProfileCmd->SetGuidance("File with the time profile of the source activity");
+  m_sourceTimeProfileCmd->SetGuidance("(lines of \"time [s]  intensity\").");
+  m_sourceTimeProfileCmd->SetParameterName("fileName", false);
+  m_sourceTimeProfileCmd->AvailableForStates(G4State_PreInit);
+  m_sourceTimeProfileCmd->SetToBeBroadcasted(false);
+
+  m_decayBiasProfileCmd = make_shared<G4UIcmdWithAString>("/BiasedRD/decayBiasProfile", this);
+  m_decayBiasProfileCmd->SetGuidance("File with the decay time windows and their bias");
+  m_decayBiasProfileCmd->SetGuidance("(lines of \"time [s]  probability\").");
+  m_decayBiasProfileCmd->SetParameterName("fileName", false);
+  m_decayBiasProfileCmd->AvailableForStates(G4State_PreInit);
+  m_decayBiasProfileCmd->SetToBeBroadcasted(false);
 }
 
 BiasedRDPhysics::BiasedRDPhysics(const G4String&)
@@ -80,7 +122,59 @@ void BiasedRDPhysics::ConstructProcess()
     ad->InitialiseAtomicDeexcitation();
   }
 
+  // called by the master and every worker, each with its own process
+  G4Radioactivation* radioactivation = new G4Radioactivation();
+  if (IsBiased()) {
+    radioactivation->SetAnalogueMonteCarlo(false);
+    radioactivation->SetBRBias(m_branchingRatioBias);
+    if (m_aMax > 0) {
+      radioactivation->SetNucleusLimits(G4NucleusLimits(m_aMin, m_aMax, m_zMin, m_zMax));
+    }
+    if (!m_sourceTimeProfile.empty()) {
+      radioactivation->SetSourceTimeProfile(m_sourceTimeProfile);
+    }
+    if (!m_decayBiasProfile.empty()) {
+      radioactivation->SetDecayBias(m_decayBiasProfile);
+    }
+  }
+
   G4PhysicsListHelper::GetPhysicsListHelper()->
-    RegisterProcess(new G4Radioactivation(), G4GenericIon::GenericIon());
+    RegisterProcess(radioactivation, G4GenericIon::GenericIon());
+}
+
+
+G4bool BiasedRDPhysics::IsBiased() const
+{
+  return m_branchingRatioBias || m_aMax > 0
+      || !m_sourceTimeProfile.empty() || !m_decayBiasProfile.empty();
+}
+
+
+void BiasedRDPhysics::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == m_branchingRatioBiasCmd.get()) {
+    m_branchingRatioBias = m_branchingRatioBiasCmd->GetNewBoolValue(newValue);
+  }
+  else if (command == m_nucleusLimitsCmd.get()) {
+    std::istringstream input(newValue);
+    G4int aMin, aMax, zMin, zMax;
+    if (!(input >> aMin >> aMax >> zMin >> zMax) || aMin > aMax || zMin > zMax || aMax <= 0) {
+      G4cerr << "Expected \"Amin Amax Zmin Zmax\", got '" << newValue << "'." << G4endl;
+      return;
+    }
+    m_aMin = aMin;
+    m_aMax = aMax;
+    m_zMin = zMin;
+    m_zMax = zMax;
+  }
+  else if (command == m_sourceTimeProfileCmd.get()) {
+    m_sourceTimeProfile = newValue;
+  }
+  else if (command == m_decayBiasProfileCmd.get()) {
+    m_decayBiasProfile = newValue;
+  }
+  else {
+    throw runtime_error("Unknown command in BiasedRDPhysics::SetNewValue()");
+  }
 }
 
@@ -23,6 +23,23 @@ using CLHEP::g;
 /* #include <stdexcept> */
 /* using std::runtime_error; */
 
+// Dimensions, shared by Construct() and ConstructHull()
+
+// Cold Trap
+static const G4double startColdTrap = -10 * mm;
+static const G4double lengthColdTrap = -380 * mm;
+static const G4double rInnerColdTrap = 0.5 * 25 * mm;
+static const G4double rOuterColdTrap = 0.5 * 28 * mm;
+
+// Plastic Support
+static const G4double startSupport = -15 * mm;
+static const G4double lengthSupport = -19 * mm;
+static const G4double rOuterSupport = 0.5 * 35 * mm;
+static const G4double rInnerSupport = 0.5 * 28 * mm;
+
+static const G4double phiStart = 0*deg;
+static const G4double phiTotal = 360*deg;
+
 ColdTrap::ColdTrap() : GeometryObject("ColdTrap")
 {
 }
@@ -45,24 +62,11 @@ G4VPhysicalVolume *ColdTrap::Construct()
 
 	const auto tolerance = 10*um;
 
-	// Cold Trap
-	const G4double lengthColdTrap = -380 * mm;
-	const G4double rInnerColdTrap = 0.5 * 25 * mm;
-	const G4double rOuterColdTrap = 0.5 * 28 * mm;
-
-	// Plastic Support
-	const G4double lengthSupport = -19 * mm;
-	const G4double rOuterSupport = 0.5 * 35 * mm;
-	const G4double rInnerSupport = 0.5 * 28 * mm;
-
-	const G4double phiStart = 0*deg;
-	const G4double phiTotal = 360*deg;
-
 	/// Cold Trap
 	const  G4int  trapNZPlanes = 2;
 	const  G4double trapZPlanes[] =
 	{
-	        -10 * mm,
+		startColdTrap,
 		lengthColdTrap
 	};
 
@@ -82,7 +86,7 @@ G4VPhysicalVolume *ColdTrap::Construct()
 	const  G4int  suppNZPlanes = 2;
 	const  G4double suppZPlanes[] =
 	{
-	        -15 * mm,
+		startSupport,
 		lengthSupport
 	};
 
@@ -130,6 +134,44 @@ G4VPhysicalVolume *ColdTrap::Construct()
 	return nullptr;
 }
 
+G4VSolid *ColdTrap::ConstructHull()
+{
+	// Trap and support, keeping the bore free
+	const  G4int  hullNZPlanes = 6;
+	const  G4double hullZPlanes[] =
+	{
+		startColdTrap,
+		startSupport,
+		startSupport,
+		lengthSupport,
+		lengthSupport,
+		lengthColdTrap
+	};
+
+	const G4double hullRInner[] =
+	{
+		rInnerColdTrap,
+		rInnerColdTrap,
+		rInnerColdTrap,
+		rInnerColdTrap,
+		rInnerColdTrap,
+		rInnerColdTrap
+	};
+
+	const G4double hullROuter[] =
+	{
+		rOuterColdTrap,
+		rOuterColdTrap,
+		rOuterSupport,
+		rOuterSupport,
+		rOuterColdTrap,
+		rOuterColdTrap
+	};
+
+	return new G4Polycone(CreateSolidName("hull"),phiStart,phiTotal,hullNZPlanes,
+			hullZPlanes,hullRInner,hullROuter);
+}
+
 void ColdTrap::SetNewValue(G4UIcommand* command, G4String value)
 {
     GeometryObject::SetNewValue(command, value);
@@ -0,0 +1,32 @@
+#include "DeadLayerRecord.hh"
+
+void DeadLayerRecord::Add(const G4double depths[nSurfaces], G4double edep)
+{
+    unsigned int key = 0;
+    for (G4int i = 0; i < nSurfaces; i++)
+    {
+        G4double bin = depths[i] / m_binWidth;
+        if (bin < 0)
+        {
+            bin = 0;
+        }
+        if (bin > nDepthBins - 1)
+        {
+            bin = nDepthBins - 1;
+        }
+        key |= static_cast<unsigned int>(bin) << (8*i);
+    }
+
+    m_deposits[key] += edep;
+}
+
+void DeadLayerRecord::GetEntries(vector<unsigned int> &keys, vector<float> &edeps) const
+{
+    keys.clear();
+    edeps.clear();
+    for (const auto &deposit : m_deposits)
+    {
+        keys.push_back(deposit.first);
+        edeps.push_back(deposit.second);
+    }
+}
@@ -0,0 +1,88 @@
+#include "DecayChainLimits.hh"
+
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+#include <cstdio>
+
+#include <memory>
+using std::make_shared;
+
+#include <stdexcept>
+using std::runtime_error;
+
+DecayChainLimits::DecayChainLimits()
+    : G4UImessenger()
+{
+    m_timeWindowCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/DecayChain/timeWindow", this);
+    m_timeWindowCmd->SetGuidance("Kill the products of radioactive decays later than this after the");
+    m_timeWindowCmd->SetGuidance("first decay of the event, 0 disables it.");
+    m_timeWindowCmd->SetParameterName("time", false);
+    m_timeWindowCmd->SetUnitCategory("Time");
+    m_timeWindowCmd->SetRange("time >= 0");
+    m_timeWindowCmd->SetToBeBroadcasted(false);
+
+    m_maxDepthCmd = make_shared<G4UIcmdWithAnInteger>("/DecayChain/maxDepth", this);
+    m_maxDepthCmd->SetGuidance("Follow at most this many decays of a chain (1: only the primary");
+    m_maxDepthCmd->SetGuidance("nuclide decays), 0 disables it. Only decays into another nuclide");
+    m_maxDepthCmd->SetGuidance("count, the de-excitation of its levels belongs to the decay that fed them.");
+    m_maxDepthCmd->SetParameterName("depth", false);
+    m_maxDepthCmd->SetRange("depth >= 0");
+    m_maxDepthCmd->SetToBeBroadcasted(false);
+}
+
+void DecayChainLimits::AddCut(const G4String& nuclide, const G4bool byTime)
+{
+    G4AutoLock lock(&m_mutex);
+    Cuts& cuts = m_cuts[nuclide];
+    if (byTime)
+    {
+        cuts.byTime++;
+    }
+    else
+    {
+        cuts.byDepth++;
+    }
+}
+
+void DecayChainLimits::BeginOfRun()
+{
+    G4AutoLock lock(&m_mutex);
+    m_cuts.clear();
+}
+
+void DecayChainLimits::EndOfRun()
+{
+    G4AutoLock lock(&m_mutex);
+    if (m_cuts.empty())
+    {
+        return;
+    }
+
+    G4cout << "DecayChain: decays that were not followed" << G4endl;
+    char line[80];
+    std::snprintf(line, sizeof(line), "%20s %12s %12s", "nuclide", "by time", "by depth");
+    G4cout << line << G4endl;
+    for (const auto& entry : m_cuts)
+    {
+        std::snprintf(line, sizeof(line), "%20s %12ld %12ld",
+                      entry.first.c_str(), entry.second.byTime, entry.second.byDepth);
+        G4cout << line << G4endl;
+    }
+}
+
+void DecayChainLimits::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_timeWindowCmd.get())
+    {
+        m_timeWindow = m_timeWindowCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_maxDepthCmd.get())
+    {
+        m_maxDepth = m_maxDepthCmd->GetNewIntValue(newValue);
+    }
+    else
+    {
+        throw runtime_error("Unknown command in DecayChainLimits::SetNewValue()");
+    }
+}
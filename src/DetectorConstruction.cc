@@ -8,6 +8,7 @@
 #include "G4LogicalVolume.hh"
 #include "G4PVPlacement.hh"
 #include "G4VisAttributes.hh"
+#include "G4GeometryManager.hh"
 
 #include "HPGeDetector.hh"
 #include "TargetHolderC12.hh"
@@ -26,6 +27,8 @@ DetectorConstruction::DetectorConstruction()
     m_targetHolder = new TargetHolderC12();
     m_targetChamber = new TargetChamberC12();
     m_coldTrap = new ColdTrap();
+
+    m_geometryObjects = {m_hpgeDetector, m_targetHolder, m_targetChamber, m_coldTrap};
 }
 
 
@@ -38,8 +41,42 @@ DetectorConstruction::~DetectorConstruction()
 }
 
 
+GeometryObject* DetectorConstruction::GetGeometryObject(const G4String& name) const
+{
+    for (auto object : m_geometryObjects)
+    {
+        if (object->GetName() == name)
+        {
+            return object;
+        }
+    }
+    return nullptr;
+}
+
+
 G4VPhysicalVolume* DetectorConstruction::Construct()
 {
+    m_geometryVersion++;
+
+    if (m_worldPhysical)
+    {
+        // Rebuild only what changed, the materials and with them the
+        // physics tables stay the same
+        G4GeometryManager::GetInstance()->OpenGeometry();
+
+        for (auto object : m_geometryObjects)
+        {
+            if (object->IsModified())
+            {
+                object->Clear();
+                object->Build();
+            }
+        }
+
+        m_scoringVolume = m_hpgeDetector->GetScoringVolume();
+
+        return m_worldPhysical;
+    }
 
     auto worldSolid = new G4Box("worldSolid", 1*m, 1*m, 1*m);
     auto matAir = G4NistManager::Instance()->FindOrBuildMaterial("G4_AIR");
@@ -62,6 +99,8 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
     m_scoringVolume = m_hpgeDetector->GetScoringVolume();
 
 
+    m_worldPhysical = physWorld;
+
     // return physical world
     return physWorld;
 }
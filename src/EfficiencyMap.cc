@@ -0,0 +1,358 @@
+#include "EfficiencyMap.hh"
+
+#include "EnergyHistogram.hh"
+
+#include "G4RunManager.hh"
+#include "G4UImanager.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TGraph2D.h"
+#include "TH2D.h"
+#include "TROOT.h"
+
+#include "G4SystemOfUnits.hh"
+using CLHEP::keV;
+
+#include <cmath>
+#include <deque>
+#include <sstream>
+
+#include <memory>
+using std::make_shared;
+
+#include <stdexcept>
+using std::runtime_error;
+
+EfficiencyMap::EfficiencyMap(EnergyHistogram* energyHistogram)
+    : G4UImessenger(),
+      m_energyHistogram(energyHistogram),
+      m_peakHalfWidth(1.5*keV)
+{
+    m_positionCommandCmd = make_shared<G4UIcmdWithAString>("/EfficiencyMap/positionCommand", this);
+    m_positionCommandCmd->SetGuidance("Command that moves the source, xxx and yyy are replaced by the coordinates,");
+    m_positionCommandCmd->SetGuidance("e.g. \"/EfficiencyMap/positionCommand /PrimaryGenerator/GammaDecayScheme/position xxx yyy -2.1 cm\".");
+    m_positionCommandCmd->SetParameterName("command", false);
+    m_positionCommandCmd->SetToBeBroadcasted(false);
+
+    m_regionCmd = make_shared<G4UIcmdWithAString>("/EfficiencyMap/region", this);
+    m_regionCmd->SetGuidance("Mapped region: xmin xmax ymin ymax, in the unit of the position command.");
+    m_regionCmd->SetParameterName("region", false);
+    m_regionCmd->SetToBeBroadcasted(false);
+
+    m_coarseCellsCmd = make_shared<G4UIcmdWithAnInteger>("/EfficiencyMap/coarseCells", this);
+    m_coarseCellsCmd->SetGuidance("Number of cells per axis of the starting grid.");
+    m_coarseCellsCmd->SetParameterName("cells", false);
+    m_coarseCellsCmd->SetRange("cells > 0");
+    m_coarseCellsCmd->SetToBeBroadcasted(false);
+
+    m_maxDepthCmd = make_shared<G4UIcmdWithAnInteger>("/EfficiencyMap/maxDepth", this);
+    m_maxDepthCmd->SetGuidance("How often a coarse cell may be split at most.");
+    m_maxDepthCmd->SetParameterName("depth", false);
+    m_maxDepthCmd->SetRange("depth >= 0 && depth < 16");
+    m_maxDepthCmd->SetToBeBroadcasted(false);
+
+    m_lineCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/EfficiencyMap/line", this);
+    m_lineCmd->SetGuidance("Gamma line whose full-energy-peak efficiency is mapped.");
+    m_lineCmd->SetParameterName("energy", false);
+    m_lineCmd->SetUnitCategory("Energy");
+    m_lineCmd->SetToBeBroadcasted(false);
+
+    m_peakHalfWidthCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/EfficiencyMap/peakHalfWidth", this);
+    m_peakHalfWidthCmd->SetGuidance("Half width of the peak window, the side bands have the same width.");
+    m_peakHalfWidthCmd->SetParameterName("halfWidth", false);
+    m_peakHalfWidthCmd->SetUnitCategory("Energy");
+    m_peakHalfWidthCmd->SetRange("halfWidth > 0");
+    m_peakHalfWidthCmd->SetToBeBroadcasted(false);
+
+    m_gradientThresholdCmd = make_shared<G4UIcmdWithADouble>("/EfficiencyMap/gradientThreshold", this);
+    m_gradientThresholdCmd->SetGuidance("Split a cell if the efficiencies at its corners differ by more than");
+    m_gradientThresholdCmd->SetGuidance("this fraction of their mean.");
+    m_gradientThresholdCmd->SetParameterName("threshold", false);
+    m_gradientThresholdCmd->SetRange("threshold > 0");
+    m_gradientThresholdCmd->SetToBeBroadcasted(false);
+
+    m_uncertaintyThresholdCmd = make_shared<G4UIcmdWithADouble>("/EfficiencyMap/uncertaintyThreshold", this);
+    m_uncertaintyThresholdCmd->SetGuidance("Simulate a point again while the relative uncertainty of its efficiency");
+    m_uncertaintyThresholdCmd->SetGuidance("is above this (at most maxRepeats times).");
+    m_uncertaintyThresholdCmd->SetParameterName("threshold", false);
+    m_uncertaintyThresholdCmd->SetRange("threshold > 0");
+    m_uncertaintyThresholdCmd->SetToBeBroadcasted(false);
+
+    m_maxRepeatsCmd = make_shared<G4UIcmdWithAnInteger>("/EfficiencyMap/maxRepeats", this);
+    m_maxRepeatsCmd->SetGuidance("Maximum number of additional runs per point.");
+    m_maxRepeatsCmd->SetParameterName("repeats", false);
+    m_maxRepeatsCmd->SetRange("repeats >= 0");
+    m_maxRepeatsCmd->SetToBeBroadcasted(false);
+
+    m_fileNameCmd = make_shared<G4UIcmdWithAString>("/EfficiencyMap/fileName", this);
+    m_fileNameCmd->SetGuidance("Output file of the map.");
+    m_fileNameCmd->SetParameterName("fileName", false);
+    m_fileNameCmd->SetToBeBroadcasted(false);
+
+    m_runCmd = make_shared<G4UIcmdWithAnInteger>("/EfficiencyMap/run", this);
+    m_runCmd->SetGuidance("Build the map with the given number of events per run.");
+    m_runCmd->SetParameterName("eventsPerPoint", false);
+    m_runCmd->SetRange("eventsPerPoint > 0");
+    m_runCmd->SetToBeBroadcasted(false);
+}
+
+G4double EfficiencyMap::GetX(const Node& node) const
+{
+    const G4int nodes = m_coarseCells << m_maxDepth;
+    return m_xMin + (m_xMax - m_xMin)*node.first/nodes;
+}
+
+G4double EfficiencyMap::GetY(const Node& node) const
+{
+    const G4int nodes = m_coarseCells << m_maxDepth;
+    return m_yMin + (m_yMax - m_yMin)*node.second/nodes;
+}
+
+void EfficiencyMap::Run(G4int eventsPerPoint)
+{
+    if (m_positionCommand.empty() || m_line <= 0)
+    {
+        G4cerr << "The efficiency map needs /EfficiencyMap/positionCommand and /EfficiencyMap/line." << G4endl;
+        return;
+    }
+
+    m_points.clear();
+
+    struct Cell
+    {
+        G4int i, j, size, depth;
+    };
+
+    // breadth first, so that all cells of one depth are decided before
+    // any of the next depth is simulated
+    const G4int scale = 1 << m_maxDepth;
+    std::deque<Cell> cells;
+    for (G4int i = 0; i < m_coarseCells; i++)
+    {
+        for (G4int j = 0; j < m_coarseCells; j++)
+        {
+            cells.push_back({i*scale, j*scale, scale, 0});
+        }
+    }
+
+    G4int nSplit = 0;
+    while (!cells.empty())
+    {
+        const Cell cell = cells.front();
+        cells.pop_front();
+
+        const Point* minimum = nullptr;
+        const Point* maximum = nullptr;
+        G4double mean = 0;
+        for (G4int corner = 0; corner < 4; corner++)
+        {
+            const Node node(cell.i + ((corner & 1) ? cell.size : 0), cell.j + ((corner & 2) ? cell.size : 0));
+            const Point& point = Evaluate(node, cell.depth, eventsPerPoint);
+            if (!minimum || point.GetEfficiency() < minimum->GetEfficiency())
+            {
+                minimum = &point;
+            }
+            if (!maximum || point.GetEfficiency() > maximum->GetEfficiency())
+            {
+                maximum = &point;
+            }
+            mean += 0.25*point.GetEfficiency();
+        }
+
+        // split only where the variation is real, not statistical noise
+        const G4double variation = maximum->GetEfficiency() - minimum->GetEfficiency();
+        const G4double noise = 2*std::hypot(maximum->GetError(), minimum->GetError());
+        if (cell.depth < m_maxDepth && mean > 0 && variation > m_gradientThreshold*mean && variation > noise)
+        {
+            const G4int half = cell.size/2;
+            cells.push_back({cell.i,        cell.j,        half, cell.depth + 1});
+            cells.push_back({cell.i + half, cell.j,        half, cell.depth + 1});
+            cells.push_back({cell.i,        cell.j + half, half, cell.depth + 1});
+            cells.push_back({cell.i + half, cell.j + half, half, cell.depth + 1});
+            nSplit++;
+        }
+    }
+
+    const G4int uniformPoints = (m_coarseCells*scale + 1)*(m_coarseCells*scale + 1);
+    G4cout << "Efficiency map: " << m_points.size() << " points (" << nSplit << " cells split), a uniform grid of "
+           << "the finest cells would need " << uniformPoints << "." << G4endl;
+
+    Write();
+}
+
+const EfficiencyMap::Point& EfficiencyMap::Evaluate(const Node& node, G4int depth, G4int eventsPerPoint)
+{
+    auto it = m_points.find(node);
+    if (it != m_points.end())
+    {
+        return it->second;
+    }
+
+    Point point;
+    point.depth = depth;
+    Simulate(node, point, eventsPerPoint);
+    for (G4int repeat = 0; repeat < m_maxRepeats; repeat++)
+    {
+        if (point.net > 0 && point.GetError() <= m_uncertaintyThreshold*point.GetEfficiency())
+        {
+            break;
+        }
+        Simulate(node, point, eventsPerPoint);
+    }
+
+    return m_points.emplace(node, point).first->second;
+}
+
+void EfficiencyMap::Simulate(const Node& node, Point& point, G4int events)
+{
+    std::ostringstream x, y;
+    x << GetX(node);
+    y << GetY(node);
+
+    G4String command = m_positionCommand;
+    for (const auto& placeholder : {std::make_pair(G4String("xxx"), x.str()), std::make_pair(G4String("yyy"), y.str())})
+    {
+        for (size_t pos = command.find(placeholder.first); pos != std::string::npos; pos = command.find(placeholder.first))
+        {
+            command.replace(pos, placeholder.first.size(), placeholder.second);
+        }
+    }
+
+    if (G4UImanager::GetUIpointer()->ApplyCommand(command) != 0)
+    {
+        throw runtime_error("EfficiencyMap::Simulate(): failed to apply '" + command + "'");
+    }
+
+    m_energyHistogram->Reset();
+    G4RunManager::GetRunManager()->BeamOn(events);
+
+    G4double net, sigma;
+    m_energyHistogram->GetPeak(m_line, m_peakHalfWidth, net, sigma);
+    point.net += net;
+    point.variance += sigma*sigma;
+    point.events += m_energyHistogram->GetHistogram()->GetEntries();
+
+    G4cout << "Efficiency map point (" << x.str() << ", " << y.str() << "): "
+           << point.GetEfficiency() << " +- " << point.GetError() << G4endl;
+}
+
+void EfficiencyMap::Write() const
+{
+    TFile* file = TFile::Open(m_fileName.c_str(), "RECREATE");
+    if (!file || file->IsZombie())
+    {
+        throw runtime_error("EfficiencyMap::Write(): could not create " + m_fileName);
+    }
+
+    G4double x, y, efficiency, error, events;
+    G4int depth;
+    auto mapTree = new TTree("map", "map");
+    mapTree->Branch("x", &x, "x/D");
+    mapTree->Branch("y", &y, "y/D");
+    mapTree->Branch("Efficiency", &efficiency, "Efficiency/D");
+    mapTree->Branch("Error", &error, "Error/D");
+    mapTree->Branch("Events", &events, "Events/D");
+    mapTree->Branch("Depth", &depth, "Depth/I");
+
+    TGraph2D graph(m_points.size());
+    graph.SetDirectory(nullptr);
+    graph.SetName("efficiency");
+    graph.SetTitle("full-energy-peak efficiency;x;y");
+
+    G4int n = 0;
+    for (const auto& entry : m_points)
+    {
+        x = GetX(entry.first);
+        y = GetY(entry.first);
+        efficiency = entry.second.GetEfficiency();
+        error = entry.second.GetError();
+        events = entry.second.events;
+        depth = entry.second.depth;
+        mapTree->Fill();
+        graph.SetPoint(n++, x, y, efficiency);
+    }
+    mapTree->Write();
+
+    // interpolated onto the finest grid
+    const G4int nodes = (m_coarseCells << m_maxDepth) + 1;
+    graph.SetNpx(nodes);
+    graph.SetNpy(nodes);
+    file->WriteTObject(&graph, "efficiency");
+    if (m_points.size() >= 3)
+    {
+        file->WriteTObject(graph.GetHistogram(), "efficiency_grid");
+    }
+
+    file->Close();
+    delete file;
+    gROOT->cd();
+
+    G4cout << "Efficiency map written to " << m_fileName << G4endl;
+}
+
+void EfficiencyMap::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_positionCommandCmd.get())
+    {
+        m_positionCommand = newValue;
+    }
+    else if (command == m_regionCmd.get())
+    {
+        std::istringstream input(newValue);
+        G4double xMin, xMax, yMin, yMax;
+        if (!(input >> xMin >> xMax >> yMin >> yMax) || xMin >= xMax || yMin >= yMax)
+        {
+            G4cerr << "Expected \"xmin xmax ymin ymax\", got '" << newValue << "'." << G4endl;
+            return;
+        }
+        m_xMin = xMin;
+        m_xMax = xMax;
+        m_yMin = yMin;
+        m_yMax = yMax;
+    }
+    else if (command == m_coarseCellsCmd.get())
+    {
+        m_coarseCells = m_coarseCellsCmd->GetNewIntValue(newValue);
+    }
+    else if (command == m_maxDepthCmd.get())
+    {
+        m_maxDepth = m_maxDepthCmd->GetNewIntValue(newValue);
+    }
+    else if (command == m_lineCmd.get())
+    {
+        m_line = m_lineCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_peakHalfWidthCmd.get())
+    {
+        m_peakHalfWidth = m_peakHalfWidthCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_gradientThresholdCmd.get())
+    {
+        m_gradientThreshold = m_gradientThresholdCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_uncertaintyThresholdCmd.get())
+    {
+        m_uncertaintyThreshold = m_uncertaintyThresholdCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_maxRepeatsCmd.get())
+    {
+        m_maxRepeats = m_maxRepeatsCmd->GetNewIntValue(newValue);
+    }
+    else if (command == m_fileNameCmd.get())
+    {
+        m_fileName = newValue;
+    }
+    else if (command == m_runCmd.get())
+    {
+        Run(m_runCmd->GetNewIntValue(newValue));
+    }
+    else
+    {
+        throw runtime_error("Unknown command in EfficiencyMap::SetNewValue()");
+    }
+}
@@ -0,0 +1,81 @@
+#include "EmissionBias.hh"
+
+#include "G4RandomDirection.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <stdexcept>
+using std::runtime_error;
+
+shared_ptr<const EmissionBias> EmissionBias::s_current;
+
+EmissionBias::EmissionBias(const G4int nCosTheta, const G4int nPhi, const vector<G4double>& importance,
+                           const G4double mixture)
+    : m_nCosTheta(nCosTheta),
+      m_nPhi(nPhi)
+{
+    const size_t nCells = static_cast<size_t>(nCosTheta)*nPhi;
+    if (importance.size() != nCells)
+    {
+        throw runtime_error("EmissionBias: the importance map has the wrong number of cells");
+    }
+    if (mixture <= 0 || mixture > 1)
+    {
+        throw runtime_error("EmissionBias: the mixture must be within (0, 1]");
+    }
+
+    const G4double sum = std::accumulate(importance.begin(), importance.end(), 0.0);
+    const G4double uniform = (sum > 0) ? mixture : 1;
+
+    m_cumulative.resize(nCells);
+    m_weights.resize(nCells);
+    G4double cumulative = 0;
+    for (size_t i = 0; i < nCells; i++)
+    {
+        const G4double probability = uniform/nCells + ((sum > 0) ? (1 - uniform)*importance[i]/sum : 0);
+        cumulative += probability;
+        m_cumulative[i] = cumulative;
+        m_weights[i] = 1.0/(nCells*probability);
+    }
+    m_cumulative.back() = 1;
+}
+
+G4ThreeVector EmissionBias::GetDirection(const G4int nCosTheta, const G4int nPhi, const G4int cell,
+                                         const G4double u, const G4double v)
+{
+    const G4double cosTheta = -1 + 2*((cell/nPhi) + u)/nCosTheta;
+    const G4double sinTheta = std::sqrt(std::max(0.0, 1 - cosTheta*cosTheta));
+    const G4double phi = CLHEP::twopi*((cell%nPhi) + v)/nPhi;
+    return G4ThreeVector(sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta);
+}
+
+G4ThreeVector EmissionBias::Sample(G4double& weight) const
+{
+    const auto cell = std::upper_bound(m_cumulative.begin(), m_cumulative.end(), G4UniformRand());
+    const G4int index = std::min<G4int>(cell - m_cumulative.begin(), m_cumulative.size() - 1);
+    weight *= m_weights[index];
+    return GetDirection(m_nCosTheta, m_nPhi, index, G4UniformRand(), G4UniformRand());
+}
+
+G4ThreeVector EmissionBias::SampleDirection(G4double& weight)
+{
+    const shared_ptr<const EmissionBias> bias = GetCurrent();
+    if (!bias)
+    {
+        return G4RandomDirection();
+    }
+    return bias->Sample(weight);
+}
+
+shared_ptr<const EmissionBias> EmissionBias::GetCurrent()
+{
+    return std::atomic_load(&s_current);
+}
+
+void EmissionBias::SetCurrent(const shared_ptr<const EmissionBias>& bias)
+{
+    std::atomic_store(&s_current, bias);
+}
@@ -1,7 +1,13 @@
 #include "EnergyHistogram.hh"
 
+#include "TParameter.h"
+
+#include <algorithm>
+#include <cmath>
+
 #include "G4SystemOfUnits.hh"
 using CLHEP::keV;
+using CLHEP::mm;
 
 EnergyHistogram::EnergyHistogram(const int nBins, const double Emin, const double Emax) : m_nBins(nBins), m_Emin(Emin), m_Emax(Emax)
 {
@@ -15,13 +21,33 @@ EnergyHistogram::EnergyHistogram(const int nBins, const double Emin, const doubl
 EnergyHistogram::~EnergyHistogram()
 {
     delete h1;
+    delete h1w;
+    for (auto& component : m_components)
+    {
+        delete component.second;
+    }
 //    delete[] m_histogram;
 }
 
 
 void EnergyHistogram::Reset()
 {
-    G4AutoLock lock();
+    G4AutoLock lock(&m_mutex);
+    h1->Reset( );
+    t1->Reset( );
+    if (h1w)
+    {
+        h1w->Reset( );
+    }
+    for (auto& component : m_components)
+    {
+        component.second->Reset( );
+    }
+    if (dl)
+    {
+        dl->Reset( );
+    }
+    m_screenedEvents = 0;
 //    m_histogram = new double[m_nBins+2];
 //    for (int i = 0; i <= m_nBins+1; i++)
 //    {
@@ -30,11 +56,26 @@ void EnergyHistogram::Reset()
 
 }
 
-void EnergyHistogram::Fill(const double energy)
+void EnergyHistogram::Fill(const double energy, const double weight)
 {
-    G4AutoLock lock();
-    Energy = energy;
-    t1->Fill( );
+    G4AutoLock lock(&m_mutex);
+    if (!h1w && weight != 1)
+    {
+        // all events so far had unit weight
+        h1w = static_cast<TH1D*>(h1->Clone("h1w"));
+        h1w->SetTitle("h1w");
+        h1w->Sumw2();
+    }
+    if (h1w)
+    {
+        h1w->Fill( (energy < m_Emin || energy > m_Emax) ? 0 : energy, weight );
+    }
+
+    if (m_fillTree)
+    {
+        Energy = energy;
+        t1->Fill( );
+    }
     if (energy < m_Emin)
     {
         h1->Fill( 0 );
@@ -52,7 +93,146 @@ void EnergyHistogram::Fill(const double energy)
     }
 }
 
-void EnergyHistogram::Write(const string fileName) const
+void EnergyHistogram::FillComponent(const string& component, const double energy, const double weight)
+{
+    G4AutoLock lock(&m_mutex);
+    TH1D*& histogram = m_components[component];
+    if (!histogram)
+    {
+        const string name = "h1_" + component;
+        histogram = new TH1D( name.c_str( ), name.c_str( ), m_nBins, m_Emin, m_Emax );
+        histogram->SetDirectory( nullptr );
+        histogram->Sumw2( );
+    }
+    histogram->Fill( (energy < m_Emin || energy > m_Emax) ? 0 : energy, weight );
+}
+
+int EnergyHistogram::FindBin(const double energy) const
+{
+    return h1->GetXaxis()->FindFixBin(energy);
+}
+
+double EnergyHistogram::Integral(int firstBin, int lastBin)
+{
+    firstBin = std::max(firstBin, 1);
+    lastBin = std::min(lastBin, m_nBins);
+    if (firstBin > lastBin)
+    {
+        return 0;
+    }
+
+    G4AutoLock lock(&m_mutex);
+    return h1->Integral(firstBin, lastBin);
+}
+
+void EnergyHistogram::GetPeak(const double energy, const double halfWidth, double& net, double& sigma)
+{
+    const int first = FindBin(energy - halfWidth);
+    const int last = FindBin(energy + halfWidth);
+    const int width = last - first + 1;
+
+    const double peak = Integral(first, last);
+    const double sides = Integral(first - width, first - 1) + Integral(last + 1, last + width);
+
+    net = peak - 0.5*sides;
+    sigma = std::sqrt(peak + 0.25*sides);
+}
+
+void EnergyHistogram::GetContents(vector<double>& contents, double& entries)
+{
+    contents.resize(m_nBins+2);
+
+    G4AutoLock lock(&m_mutex);
+    for (int i = 0; i <= m_nBins+1; i++)
+    {
+        contents[i] = h1->GetBinContent(i);
+    }
+    entries = h1->GetEntries();
+}
+
+void EnergyHistogram::FillDeadLayerRecord(const DeadLayerRecord& record)
+{
+    G4AutoLock lock(&m_mutex);
+    if (!dl)
+    {
+        dl = new TTree( "dl", "dl" );
+        dl->Branch("Key", &m_dlKeys);
+        dl->Branch("Edep", &m_dlEdeps);
+        m_dlBinWidth = record.GetBinWidth();
+    }
+    record.GetEntries(m_dlKeys, m_dlEdeps);
+    dl->Fill( );
+}
+
+void EnergyHistogram::CloneHistograms(vector<unique_ptr<TH1D>>& histograms)
+{
+    G4AutoLock lock(&m_mutex);
+    vector<TH1D*> sources = {h1, h1w};
+    for (auto& component : m_components)
+    {
+        sources.push_back(component.second);
+    }
+    for (TH1D* histogram : sources)
+    {
+        if (histogram)
+        {
+            histograms.emplace_back(static_cast<TH1D*>(histogram->Clone()));
+            histograms.back()->SetDirectory(nullptr);
+        }
+    }
+}
+
+void EnergyHistogram::Add(const vector<unique_ptr<TH1D>>& histograms)
+{
+    G4AutoLock lock(&m_mutex);
+    for (const auto& histogram : histograms)
+    {
+        const string name = histogram->GetName( );
+        if (name == "h1w" && !h1w)
+        {
+            // as in Fill(): all events so far had unit weight
+            h1w = static_cast<TH1D*>(h1->Clone("h1w"));
+            h1w->SetTitle("h1w");
+            h1w->Sumw2();
+        }
+    }
+    for (const auto& histogram : histograms)
+    {
+        const string name = histogram->GetName( );
+        if (name == "h1")
+        {
+            h1->Add( histogram.get( ) );
+        }
+        else if (name == "h1w")
+        {
+            h1w->Add( histogram.get( ) );
+        }
+        else if (name.compare(0, 3, "h1_") == 0)
+        {
+            TH1D*& component = m_components[name.substr(3)];
+            if (!component)
+            {
+                component = new TH1D( name.c_str( ), name.c_str( ), m_nBins, m_Emin, m_Emax );
+                component->SetDirectory( nullptr );
+                component->Sumw2( );
+            }
+            component->Add( histogram.get( ) );
+        }
+    }
+}
+
+void EnergyHistogram::AddScreenedEvents(const long screened, const long replayed)
+{
+    G4AutoLock lock(&m_mutex);
+    m_screenedEvents += screened;
+    h1->SetEntries(h1->GetEntries() - replayed + screened);
+    if (h1w)
+    {
+        h1w->SetEntries(h1w->GetEntries() - replayed + screened);
+    }
+}
+
+void EnergyHistogram::Write(const string fileName, const bool update) const
 {
 //    ofstream fout(fileName);
 //    fout << m_nBins << "\t" << m_Emin/keV << "\t" << m_Emax/keV << "\n";
@@ -61,10 +241,34 @@ void EnergyHistogram::Write(const string fileName) const
 //        fout << m_histogram[i] << "\n";
 //    }
 
-    TFile* f1 = new TFile( fileName.c_str( ), "RECREATE" );
+    TFile* f1 = new TFile( fileName.c_str( ), update ? "UPDATE" : "RECREATE" );
 
     h1->Write( );
-    t1->Write( );
+    if (h1w)
+    {
+        h1w->Write( );
+    }
+    for (auto& component : m_components)
+    {
+        component.second->Write( );
+    }
+    if (!update || t1->GetEntries( ) > 0)
+    {
+        t1->Write( );
+    }
+    if (dl)
+    {
+        dl->Write( );
+        // the same in all outputs, merging keeps it instead of adding it up
+        TParameter<double> binWidth("dlBinWidth", m_dlBinWidth/mm, 'f');
+        binWidth.Write( );
+    }
+    if (m_screenedEvents > 0)
+    {
+        // added up when outputs are merged
+        TParameter<Long64_t> screenedEvents("screenedEvents", m_screenedEvents);
+        screenedEvents.Write( );
+    }
 
     f1->Close( );
 }
@@ -3,9 +3,20 @@
 #include "G4Event.hh"
 #include "G4RunManager.hh"
 
-EventAction::EventAction(EnergyHistogram* energyHistogram)
+#include "DetectorConstruction.hh"
+#include "HPGeDetector.hh"
+#include "RunControl.hh"
+#include "TwoTierRun.hh"
+#include "AdjointSimulation.hh"
+#include "generator/Composite/CompositeGen.hh"
+
+EventAction::EventAction(EnergyHistogram* energyHistogram, RunControl* runControl,
+                         PhaseSpaceRecorder::Writer* phaseSpaceWriter, AsyncWriter::Buffer* outputBuffer)
     : G4UserEventAction(),
-      m_energyHistogram(energyHistogram)
+      m_energyHistogram(energyHistogram),
+      m_runControl(runControl),
+      m_phaseSpaceWriter(phaseSpaceWriter),
+      m_outputBuffer(outputBuffer)
 {}
 
 
@@ -16,10 +27,68 @@ EventAction::~EventAction()
 void EventAction::BeginOfEventAction(const G4Event* /*event*/)
 {
     m_Edep = 0.0;
+    m_weightedEdep = 0.0;
+    m_nearDetector = false;
+    m_deadLayerRecord.Clear();
 }
 
 
-void EventAction::EndOfEventAction(const G4Event* /*event*/)
+void EventAction::EndOfEventAction(const G4Event* event)
 {
-    m_energyHistogram->Fill(m_Edep);
+    // adjoint runs fill their own spectra, weighted by the adjoint phase
+    if (AdjointSimulation::EndOfEvent(m_Edep))
+    {
+        return;
+    }
+
+    // the screening pass of a two-tier run only selects events
+    TwoTierRun::EndOfEvent(event, m_Edep, m_nearDetector);
+    if (TwoTierRun::IsScreening())
+    {
+        return;
+    }
+
+    // with biased radioactive decay the deposits carry the weights of their
+    // tracks; the event gets their mean weighted by the energy, which is only
+    // exact if all of them have the same weight (one biased decay per event,
+    // see BiasedRDPhysics.hh)
+    G4double weight = 1;
+    if (m_Edep > 0)
+    {
+        weight = m_weightedEdep/m_Edep;
+    }
+    else if (event->GetNumberOfPrimaryVertex() > 0)
+    {
+        weight = event->GetPrimaryVertex()->GetWeight();
+    }
+    m_energyHistogram->Fill(m_Edep, weight);
+    m_outputBuffer->Add(m_Edep);
+
+    const auto component = dynamic_cast<const CompositeEventInformation*>(event->GetUserInformation());
+    if (component)
+    {
+        m_energyHistogram->FillComponent(component->GetName(), m_Edep, weight);
+    }
+
+    if (!m_deadLayerRecord.IsEmpty())
+    {
+        m_energyHistogram->FillDeadLayerRecord(m_deadLayerRecord);
+    }
+
+    m_phaseSpaceWriter->EndOfEvent();
+    m_runControl->EndOfEvent();
+}
+
+
+void EventAction::AddDepthDeposit(const G4double depths[4], const G4double edep)
+{
+    if (m_deadLayerRecord.GetBinWidth() <= 0)
+    {
+        const DetectorConstruction* detectorConstruction
+            = static_cast<const DetectorConstruction*>
+              (G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+        m_deadLayerRecord.SetBinWidth(detectorConstruction->GetHPGeDetector()->GetDepthRecordBinWidth());
+    }
+
+    m_deadLayerRecord.Add(depths, edep);
 }
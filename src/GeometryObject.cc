@@ -8,14 +8,27 @@
 #include "G4Cons.hh"
 #include "G4Tubs.hh"
 #include "G4Trd.hh"
+#include "G4DisplacedSolid.hh"
 
 #include "G4LogicalVolume.hh"
 #include "G4PVPlacement.hh"
 #include "G4VPhysicalVolume.hh"
 #include "G4ThreeVector.hh"
 #include "G4PVPlacement.hh"
+#include "G4GeometryManager.hh"
+#include "G4SolidStore.hh"
+#include "G4Colour.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+using CLHEP::m;
 using CLHEP::mm;
+using CLHEP::um;
+using CLHEP::g;
+using CLHEP::cm3;
+using CLHEP::perCent;
 
 GeometryObject::GeometryObject(G4String name) :
     m_name(name),
@@ -28,6 +41,9 @@ GeometryObject::GeometryObject(G4String name) :
     m_cmdRotateX(new G4UIcmdWithADoubleAndUnit((m_cmdDirName + "rotateX").c_str(), static_cast<G4UImessenger*>(this))),
     m_cmdRotateY(new G4UIcmdWithADoubleAndUnit((m_cmdDirName + "rotateY").c_str(), static_cast<G4UImessenger*>(this))),
     m_cmdRotateZ(new G4UIcmdWithADoubleAndUnit((m_cmdDirName + "rotateZ").c_str(), static_cast<G4UImessenger*>(this))),
+    m_cmdEnvelope(new G4UIcmdWithABool((m_cmdDirName + "envelope").c_str(), static_cast<G4UImessenger*>(this))),
+    m_cmdSmartless(new G4UIcmdWithADouble((m_cmdDirName + "smartless").c_str(), static_cast<G4UImessenger*>(this))),
+    m_cmdDetail(new G4UIcmdWithAString((m_cmdDirName + "detail").c_str(), static_cast<G4UImessenger*>(this))),
     m_cmdSetDimension(new G4UIcmdWithAString((m_cmdDirName + "setDimension").c_str(), static_cast<G4UImessenger*>(this)))
 {
     m_cmdDir->SetGuidance(("commands for " + m_name + " geometry.").c_str());
@@ -52,24 +68,51 @@ GeometryObject::GeometryObject(G4String name) :
     m_cmdRotateZ->SetParameterName("angĺeZ", false);
     m_cmdRotateZ->SetUnitCategory("Angle");
 
+    m_cmdEnvelope->SetGuidance(("Build " + m_name + " inside a tight box, navigation only enters it when a track does.").c_str());
+    m_cmdEnvelope->SetGuidance("The boxes of different objects must not overlap.");
+    m_cmdEnvelope->SetParameterName("envelope", true);
+    m_cmdEnvelope->SetDefaultValue(true);
+
+    m_cmdSmartless->SetGuidance("Voxel density (smartless) of the envelope, the Geant4 default is 2.");
+    m_cmdSmartless->SetParameterName("smartless", false);
+    m_cmdSmartless->SetRange("smartless > 0");
+
+    m_cmdDetail->SetGuidance(("Level of detail of " + m_name + ": full, simplified or homogenized.").c_str());
+    m_cmdDetail->SetGuidance("homogenized builds one volume of the object's hull with the same mass.");
+    m_cmdDetail->SetParameterName("detail", false);
+    m_cmdDetail->SetCandidates("full simplified homogenized");
+
     m_cmdSetDimension->SetGuidance("Set dimension, use e.g. \"/Geometry/TargetChamber55/setDimension beamSpotDiameter 0.5 mm\".");
     m_cmdSetDimension->SetParameterName("setDimension", true);
     m_cmdSetDimension->SetToBeBroadcasted(true);
 }
 
 GeometryObject::~GeometryObject() {
+    for (auto rotation : m_placementRotations)
+        delete rotation;
     delete m_rotation;
     delete m_cmdDir;
     delete m_cmdSetPosition;
     delete m_cmdRotateX;
     delete m_cmdRotateY;
     delete m_cmdRotateZ;
+    delete m_cmdEnvelope;
+    delete m_cmdSmartless;
+    delete m_cmdDetail;
 }
 
 void GeometryObject::Build() {
     if (m_enable) {
         G4cout << "building " << GetName() << G4endl;
-        Construct();
+        auto solidStore = G4SolidStore::GetInstance();
+        m_solidsBeforeBuild = set<G4VSolid*>(solidStore->begin(), solidStore->end());
+        if (m_detail == detailHomogenized)
+            BuildHomogenized();
+        else if (m_useEnvelope)
+            BuildInEnvelope();
+        else
+            Construct();
+        TrackNewSolids();
         ConstructSDandField();
         CheckForUnusedDimensions();
     }
@@ -77,6 +120,326 @@ void GeometryObject::Build() {
     {
         G4cout << "not building " << GetName() << G4endl;
     }
+    m_modified = false;
+}
+
+void GeometryObject::BuildInEnvelope() {
+    auto motherVolume = m_motherVolume;
+    auto position = m_position;
+    auto rotation = *m_rotation;
+
+    // Construct in the frame of the object, inside a box that is large
+    // enough for everything and shrunk to the contents afterwards
+    auto envelopeSolid = new G4Box(CreateSolidName("envelope"), 10*m, 10*m, 10*m);
+    auto envelopeLogical = new G4LogicalVolume(envelopeSolid, motherVolume->GetMaterial(), CreateLogicalName("envelope"));
+    envelopeLogical->SetVisAttributes(G4VisAttributes::GetInvisible());
+
+    m_motherVolume = envelopeLogical;
+    m_position = G4ThreeVector();
+    *m_rotation = G4RotationMatrix();
+
+    Construct();
+
+    m_motherVolume = motherVolume;
+    m_position = position;
+    *m_rotation = rotation;
+
+    // the daughters move with the envelope
+    m_placements.clear();
+
+    if (envelopeLogical->GetNoDaughters() == 0) {
+        delete envelopeLogical;
+        return;
+    }
+
+    // bounding box of all daughters in the frame of the object
+    G4ThreeVector lower, upper;
+    GetDaughterLimits(envelopeLogical, lower, upper);
+
+    const auto margin = 1*um;
+    const auto center = 0.5*(lower + upper);
+    envelopeSolid->SetXHalfLength(0.5*(upper.x() - lower.x()) + margin);
+    envelopeSolid->SetYHalfLength(0.5*(upper.y() - lower.y()) + margin);
+    envelopeSolid->SetZHalfLength(0.5*(upper.z() - lower.z()) + margin);
+
+    for (size_t i = 0; i < envelopeLogical->GetNoDaughters(); i++) {
+        auto daughter = envelopeLogical->GetDaughter(i);
+        daughter->SetTranslation(daughter->GetTranslation() - center);
+    }
+
+    if (m_smartless > 0)
+        envelopeLogical->SetSmartless(m_smartless);
+
+    PlaceVolume(envelopeLogical, motherVolume, center);
+}
+
+void GeometryObject::BuildHomogenized() {
+    auto motherVolume = m_motherVolume;
+    auto position = m_position;
+    auto rotation = *m_rotation;
+
+    // Build the full model in the frame of the object to weigh it
+    auto buildSolid = new G4Box(CreateSolidName("homogenizedBuild"), 10*m, 10*m, 10*m);
+    auto buildLogical = new G4LogicalVolume(buildSolid, motherVolume->GetMaterial(), CreateLogicalName("homogenizedBuild"));
+
+    m_motherVolume = buildLogical;
+    m_position = G4ThreeVector();
+    *m_rotation = G4RotationMatrix();
+
+    Construct();
+
+    m_motherVolume = motherVolume;
+    m_position = position;
+    *m_rotation = rotation;
+
+    map<G4Material*, G4double> masses;
+    G4double filledVolume = 0;
+    for (size_t i = 0; i < buildLogical->GetNoDaughters(); i++) {
+        auto daughter = buildLogical->GetDaughter(i)->GetLogicalVolume();
+        AddMaterialMasses(daughter, masses);
+        filledVolume += daughter->GetSolid()->GetCubicVolume();
+    }
+
+    G4ThreeVector lower, upper;
+    if (buildLogical->GetNoDaughters() > 0)
+        GetDaughterLimits(buildLogical, lower, upper);
+
+    // the solids of the full model go with it
+    TrackNewSolids();
+    m_solids.erase(buildSolid);
+    Clear();
+    delete buildLogical;
+    delete buildSolid;
+
+    if (masses.empty())
+        return;
+
+    G4VSolid *hullSolid = ConstructHull();
+    G4ThreeVector center;
+    if (!hullSolid) {
+        const auto margin = 1*um;
+        center = 0.5*(lower + upper);
+        hullSolid = new G4Box(CreateSolidName("homogenized"),
+                              0.5*(upper.x() - lower.x()) + margin,
+                              0.5*(upper.y() - lower.y()) + margin,
+                              0.5*(upper.z() - lower.z()) + margin);
+    }
+
+    // the free space inside the hull keeps the material of the mother
+    const auto hullVolume = hullSolid->GetCubicVolume();
+    if (hullVolume > filledVolume)
+        masses[motherVolume->GetMaterial()] += (hullVolume - filledVolume)*motherVolume->GetMaterial()->GetDensity();
+
+    G4double totalMass = 0;
+    for (const auto &mass : masses)
+        totalMass += mass.second;
+
+    map<G4Material*, G4double> fractions;
+    for (const auto &mass : masses)
+        fractions[mass.first] = mass.second/totalMass;
+    auto material = GetHomogenizedMaterial(fractions, totalMass/hullVolume);
+
+    G4cout << GetName() << ": " << totalMass/g << " g homogenized in " << hullVolume/cm3
+           << " cm3 (" << material->GetDensity()/(g/cm3) << " g/cm3)" << G4endl;
+    if (filledVolume > hullVolume)
+        G4cout << GetName() << ": the volumes exceed the hull by " << (filledVolume - hullVolume)/cm3
+               << " cm3, their mass is moved into it" << G4endl;
+
+    auto hullLogical = new G4LogicalVolume(hullSolid, material, CreateLogicalName("homogenized"));
+    hullLogical->SetVisAttributes(G4VisAttributes(G4Colour::Grey()));
+
+    PlaceVolume(hullLogical, motherVolume, center);
+}
+
+G4Material *GeometryObject::GetHomogenizedMaterial(const map<G4Material*, G4double> &fractions, G4double density) {
+    const G4double tolerance = 1e-9;
+    for (const auto &cached : m_homogenizedMaterials) {
+        if (std::abs(cached.density - density) > tolerance*density || cached.fractions.size() != fractions.size())
+            continue;
+        G4bool same = true;
+        for (const auto &fraction : fractions) {
+            auto it = cached.fractions.find(fraction.first);
+            if (it == cached.fractions.end() || std::abs(it->second - fraction.second) > tolerance) {
+                same = false;
+                break;
+            }
+        }
+        if (same)
+            return cached.material;
+    }
+
+    std::ostringstream materialName;
+    materialName << GetName() << "_homogenized_" << m_homogenizedMaterials.size();
+    auto material = new G4Material(materialName.str(), density, static_cast<G4int>(fractions.size()));
+    for (const auto &fraction : fractions)
+        material->AddMaterial(fraction.first, fraction.second);
+    m_homogenizedMaterials.push_back({fractions, density, material});
+    return material;
+}
+
+void GeometryObject::GetDaughterLimits(G4LogicalVolume *volume, G4ThreeVector &lower, G4ThreeVector &upper) {
+    lower = G4ThreeVector(kInfinity, kInfinity, kInfinity);
+    upper = G4ThreeVector(-kInfinity, -kInfinity, -kInfinity);
+    for (size_t i = 0; i < volume->GetNoDaughters(); i++) {
+        auto daughter = volume->GetDaughter(i);
+        G4ThreeVector pMin, pMax;
+        daughter->GetLogicalVolume()->GetSolid()->BoundingLimits(pMin, pMax);
+        for (int corner = 0; corner < 8; corner++) {
+            G4ThreeVector point((corner & 1) ? pMax.x() : pMin.x(),
+                                (corner & 2) ? pMax.y() : pMin.y(),
+                                (corner & 4) ? pMax.z() : pMin.z());
+            point = daughter->GetObjectRotationValue()*point + daughter->GetObjectTranslation();
+            for (int k = 0; k < 3; k++) {
+                lower[k] = std::min(lower[k], point[k]);
+                upper[k] = std::max(upper[k], point[k]);
+            }
+        }
+    }
+}
+
+void GeometryObject::AddMaterialMasses(G4LogicalVolume *volume, map<G4Material*, G4double> &masses) {
+    // the daughters displace the material of their mother
+    auto ownVolume = volume->GetSolid()->GetCubicVolume();
+    for (size_t i = 0; i < volume->GetNoDaughters(); i++) {
+        auto daughter = volume->GetDaughter(i)->GetLogicalVolume();
+        ownVolume -= daughter->GetSolid()->GetCubicVolume();
+        AddMaterialMasses(daughter, masses);
+    }
+    masses[volume->GetMaterial()] += std::max(ownVolume, 0.)*volume->GetMaterial()->GetDensity();
+}
+
+void GeometryObject::DisableDetail() {
+    delete m_cmdDetail;
+    m_cmdDetail = nullptr;
+    m_detail = detailFull;
+}
+
+void GeometryObject::SetDetail(Detail detail) {
+    if (!HasDetail() && detail != detailFull)
+        throw runtime_error(GetName() + " can only be built in full detail.");
+    if (detail != m_detail)
+        m_modified = true;
+    m_detail = detail;
+}
+
+G4String GeometryObject::GetDetailName(Detail detail) {
+    switch (detail) {
+        case detailSimplified:
+            return "simplified";
+        case detailHomogenized:
+            return "homogenized";
+        default:
+            return "full";
+    }
+}
+
+G4bool GeometryObject::GetDetailFromName(const G4String &name, Detail &detail) {
+    for (auto level : {detailFull, detailSimplified, detailHomogenized}) {
+        if (name == GetDetailName(level)) {
+            detail = level;
+            return true;
+        }
+    }
+    return false;
+}
+
+void GeometryObject::Clear() {
+    set<G4LogicalVolume*> logicalVolumes;
+
+    for (auto it = m_placedVolumes.rbegin(); it != m_placedVolumes.rend(); ++it) {
+        auto phyVol = *it;
+        if (phyVol->GetMotherLogical())
+            phyVol->GetMotherLogical()->RemoveDaughter(phyVol);
+        logicalVolumes.insert(phyVol->GetLogicalVolume());
+        delete phyVol;
+    }
+    m_placedVolumes.clear();
+    m_placements.clear();
+
+    for (auto rotation : m_placementRotations)
+        delete rotation;
+    m_placementRotations.clear();
+
+    for (auto logicalVolume : logicalVolumes)
+        delete logicalVolume;
+
+    // A boolean solid with a transform creates a G4DisplacedSolid for its
+    // second constituent and still uses it in its destructor, so those go
+    // last. The solid store forgets deleted solids, their addresses may be
+    // reused.
+    vector<G4VSolid*> displacedSolids;
+    for (auto solid : m_solids) {
+        m_solidsBeforeBuild.erase(solid);
+        if (dynamic_cast<G4DisplacedSolid*>(solid))
+            displacedSolids.push_back(solid);
+        else
+            delete solid;
+    }
+    for (auto solid : displacedSolids)
+        delete solid;
+    m_solids.clear();
+}
+
+void GeometryObject::TrackNewSolids() {
+    for (auto solid : *G4SolidStore::GetInstance()) {
+        if (m_solidsBeforeBuild.find(solid) == m_solidsBeforeBuild.end())
+            m_solids.insert(solid);
+    }
+}
+
+void GeometryObject::SetPlacement(const G4ThreeVector &position, const G4RotationMatrix &rotation) {
+    m_position = position;
+    *m_rotation = rotation;
+}
+
+G4bool GeometryObject::UpdatePlacement(G4bool checkOverlaps) {
+    map<G4LogicalVolume*, G4VPhysicalVolume*> mothers;
+
+    for (auto &placement : m_placements) {
+        auto transform = GetTransform3D(placement.ownRotation, placement.relativePosition);
+        auto phyVol = placement.volume;
+
+        // the physical volume stores the inverse (frame) rotation
+        if (!phyVol->GetRotation()) {
+            m_placementRotations.push_back(new G4RotationMatrix());
+            phyVol->SetRotation(m_placementRotations.back());
+        }
+        *phyVol->GetRotation() = transform.getRotation().inverse();
+        phyVol->SetTranslation(transform.getTranslation());
+
+        mothers[phyVol->GetMotherLogical()] = phyVol;
+    }
+
+    // only the mothers of the moved volumes need new voxels
+    auto geometryManager = G4GeometryManager::GetInstance();
+    if (geometryManager->IsGeometryClosed()) {
+        for (const auto &mother : mothers) {
+            geometryManager->OpenGeometry(mother.second);
+            geometryManager->CloseGeometry(true, false, mother.second);
+        }
+    }
+
+    if (checkOverlaps) {
+        for (auto &placement : m_placements) {
+            if (placement.volume->CheckOverlaps())
+                return false;
+        }
+    }
+    return true;
+}
+
+G4Material *GeometryObject::GetSteel316() {
+    auto matSteel = G4Material::GetMaterial("Steel-316", false);
+    if (matSteel)
+        return matSteel;
+
+    auto man = G4NistManager::Instance();
+    matSteel = new G4Material("Steel-316", 8.0*g/cm3, 4);
+    matSteel->AddMaterial(man->FindOrBuildMaterial("G4_Fe"), 69*perCent);
+    matSteel->AddMaterial(man->FindOrBuildMaterial("G4_Cr"), 17*perCent);
+    matSteel->AddMaterial(man->FindOrBuildMaterial("G4_Ni"), 12*perCent);
+    matSteel->AddMaterial(man->FindOrBuildMaterial("G4_Mo"),  2*perCent);
+    return matSteel;
 }
 
 G4Transform3D GeometryObject::GetTransform3D(G4RotationMatrix ownRotation, G4ThreeVector relativePosition) {
@@ -114,6 +477,10 @@ G4PVPlacement* GeometryObject::PlaceVolume(G4LogicalVolume *logicalVolume, G4Log
         throw runtime_error("Overlapping volumes!");
     }
 
+    m_placedVolumes.push_back(phyVol);
+    if (!noExternalRotation)
+        m_placements.push_back({phyVol, rotation, position});
+
     return phyVol;
 }
 
@@ -124,6 +491,8 @@ G4PVPlacement* GeometryObject::PlaceVolumeInternal(G4LogicalVolume *logicalVolum
 
 void GeometryObject::SetNewValue(G4UIcommand* command, G4String newValue)
 {
+    m_modified = true;
+
    if (command == m_cmdEnable)
     {
         m_enable = m_cmdEnable->GetNewBoolValue(newValue);
@@ -138,6 +507,12 @@ void GeometryObject::SetNewValue(G4UIcommand* command, G4String newValue)
         m_rotation->rotateY(static_cast<G4UIcmdWithADoubleAndUnit*>(command)->GetNewDoubleValue(newValue));
     else if (command == m_cmdRotateZ)
         m_rotation->rotateZ(static_cast<G4UIcmdWithADoubleAndUnit*>(command)->GetNewDoubleValue(newValue));
+    else if (command == m_cmdEnvelope)
+        m_useEnvelope = m_cmdEnvelope->GetNewBoolValue(newValue);
+    else if (command == m_cmdSmartless)
+        m_smartless = m_cmdSmartless->GetNewDoubleValue(newValue);
+    else if (command == m_cmdDetail)
+        GetDetailFromName(newValue, m_detail);
     else if (command == m_cmdSetDimension){
         int idx = newValue.find(G4String(" "));
         G4String name = newValue.substr( 0, idx );
@@ -184,6 +559,7 @@ void GeometryObject::SetDimension(G4String name, G4double value) {
     }
 
     m_dimensions[name] = value;
+    m_modified = true;
 }
 
 void GeometryObject::CheckForUnusedDimensions() {
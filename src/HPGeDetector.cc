@@ -7,6 +7,7 @@
 #include "G4Element.hh"
 
 #include "G4Polycone.hh"
+#include "G4GenericPolycone.hh"
 #include "G4Tubs.hh"
 #include "G4Torus.hh"
 #include "G4Sphere.hh"
@@ -34,12 +35,17 @@ using CLHEP::cm;
 using CLHEP::cm3;
 using CLHEP::perCent;
 using CLHEP::deg;
+using CLHEP::um;
 
 using CLHEP::pi;
 
 #include <string>
 #include <stdexcept>
     using std::runtime_error;
+#include <cmath>
+#include <algorithm>
+#include <memory>
+    using std::make_shared;
 
 
 // HPGe Detector Geometry
@@ -51,6 +57,9 @@ using CLHEP::pi;
 HPGeDetector::HPGeDetector() :
     GeometryObject("HPGeDetector")
 {
+        // the scoring and crystal volumes must always exist
+        DisableDetail();
+
         // Outer casing dimensions
         RegisterDimension("outerCasingDiameter", 108.0*mm);
         RegisterDimension("outerCasingLength", 305.0*mm);
@@ -86,12 +95,420 @@ HPGeDetector::HPGeDetector() :
         RegisterDimension("detectorDeadLayerBack", 0.1*mm); // pointing away from the target
         RegisterDimension("detectorDeadLayerOutside", 0.7*mm); // radially outside (including rounded front edges)
         RegisterDimension("detectorDeadLayerInside", 0.3*1e-3*mm); // inner contact
+
+        m_depthRecordCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/Geometry/HPGeDetector/depthRecordBinWidth", this);
+        m_depthRecordCmd->SetGuidance("Record the deposits in the full crystal binned by depth below each dead-layer surface.");
+        m_depthRecordCmd->SetGuidance("The value is the depth bin width, 0 disables the records.");
+        m_depthRecordCmd->SetParameterName("binWidth", false);
+        m_depthRecordCmd->SetUnitCategory("Length");
+        m_depthRecordCmd->SetToBeBroadcasted(false);
+
+        m_crystalShapeCmd = make_shared<G4UIcmdWithAString>("/Geometry/HPGeDetector/crystalShape", this);
+        m_crystalShapeCmd->SetGuidance("Build the crystal from boolean solids (torus, tubes, spheres) or from polycone profiles.");
+        m_crystalShapeCmd->SetGuidance("The polycone approximates the rounded edges within roundedEdgeTolerance and navigates faster.");
+        m_crystalShapeCmd->SetParameterName("shape", false);
+        m_crystalShapeCmd->SetCandidates("boolean polycone");
+        m_crystalShapeCmd->SetToBeBroadcasted(false);
+
+        m_roundedEdgeToleranceCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/Geometry/HPGeDetector/roundedEdgeTolerance", this);
+        m_roundedEdgeToleranceCmd->SetGuidance("Maximum distance between the polycone profile and the rounded edges.");
+        m_roundedEdgeToleranceCmd->SetParameterName("tolerance", false);
+        m_roundedEdgeToleranceCmd->SetRange("tolerance > 0");
+        m_roundedEdgeToleranceCmd->SetUnitCategory("Length");
+        m_roundedEdgeToleranceCmd->SetToBeBroadcasted(false);
+
+        m_validateCrystalCmd = make_shared<G4UIcmdWithABool>("/Geometry/HPGeDetector/validateCrystal", this);
+        m_validateCrystalCmd->SetGuidance("Print the crystal volumes and masses of both shapes and of the analytic model.");
+        m_validateCrystalCmd->SetParameterName("validate", true);
+        m_validateCrystalCmd->SetDefaultValue(true);
+        m_validateCrystalCmd->SetToBeBroadcasted(false);
 }
 
 HPGeDetector::~HPGeDetector()
 {
 }
 
+void HPGeDetector::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_depthRecordCmd.get())
+    {
+        m_depthRecordBinWidth = m_depthRecordCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_crystalShapeCmd.get())
+    {
+        m_crystalShape = (newValue == "polycone") ? crystalPolycone : crystalBoolean;
+        SetModified();
+    }
+    else if (command == m_roundedEdgeToleranceCmd.get())
+    {
+        m_roundedEdgeTolerance = m_roundedEdgeToleranceCmd->GetNewDoubleValue(newValue);
+        SetModified();
+    }
+    else if (command == m_validateCrystalCmd.get())
+    {
+        m_validateCrystal = m_validateCrystalCmd->GetNewBoolValue(newValue);
+    }
+    else
+    {
+        GeometryObject::SetNewValue(command, newValue);
+    }
+}
+
+void HPGeDetector::GetDeadLayerDepths(const G4ThreeVector &position, G4double depths[4]) const
+{
+    // The frame of the full crystal has its origin in the center of the back
+    // cylinder, the front face points to -z. The depths follow the dead layer
+    // model of Construct(): the outside layer shifts the radial surface
+    // (including the rounded edge) inwards, the front layer cuts a slab off
+    // the front. The inside layer is measured from the physical borehole.
+    const G4double r = position.perp();
+    const G4double z = position.z();
+
+    const G4double zFront = -0.5*m_crystalBackHeight - m_crystalEdgeRadius;
+    const G4double zBack = 0.5*m_crystalBackHeight;
+    const G4double zEdge = -0.5*m_crystalBackHeight;
+    const G4double zHoleBottom = zBack - (m_holeDepth - m_holeRadius);
+
+    depths[0] = z - zFront;
+
+    if (z >= zEdge)
+    {
+        depths[1] = m_crystalRadius - r;
+    }
+    else
+    {
+        const G4double dz = zEdge - z;
+        const G4double edge = m_crystalEdgeRadius*m_crystalEdgeRadius - dz*dz;
+        depths[1] = m_crystalRadius - m_crystalEdgeRadius + std::sqrt(edge > 0 ? edge : 0) - r;
+    }
+
+    if (z >= zHoleBottom)
+    {
+        depths[2] = r - m_holeRadius;
+    }
+    else
+    {
+        depths[2] = std::hypot(r, z - zHoleBottom) - m_holeRadius;
+    }
+
+    depths[3] = zBack - z;
+}
+
+void HPGeDetector::ConstructBooleanCrystal(G4VSolid* &fullDetectorSolid, G4VSolid* &activeDetectorSolid)
+{
+    // Shape is generated by boolean solid (G4Torus + G4Tubs + G4Tubs) - G4Sphere - G4Tubs
+
+    G4RotationMatrix noRotation;
+
+    const G4double phiMin = 0.0*deg;
+    const G4double phiMax = 360.0*deg;
+
+    const G4double thetaMin = 0.0*deg;
+    const G4double thetaMax = 180.0*deg;
+
+    auto fullTorusSolid =
+        new G4Torus(CreateSolidName("fullTorus"),
+                    0.0*cm, // inner radius
+                    GetDimension("detectorRoundedEdgeRadius"), // outer radius
+                    0.5*GetDimension("detectorDiameter")-GetDimension("detectorRoundedEdgeRadius"), // torus radius
+                    phiMin,
+                    phiMax);
+
+    auto fullFrontCylinderSolid =
+        new G4Tubs(CreateSolidName("fullFrontCylinder"),
+                   0.0, // inner radius
+                   0.5*GetDimension("detectorDiameter") - GetDimension("detectorRoundedEdgeRadius"), // outer radius
+                   GetDimension("detectorRoundedEdgeRadius"),
+                   phiMin,
+                   phiMax);
+
+    const auto fullBackCylinderHeight = GetDimension("detectorLength") - GetDimension("detectorRoundedEdgeRadius");
+    auto fullBackCylinderSolid =
+        new G4Tubs(CreateSolidName("fullBackCylinder"),
+                   0.0,
+                   0.5*GetDimension("detectorDiameter"),
+                   0.5*fullBackCylinderHeight,
+                   phiMin,
+                   phiMax);
+
+    const G4double tolerance = 10*mm; // make sure we cut the hole through
+
+    auto fullBoreholeCylinderSolid =
+        new G4Tubs(CreateSolidName("fullBoreholeCylinder"),
+                   0.0,
+                   0.5*GetDimension("detectorHoleDiameter"),
+                   0.5*(GetDimension("detectorHoleDepth")-0.5*GetDimension("detectorHoleDiameter")+tolerance),
+                   phiMin, phiMax);
+
+    auto fullBoreholeSphereSolid =
+        new G4Sphere(CreateSolidName("fullBoreholeSphere"),
+                    0.0,
+                    0.5*GetDimension("detectorHoleDiameter"),
+                    phiMin, phiMax,
+                    thetaMin, thetaMax);
+
+    fullDetectorSolid =
+        new G4UnionSolid(CreateSolidName("detectorStep1"),
+                         fullBackCylinderSolid, fullTorusSolid,
+                         &noRotation,
+                         G4ThreeVector(0, 0, -0.5*fullBackCylinderHeight));
+
+    fullDetectorSolid =
+        new G4UnionSolid(CreateSolidName("detectorStep2"),
+                         fullDetectorSolid , fullFrontCylinderSolid,
+                         &noRotation,
+                         G4ThreeVector(0, 0, -0.5*fullBackCylinderHeight));
+
+    fullDetectorSolid =
+        new G4SubtractionSolid(CreateSolidName("detectorStep3"),
+                               fullDetectorSolid, fullBoreholeSphereSolid,
+                               &noRotation,
+                               G4ThreeVector(0, 0, 0.5*fullBackCylinderHeight-(GetDimension("detectorHoleDepth")-0.5*GetDimension("detectorHoleDiameter"))));
+
+    fullDetectorSolid =
+        new G4SubtractionSolid(CreateSolidName("detectorStep4"),
+                               fullDetectorSolid, fullBoreholeCylinderSolid,
+                               &noRotation,
+                               G4ThreeVector(0, 0, 0.5*fullBackCylinderHeight + fullBoreholeCylinderSolid->GetZHalfLength() - (GetDimension("detectorHoleDepth")-0.5*GetDimension("detectorHoleDiameter"))));
+
+    // Add dead layers
+    // With exception of the front dead layer, we essentially can build a smaller version of the full detector to obtain the active detector.
+
+    auto activeTorusSolid =
+        new G4Torus(CreateSolidName("activeTorus"),
+                    0.0*cm, // inner radius
+                    GetDimension("detectorRoundedEdgeRadius"), // outer radius
+                    0.5*GetDimension("detectorDiameter")-GetDimension("detectorRoundedEdgeRadius")-GetDimension("detectorDeadLayerOutside"), // torus radius
+                    phiMin,
+                    phiMax);
+
+    auto activeFrontCylinderSolid =
+        new G4Tubs(CreateSolidName("activeFrontCylinder"),
+                   0.0, // inner radius
+                   0.5*GetDimension("detectorDiameter")-GetDimension("detectorRoundedEdgeRadius")-GetDimension("detectorDeadLayerOutside"), // outer radius
+                   GetDimension("detectorRoundedEdgeRadius"),
+                   phiMin,
+                   phiMax);
+
+    const auto activeBackCylinderHeight = GetDimension("detectorLength")-GetDimension("detectorRoundedEdgeRadius")-GetDimension("detectorDeadLayerBack");
+    auto activeBackCylinderSolid =
+        new G4Tubs(CreateSolidName("activeBackCylinder"),
+                   0.0,
+                   0.5*GetDimension("detectorDiameter")-GetDimension("detectorDeadLayerOutside"),
+                   0.5*activeBackCylinderHeight,
+                   phiMin,
+                   phiMax);
+
+    auto activeBoreholeCylinderSolid =
+        new G4Tubs(CreateSolidName("activeBoreholeCylinder"),
+                   0.0,
+                   0.5*GetDimension("detectorHoleDiameter")+GetDimension("detectorDeadLayerInside"),
+                   0.5*(GetDimension("detectorHoleDepth")-0.5*GetDimension("detectorHoleDiameter")+tolerance),
+                   phiMin, phiMax);
+
+    auto activeBoreholeSphereSolid =
+        new G4Sphere(CreateSolidName("activeBoreholeSphere"),
+                    0.0,
+                    0.5*GetDimension("detectorHoleDiameter")+GetDimension("detectorDeadLayerInside"),
+                    phiMin, phiMax,
+                    thetaMin, thetaMax);
+
+    activeDetectorSolid =
+        new G4UnionSolid(CreateSolidName("detectorStep1"),
+                         activeBackCylinderSolid, activeTorusSolid,
+                         &noRotation,
+                         G4ThreeVector(0, 0, -0.5*activeBackCylinderHeight));
+
+    activeDetectorSolid =
+        new G4UnionSolid(CreateSolidName("detectorStep2"),
+                         activeDetectorSolid , activeFrontCylinderSolid,
+                         &noRotation,
+                         G4ThreeVector(0, 0, -0.5*activeBackCylinderHeight));
+
+    activeDetectorSolid =
+        new G4SubtractionSolid(CreateSolidName("detectorStep3"),
+                               activeDetectorSolid, activeBoreholeSphereSolid,
+                               &noRotation,
+                               G4ThreeVector(0, 0, 0.5*activeBackCylinderHeight-(GetDimension("detectorHoleDepth")-0.5*GetDimension("detectorHoleDiameter"))));
+
+    activeDetectorSolid =
+        new G4SubtractionSolid(CreateSolidName("detectorStep4"),
+                               activeDetectorSolid, activeBoreholeCylinderSolid,
+                               &noRotation,
+                               G4ThreeVector(0, 0, 0.5*activeBackCylinderHeight + activeBoreholeCylinderSolid->GetZHalfLength() - (GetDimension("detectorHoleDepth")-0.5*GetDimension("detectorHoleDiameter"))));
+
+
+    auto deadLayerFrontCylinderSolid =
+        new G4Tubs(CreateSolidName("deadLayerFront1"), 0, 0.5*GetDimension("detectorDiameter")+tolerance, 0.5*GetDimension("detectorDeadLayerFront")+tolerance, phiMin, phiMax);
+    activeDetectorSolid =
+        new G4SubtractionSolid(CreateSolidName("activeDetectorStep1"),
+                                activeDetectorSolid,
+                                deadLayerFrontCylinderSolid,
+                                &noRotation,
+                                G4ThreeVector(0,0,-0.5*activeBackCylinderHeight-GetDimension("detectorRoundedEdgeRadius")-deadLayerFrontCylinderSolid->GetZHalfLength()+GetDimension("detectorDeadLayerFront")));
+}
+
+HPGeDetector::CrystalModel HPGeDetector::GetCrystalModel(G4bool active)
+{
+    // The active volume is a smaller version of the full crystal (as in the
+    // boolean model), with the front dead layer cut off
+    CrystalModel model;
+    model.edgeRadius = GetDimension("detectorRoundedEdgeRadius");
+    model.holeCenterDepth = GetDimension("detectorHoleDepth") - 0.5*GetDimension("detectorHoleDiameter");
+
+    const auto fullBackCylinderHeight = GetDimension("detectorLength") - GetDimension("detectorRoundedEdgeRadius");
+    if (active)
+    {
+        model.outerRadius = 0.5*GetDimension("detectorDiameter") - GetDimension("detectorDeadLayerOutside");
+        model.backHeight = fullBackCylinderHeight - GetDimension("detectorDeadLayerBack");
+        model.zFrontCut = -0.5*model.backHeight - model.edgeRadius + GetDimension("detectorDeadLayerFront");
+        model.holeRadius = 0.5*GetDimension("detectorHoleDiameter") + GetDimension("detectorDeadLayerInside");
+    }
+    else
+    {
+        model.outerRadius = 0.5*GetDimension("detectorDiameter");
+        model.backHeight = fullBackCylinderHeight;
+        model.zFrontCut = -0.5*model.backHeight - model.edgeRadius;
+        model.holeRadius = 0.5*GetDimension("detectorHoleDiameter");
+    }
+    return model;
+}
+
+G4double HPGeDetector::GetCrystalModelVolume(const CrystalModel &model)
+{
+    const G4double rho = model.edgeRadius;
+    const G4double zEdge = -0.5*model.backHeight;
+    const G4double zBack = 0.5*model.backHeight;
+
+    // cylindrical part behind the rounded edge
+    G4double volume = pi*model.outerRadius*model.outerRadius*(zBack - std::max(zEdge, model.zFrontCut));
+
+    // rounded part, r(u) = c + sqrt(rho^2 - u^2) with u the distance in front of zEdge
+    if (model.zFrontCut < zEdge)
+    {
+        const G4double u = std::min(zEdge - model.zFrontCut, rho);
+        const G4double c = model.outerRadius - rho;
+        const G4double integralSqrt = 0.5*(u*std::sqrt(rho*rho - u*u) + rho*rho*std::asin(u/rho));
+        volume += pi*(c*c*u + 2*c*integralSqrt + rho*rho*u - u*u*u/3);
+    }
+
+    // borehole: cylinder and half sphere
+    const G4double h = model.holeRadius;
+    volume -= pi*h*h*model.holeCenterDepth + 2.0/3.0*pi*h*h*h;
+
+    return volume;
+}
+
+void HPGeDetector::AddArc(vector<G4double> &r, vector<G4double> &z,
+                          G4double rCenter, G4double zCenter, G4double radius,
+                          G4double angleFrom, G4double angleTo) const
+{
+    // Angles are measured from -z towards +r. The chords stay within the
+    // rounded edge tolerance of the arc.
+    const G4double maxStep = 2*std::acos(1 - std::min(m_roundedEdgeTolerance/radius, 1.0));
+    const G4int nSteps = std::max(1, static_cast<G4int>(std::ceil(std::abs(angleTo - angleFrom)/maxStep)));
+    for (G4int i = 0; i <= nSteps; i++)
+    {
+        const G4double angle = angleFrom + (angleTo - angleFrom)*i/nSteps;
+        r.push_back(rCenter + radius*std::sin(angle));
+        z.push_back(zCenter - radius*std::cos(angle));
+    }
+}
+
+G4GenericPolycone* HPGeDetector::CreateCrystalProfile(G4String name, const CrystalModel &model)
+{
+    // Same frame as the boolean crystal: the cylindrical part is centered at
+    // the origin, the rounded edge is at the front (-z) around z = zEdge.
+    // The front is cut flat at zFrontCut, the borehole (a cylinder ending in
+    // a half sphere) comes in from the back.
+    const G4double zEdge = -0.5*model.backHeight;
+    const G4double zBack = 0.5*model.backHeight;
+    const G4double zHoleCenter = zBack - model.holeCenterDepth;
+
+    vector<G4double> r, z;
+
+    // front face and rounded edge, starting where the front cut meets the edge
+    r.push_back(0);
+    z.push_back(model.zFrontCut);
+    if (model.zFrontCut < zEdge)
+    {
+        AddArc(r, z, model.outerRadius - model.edgeRadius, zEdge, model.edgeRadius,
+               std::acos(std::min((zEdge - model.zFrontCut)/model.edgeRadius, 1.0)), 0.5*pi);
+    }
+    else
+    {
+        r.push_back(model.outerRadius);
+        z.push_back(model.zFrontCut);
+    }
+
+    // outside and back face
+    r.push_back(model.outerRadius);
+    z.push_back(zBack);
+    r.push_back(model.holeRadius);
+    z.push_back(zBack);
+
+    // borehole, the half sphere is traversed from its rim to the axis
+    vector<G4double> rHole, zHole;
+    AddArc(rHole, zHole, 0, zHoleCenter, model.holeRadius, 0, 0.5*pi);
+    for (size_t i = rHole.size(); i-- > 0; )
+    {
+        r.push_back(rHole[i]);
+        z.push_back(zHole[i]);
+    }
+
+    return new G4GenericPolycone(CreateSolidName(name), 0.0*deg, 360.0*deg, r.size(), r.data(), z.data());
+}
+
+G4double HPGeDetector::GetProfileVolume(const G4GenericPolycone *solid)
+{
+    // exact volume of the revolved polygon, sum over the edges of the cone frusta
+    G4double volume = 0;
+    const G4int n = solid->GetNumRZCorner();
+    for (G4int i = 0; i < n; i++)
+    {
+        const auto a = solid->GetCorner(i);
+        const auto b = solid->GetCorner((i + 1) % n);
+        volume += (b.z - a.z)*(a.r*a.r + a.r*b.r + b.r*b.r);
+    }
+    return std::abs(volume)*pi/3;
+}
+
+void HPGeDetector::ConstructPolyconeCrystal(G4VSolid* &fullDetectorSolid, G4VSolid* &activeDetectorSolid)
+{
+    fullDetectorSolid = CreateCrystalProfile("detectorProfile", GetCrystalModel(false));
+    activeDetectorSolid = CreateCrystalProfile("activeDetectorProfile", GetCrystalModel(true));
+}
+
+void HPGeDetector::PrintCrystalValidation(G4VSolid *fullDetectorSolid, G4VSolid *activeDetectorSolid, G4double density)
+{
+    // Builds the solids of the other shape as well (they are not placed),
+    // the boolean volumes are Monte Carlo estimates of Geant4
+    G4VSolid *booleanFull = fullDetectorSolid, *booleanActive = activeDetectorSolid;
+    G4VSolid *polyconeFull = fullDetectorSolid, *polyconeActive = activeDetectorSolid;
+    if (m_crystalShape == crystalPolycone)
+        ConstructBooleanCrystal(booleanFull, booleanActive);
+    else
+        ConstructPolyconeCrystal(polyconeFull, polyconeActive);
+
+    const G4double analytic[2] = {GetCrystalModelVolume(GetCrystalModel(false)), GetCrystalModelVolume(GetCrystalModel(true))};
+    const G4double profile[2] = {GetProfileVolume(static_cast<G4GenericPolycone*>(polyconeFull)),
+                                 GetProfileVolume(static_cast<G4GenericPolycone*>(polyconeActive))};
+    const G4double boolean[2] = {booleanFull->GetCubicVolume(), booleanActive->GetCubicVolume()};
+
+    const char *names[2] = {"full crystal  ", "active crystal"};
+    G4cout << "HPGe crystal volumes (cm3) / masses (g), rounded edge tolerance " << m_roundedEdgeTolerance/um << " um:" << G4endl;
+    G4cout << "                 analytic            polycone            boolean" << G4endl;
+    for (int i = 0; i < 2; i++)
+    {
+        G4cout << "  " << names[i]
+               << "  " << analytic[i]/cm3 << " / " << analytic[i]*density/g
+               << "  " << profile[i]/cm3 << " / " << profile[i]*density/g
+               << "  " << boolean[i]/cm3 << " / " << boolean[i]*density/g << G4endl;
+        G4cout << "  relative difference to analytic: polycone " << profile[i]/analytic[i] - 1
+               << ", boolean " << boolean[i]/analytic[i] - 1 << G4endl;
+    }
+}
+
 G4VPhysicalVolume* HPGeDetector::Construct() {
 
     auto nistManager = G4NistManager::Instance();
@@ -104,14 +521,9 @@ G4VPhysicalVolume* HPGeDetector::Construct() {
 
     // ----- General parameters for the detector
 
-    G4RotationMatrix noRotation;
-
     const G4double phiMin = 0.0*deg;
     const G4double phiMax = 360.0*deg;
 
-    const G4double thetaMin = 0.0*deg;
-    const G4double thetaMax = 180.0*deg;
-
 
     // Outer casing is a hollow cylinder (open on one side) of Aluminum
     const auto outerCasingMaterial = matAl; //
@@ -211,154 +623,38 @@ G4VPhysicalVolume* HPGeDetector::Construct() {
     }
 
     // Construct and place crystal
-    // Shape is generated by boolean solid (G4Torus + G4Tubs + G4Tubs) - G4Sphere - G4Tubs
+    // The shape is either a boolean solid or a polycone profile, see
+    // ConstructBooleanCrystal() and ConstructPolyconeCrystal()
     {
-        auto fullTorusSolid =
-            new G4Torus(CreateSolidName("fullTorus"),
-                        0.0*cm, // inner radius
-                        GetDimension("detectorRoundedEdgeRadius"), // outer radius
-                        0.5*GetDimension("detectorDiameter")-GetDimension("detectorRoundedEdgeRadius"), // torus radius
-                        phiMin,
-                        phiMax);
-
-        auto fullFrontCylinderSolid =
-            new G4Tubs(CreateSolidName("fullFrontCylinder"),
-                       0.0, // inner radius
-                       0.5*GetDimension("detectorDiameter") - GetDimension("detectorRoundedEdgeRadius"), // outer radius
-                       GetDimension("detectorRoundedEdgeRadius"),
-                       phiMin,
-                       phiMax);
+        G4VSolid* fullDetectorSolid = nullptr;
+        G4VSolid* activeDetectorSolid = nullptr;
+        if (m_crystalShape == crystalPolycone)
+        {
+            ConstructPolyconeCrystal(fullDetectorSolid, activeDetectorSolid);
+        }
+        else
+        {
+            ConstructBooleanCrystal(fullDetectorSolid, activeDetectorSolid);
+        }
+
+        if (m_validateCrystal)
+        {
+            PrintCrystalValidation(fullDetectorSolid, activeDetectorSolid, detectorMaterial->GetDensity());
+        }
 
         const auto fullBackCylinderHeight = GetDimension("detectorLength") - GetDimension("detectorRoundedEdgeRadius");
-        auto fullBackCylinderSolid =
-            new G4Tubs(CreateSolidName("fullBackCylinder"),
-                       0.0,
-                       0.5*GetDimension("detectorDiameter"),
-                       0.5*fullBackCylinderHeight,
-                       phiMin,
-                       phiMax);
-
-        const G4double tolerance = 10*mm; // make sure we cut the hole through
-
-        auto fullBoreholeCylinderSolid =
-            new G4Tubs(CreateSolidName("fullBoreholeCylinder"),
-                       0.0,
-                       0.5*GetDimension("detectorHoleDiameter"),
-                       0.5*(GetDimension("detectorHoleDepth")-0.5*GetDimension("detectorHoleDiameter")+tolerance),
-                       phiMin, phiMax);
-
-        auto fullBoreholeSphereSolid =
-            new G4Sphere(CreateSolidName("fullBoreholeSphere"),
-                        0.0,
-                        0.5*GetDimension("detectorHoleDiameter"),
-                        phiMin, phiMax,
-                        thetaMin, thetaMax);
-
-        G4VSolid* fullDetectorSolid =
-            new G4UnionSolid(CreateSolidName("detectorStep1"),
-                             fullBackCylinderSolid, fullTorusSolid,
-                             &noRotation,
-                             G4ThreeVector(0, 0, -0.5*fullBackCylinderHeight));
-
-        fullDetectorSolid =
-            new G4UnionSolid(CreateSolidName("detectorStep2"),
-                             fullDetectorSolid , fullFrontCylinderSolid,
-                             &noRotation,
-                             G4ThreeVector(0, 0, -0.5*fullBackCylinderHeight));
-
-        fullDetectorSolid =
-            new G4SubtractionSolid(CreateSolidName("detectorStep3"),
-                                   fullDetectorSolid, fullBoreholeSphereSolid,
-                                   &noRotation,
-                                   G4ThreeVector(0, 0, 0.5*fullBackCylinderHeight-(GetDimension("detectorHoleDepth")-0.5*GetDimension("detectorHoleDiameter"))));
-
-        fullDetectorSolid =
-            new G4SubtractionSolid(CreateSolidName("detectorStep4"),
-                                   fullDetectorSolid, fullBoreholeCylinderSolid,
-                                   &noRotation,
-                                   G4ThreeVector(0, 0, 0.5*fullBackCylinderHeight + fullBoreholeCylinderSolid->GetZHalfLength() - (GetDimension("detectorHoleDepth")-0.5*GetDimension("detectorHoleDiameter"))));
 
         auto fullDetectorLogical =
             new G4LogicalVolume(fullDetectorSolid, detectorMaterial, CreateLogicalName("detector"));
 
         fullDetectorLogical->SetVisAttributes(G4VisAttributes(G4Colour::Yellow()));
 
-
-        // Add dead layers
-        // With exception of the front dead layer, we essentially can build a smaller version of the full detector to obtain the active detector.
-
-        auto activeTorusSolid =
-            new G4Torus(CreateSolidName("activeTorus"),
-                        0.0*cm, // inner radius
-                        GetDimension("detectorRoundedEdgeRadius"), // outer radius
-                        0.5*GetDimension("detectorDiameter")-GetDimension("detectorRoundedEdgeRadius")-GetDimension("detectorDeadLayerOutside"), // torus radius
-                        phiMin,
-                        phiMax);
-
-        auto activeFrontCylinderSolid =
-            new G4Tubs(CreateSolidName("activeFrontCylinder"),
-                       0.0, // inner radius
-                       0.5*GetDimension("detectorDiameter")-GetDimension("detectorRoundedEdgeRadius")-GetDimension("detectorDeadLayerOutside"), // outer radius
-                       GetDimension("detectorRoundedEdgeRadius"),
-                       phiMin,
-                       phiMax);
-
-        const auto activeBackCylinderHeight = GetDimension("detectorLength")-GetDimension("detectorRoundedEdgeRadius")-GetDimension("detectorDeadLayerBack");
-        auto activeBackCylinderSolid =
-            new G4Tubs(CreateSolidName("activeBackCylinder"),
-                       0.0,
-                       0.5*GetDimension("detectorDiameter")-GetDimension("detectorDeadLayerOutside"),
-                       0.5*activeBackCylinderHeight,
-                       phiMin,
-                       phiMax);
-
-        auto activeBoreholeCylinderSolid =
-            new G4Tubs(CreateSolidName("activeBoreholeCylinder"),
-                       0.0,
-                       0.5*GetDimension("detectorHoleDiameter")+GetDimension("detectorDeadLayerInside"),
-                       0.5*(GetDimension("detectorHoleDepth")-0.5*GetDimension("detectorHoleDiameter")+tolerance),
-                       phiMin, phiMax);
-
-        auto activeBoreholeSphereSolid =
-            new G4Sphere(CreateSolidName("activeBoreholeSphere"),
-                        0.0,
-                        0.5*GetDimension("detectorHoleDiameter")+GetDimension("detectorDeadLayerInside"),
-                        phiMin, phiMax,
-                        thetaMin, thetaMax);
-
-        G4VSolid* activeDetectorSolid =
-            new G4UnionSolid(CreateSolidName("detectorStep1"),
-                             activeBackCylinderSolid, activeTorusSolid,
-                             &noRotation,
-                             G4ThreeVector(0, 0, -0.5*activeBackCylinderHeight));
-
-        activeDetectorSolid =
-            new G4UnionSolid(CreateSolidName("detectorStep2"),
-                             activeDetectorSolid , activeFrontCylinderSolid,
-                             &noRotation,
-                             G4ThreeVector(0, 0, -0.5*activeBackCylinderHeight));
-
-        activeDetectorSolid =
-            new G4SubtractionSolid(CreateSolidName("detectorStep3"),
-                                   activeDetectorSolid, activeBoreholeSphereSolid,
-                                   &noRotation,
-                                   G4ThreeVector(0, 0, 0.5*activeBackCylinderHeight-(GetDimension("detectorHoleDepth")-0.5*GetDimension("detectorHoleDiameter"))));
-
-        activeDetectorSolid =
-            new G4SubtractionSolid(CreateSolidName("detectorStep4"),
-                                   activeDetectorSolid, activeBoreholeCylinderSolid,
-                                   &noRotation,
-                                   G4ThreeVector(0, 0, 0.5*activeBackCylinderHeight + activeBoreholeCylinderSolid->GetZHalfLength() - (GetDimension("detectorHoleDepth")-0.5*GetDimension("detectorHoleDiameter"))));
-
-
-        auto deadLayerFrontCylinderSolid =
-            new G4Tubs(CreateSolidName("deadLayerFront1"), 0, 0.5*GetDimension("detectorDiameter")+tolerance, 0.5*GetDimension("detectorDeadLayerFront")+tolerance, phiMin, phiMax);
-        activeDetectorSolid =
-            new G4SubtractionSolid(CreateSolidName("activeDetectorStep1"),
-                                    activeDetectorSolid,
-                                    deadLayerFrontCylinderSolid,
-                                    &noRotation,
-                                    G4ThreeVector(0,0,-0.5*activeBackCylinderHeight-GetDimension("detectorRoundedEdgeRadius")-deadLayerFrontCylinderSolid->GetZHalfLength()+GetDimension("detectorDeadLayerFront")));
+        m_crystalVolume = fullDetectorLogical;
+        m_crystalRadius = 0.5*GetDimension("detectorDiameter");
+        m_crystalBackHeight = fullBackCylinderHeight;
+        m_crystalEdgeRadius = GetDimension("detectorRoundedEdgeRadius");
+        m_holeRadius = 0.5*GetDimension("detectorHoleDiameter");
+        m_holeDepth = GetDimension("detectorHoleDepth");
 
         auto activeDetectorLogical =
             new G4LogicalVolume(activeDetectorSolid, detectorMaterial, CreateLogicalName("crystal"));
@@ -0,0 +1,196 @@
+#include "LiveExport.hh"
+
+#include "EnergyHistogram.hh"
+
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+
+#include "G4SystemOfUnits.hh"
+using CLHEP::MeV;
+using CLHEP::s;
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <memory>
+using std::make_shared;
+
+#include <stdexcept>
+using std::runtime_error;
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "Unexpected size of the sequence number");
+
+LiveExport::LiveExport(EnergyHistogram* energyHistogram)
+    : G4UImessenger(),
+      m_energyHistogram(energyHistogram),
+      m_interval(1*s)
+{
+    m_fileNameCmd = make_shared<G4UIcmdWithAString>("/LiveExport/fileName", this);
+    m_fileNameCmd->SetGuidance("Publish the spectrum during the runs into this memory-mapped file");
+    m_fileNameCmd->SetGuidance("(e.g. /dev/shm/G4_HPGe.live), \"none\" disables it.");
+    m_fileNameCmd->SetParameterName("fileName", false);
+    m_fileNameCmd->SetToBeBroadcasted(false);
+
+    m_intervalCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/LiveExport/interval", this);
+    m_intervalCmd->SetGuidance("Time between two updates of the file.");
+    m_intervalCmd->SetParameterName("interval", false);
+    m_intervalCmd->SetUnitCategory("Time");
+    m_intervalCmd->SetDefaultUnit("s");
+    m_intervalCmd->SetRange("interval > 0");
+    m_intervalCmd->SetToBeBroadcasted(false);
+}
+
+LiveExport::~LiveExport()
+{
+    EndOfRun();
+    Close();
+}
+
+void LiveExport::BeginOfRun(const G4int runID)
+{
+    if (!m_map)
+    {
+        return;
+    }
+
+    m_runID = runID;
+    m_startTime = m_lastTime = std::chrono::steady_clock::now();
+    m_lastEvents = 0;
+
+    m_stop = false;
+    m_thread = std::thread(&LiveExport::Loop, this);
+}
+
+void LiveExport::EndOfRun()
+{
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_threadMutex);
+        m_stop = true;
+    }
+    m_wakeUp.notify_all();
+    m_thread.join();
+
+    // the final spectrum
+    Publish();
+}
+
+void LiveExport::Loop()
+{
+    const auto interval = std::chrono::duration<G4double>(m_interval/s);
+
+    std::unique_lock<std::mutex> lock(m_threadMutex);
+    while (!m_wakeUp.wait_for(lock, interval, [this] {return m_stop;}))
+    {
+        Publish();
+    }
+}
+
+void LiveExport::Publish()
+{
+    double events;
+    m_energyHistogram->GetContents(m_contents, events);
+
+    const auto now = std::chrono::steady_clock::now();
+    const std::chrono::duration<double> sinceStart = now - m_startTime;
+    const std::chrono::duration<double> sinceLast = now - m_lastTime;
+    const double rate = sinceLast.count() > 0 ? (events - m_lastEvents)/sinceLast.count() : 0;
+    m_lastTime = now;
+    m_lastEvents = events;
+
+    const std::chrono::duration<double> epoch = std::chrono::system_clock::now().time_since_epoch();
+
+    // seqlock: odd sequence numbers mark an update in progress
+    auto header = static_cast<Header*>(m_map);
+    const uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    header->runID = m_runID;
+    header->events = events;
+    header->rate = rate;
+    header->runTime = sinceStart.count();
+    header->updateTime = epoch.count();
+    auto bins = reinterpret_cast<double*>(static_cast<char*>(m_map) + sizeof(Header));
+    std::memcpy(bins, m_contents.data(), m_contents.size()*sizeof(double));
+
+    header->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void LiveExport::Open()
+{
+    static_assert(sizeof(Header) == 80, "The header does not match the documented layout");
+
+    const int nBins = m_energyHistogram->GetNbins();
+    m_mapSize = sizeof(Header) + (nBins+2)*sizeof(double);
+
+    const int fd = open(m_fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        throw runtime_error("LiveExport: could not create '" + m_fileName + "'");
+    }
+    if (ftruncate(fd, m_mapSize) != 0)
+    {
+        close(fd);
+        throw runtime_error("LiveExport: could not resize '" + m_fileName + "'");
+    }
+    void* map = mmap(nullptr, m_mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        throw runtime_error("LiveExport: could not map '" + m_fileName + "'");
+    }
+    m_map = map;
+
+    // the file is zero-filled, the fixed fields are written once
+    auto header = static_cast<Header*>(m_map);
+    header->version = 1;
+    header->nBins = nBins;
+    header->Emin = m_energyHistogram->GetEmin()/MeV;
+    header->Emax = m_energyHistogram->GetEmax()/MeV;
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, "G4HPGeLV", sizeof(header->magic));
+
+    G4cout << "LiveExport: publishing the spectrum to " << m_fileName << G4endl;
+}
+
+void LiveExport::Close()
+{
+    if (m_map)
+    {
+        msync(m_map, m_mapSize, MS_ASYNC);
+        munmap(m_map, m_mapSize);
+        m_map = nullptr;
+    }
+}
+
+void LiveExport::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_fileNameCmd.get())
+    {
+        if (m_thread.joinable())
+        {
+            throw runtime_error("LiveExport: the file cannot be changed during a run");
+        }
+        Close();
+        m_fileName = newValue;
+        if (m_fileName != "none")
+        {
+            Open();
+        }
+    }
+    else if (command == m_intervalCmd.get())
+    {
+        m_interval = m_intervalCmd->GetNewDoubleValue(newValue);
+    }
+    else
+    {
+        throw runtime_error("Unknown command in LiveExport::SetNewValue()");
+    }
+}
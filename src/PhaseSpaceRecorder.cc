@@ -0,0 +1,295 @@
+#include "PhaseSpaceRecorder.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4Gamma.hh"
+#include "G4ParticleDefinition.hh"
+
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWith3VectorAndUnit.hh"
+
+#include "G4SystemOfUnits.hh"
+using CLHEP::cm;
+using CLHEP::mm;
+using CLHEP::MeV;
+using CLHEP::ns;
+
+#include <algorithm>
+#include <cmath>
+
+#include <memory>
+using std::make_shared;
+
+#include <stdexcept>
+using std::runtime_error;
+
+PhaseSpaceRecorder::Writer::Writer(const PhaseSpaceRecorder* recorder, const G4int index)
+    : m_recorder(recorder),
+      m_index(index)
+{}
+
+PhaseSpaceRecorder::Writer::~Writer()
+{
+    Close();
+    if (!m_fileName.empty())
+    {
+        std::remove(m_fileName.c_str());
+    }
+}
+
+void PhaseSpaceRecorder::Writer::Step(const G4Step* step)
+{
+    if (!m_recorder->IsEnabled())
+    {
+        return;
+    }
+
+    // only steps from inside to outside of the cylinder
+    const G4ThreeVector pre = step->GetPreStepPoint()->GetPosition() - m_recorder->m_center;
+    const G4ThreeVector post = step->GetPostStepPoint()->GetPosition() - m_recorder->m_center;
+    if (!m_recorder->IsInside(pre) || m_recorder->IsInside(post))
+    {
+        return;
+    }
+
+    G4Track* track = step->GetTrack();
+    track->SetTrackStatus(fStopAndKill);
+
+    const G4ParticleDefinition* particle = track->GetParticleDefinition();
+    if (m_recorder->m_gammasOnly && particle != G4Gamma::Gamma())
+    {
+        return;
+    }
+
+    // point where the step leaves the cylinder, exact for straight steps
+    const G4ThreeVector delta = post - pre;
+    G4double t = 1;
+    if (delta.z() != 0)
+    {
+        const G4double zExit = (delta.z() > 0) ? m_recorder->m_halfLength : -m_recorder->m_halfLength;
+        t = std::min(t, (zExit - pre.z())/delta.z());
+    }
+    const G4double a = delta.perp2();
+    if (a > 0)
+    {
+        const G4double radius = m_recorder->m_radius;
+        const G4double b = pre.x()*delta.x() + pre.y()*delta.y();
+        const G4double c = pre.perp2() - radius*radius;
+        t = std::min(t, (-b + std::sqrt(b*b - a*c))/a);
+    }
+    const G4ThreeVector crossing = m_recorder->m_center + pre + t*delta;
+    const G4ThreeVector direction = step->GetPostStepPoint()->GetMomentumDirection();
+
+    EventFilePrimary primary;
+    primary.pdg = particle->GetPDGEncoding();
+    primary.weight = step->GetPostStepPoint()->GetWeight();
+    primary.energy = step->GetPostStepPoint()->GetKineticEnergy()/MeV;
+    primary.x = crossing.x()/mm;
+    primary.y = crossing.y()/mm;
+    primary.z = crossing.z()/mm;
+    primary.dx = direction.x();
+    primary.dy = direction.y();
+    primary.dz = direction.z();
+    primary.time = step->GetPostStepPoint()->GetGlobalTime()/ns;
+
+    if (!m_file)
+    {
+        Open();
+    }
+    std::fwrite(&primary, sizeof(primary), 1, m_file);
+    m_primaries++;
+}
+
+void PhaseSpaceRecorder::Writer::EndOfEvent()
+{
+    if (!m_recorder->IsEnabled())
+    {
+        return;
+    }
+
+    if (!m_file)
+    {
+        Open();
+    }
+    m_eventPrimaries.push_back(m_primaries);
+    m_primaries = 0;
+}
+
+void PhaseSpaceRecorder::Writer::Open()
+{
+    m_fileName = m_recorder->m_fileName + ".part" + std::to_string(m_index);
+    m_file = std::fopen(m_fileName.c_str(), "wb");
+    if (!m_file)
+    {
+        throw runtime_error("PhaseSpaceRecorder: could not create " + m_fileName);
+    }
+    std::setvbuf(m_file, nullptr, _IOFBF, 1 << 20);
+}
+
+void PhaseSpaceRecorder::Writer::Close()
+{
+    if (m_file)
+    {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+PhaseSpaceRecorder::PhaseSpaceRecorder()
+    : G4UImessenger(),
+      m_center(0, 0, 0),
+      m_radius(4*cm),
+      m_halfLength(4*cm)
+{
+    m_fileCmd = make_shared<G4UIcmdWithAString>("/PhaseSpace/file", this);
+    m_fileCmd->SetGuidance("Record the particles leaving the cylinder into this event file,");
+    m_fileCmd->SetGuidance("\"none\" disables the recording.");
+    m_fileCmd->SetParameterName("fileName", false);
+    m_fileCmd->SetToBeBroadcasted(false);
+
+    m_centerCmd = make_shared<G4UIcmdWith3VectorAndUnit>("/PhaseSpace/center", this);
+    m_centerCmd->SetGuidance("Center of the recording cylinder, which is parallel to the z axis.");
+    m_centerCmd->SetParameterName("x", "y", "z", false);
+    m_centerCmd->SetUnitCategory("Length");
+    m_centerCmd->SetToBeBroadcasted(false);
+
+    m_radiusCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/PhaseSpace/radius", this);
+    m_radiusCmd->SetGuidance("Radius of the recording cylinder.");
+    m_radiusCmd->SetParameterName("radius", false);
+    m_radiusCmd->SetUnitCategory("Length");
+    m_radiusCmd->SetRange("radius > 0");
+    m_radiusCmd->SetToBeBroadcasted(false);
+
+    m_halfLengthCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/PhaseSpace/halfLength", this);
+    m_halfLengthCmd->SetGuidance("Half length of the recording cylinder.");
+    m_halfLengthCmd->SetParameterName("halfLength", false);
+    m_halfLengthCmd->SetUnitCategory("Length");
+    m_halfLengthCmd->SetRange("halfLength > 0");
+    m_halfLengthCmd->SetToBeBroadcasted(false);
+
+    m_particlesCmd = make_shared<G4UIcmdWithAString>("/PhaseSpace/particles", this);
+    m_particlesCmd->SetGuidance("Record only gammas (default) or all particles, the others");
+    m_particlesCmd->SetGuidance("are killed at the surface all the same.");
+    m_particlesCmd->SetParameterName("particles", false);
+    m_particlesCmd->SetCandidates("gamma all");
+    m_particlesCmd->SetToBeBroadcasted(false);
+}
+
+PhaseSpaceRecorder::~PhaseSpaceRecorder()
+{}
+
+PhaseSpaceRecorder::Writer* PhaseSpaceRecorder::CreateWriter()
+{
+    G4AutoLock lock(&m_mutex);
+    m_writers.emplace_back(new Writer(this, m_writers.size()));
+    return m_writers.back().get();
+}
+
+void PhaseSpaceRecorder::BeginOfRun()
+{
+    G4AutoLock lock(&m_mutex);
+    for (auto& writer : m_writers)
+    {
+        writer->m_primaries = 0;
+        writer->m_eventPrimaries.clear();
+    }
+}
+
+void PhaseSpaceRecorder::EndOfRun()
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+
+    // the event loops of all threads are finished, their parts are complete
+    G4AutoLock lock(&m_mutex);
+    vector<uint64_t> firstPrimary(1, 0);
+    for (auto& writer : m_writers)
+    {
+        writer->Close();
+        for (const auto primaries : writer->m_eventPrimaries)
+        {
+            firstPrimary.push_back(firstPrimary.back() + primaries);
+        }
+    }
+    if (firstPrimary.size() == 1)
+    {
+        return;
+    }
+
+    FILE* output = std::fopen(m_fileName.c_str(), "wb");
+    if (!output)
+    {
+        throw runtime_error("PhaseSpaceRecorder: could not create " + m_fileName);
+    }
+
+    EventFileHeader header = {};
+    std::copy(EventFile::magic, EventFile::magic + sizeof(header.magic), header.magic);
+    header.version = EventFile::version;
+    header.primarySize = sizeof(EventFilePrimary);
+    header.nEvents = firstPrimary.size() - 1;
+    header.nPrimaries = firstPrimary.back();
+    std::fwrite(&header, sizeof(header), 1, output);
+    std::fwrite(firstPrimary.data(), sizeof(uint64_t), firstPrimary.size(), output);
+
+    vector<char> buffer(1 << 20);
+    for (auto& writer : m_writers)
+    {
+        if (writer->m_fileName.empty())
+        {
+            continue;
+        }
+        FILE* part = std::fopen(writer->m_fileName.c_str(), "rb");
+        if (!part)
+        {
+            std::fclose(output);
+            throw runtime_error("PhaseSpaceRecorder: could not read " + writer->m_fileName);
+        }
+        size_t size;
+        while ((size = std::fread(buffer.data(), 1, buffer.size(), part)) > 0)
+        {
+            std::fwrite(buffer.data(), 1, size, output);
+        }
+        std::fclose(part);
+        std::remove(writer->m_fileName.c_str());
+        writer->m_fileName = "";
+        writer->m_eventPrimaries.clear();
+    }
+
+    if (std::fclose(output) != 0)
+    {
+        throw runtime_error("PhaseSpaceRecorder: writing " + m_fileName + " failed");
+    }
+    G4cout << "PhaseSpace: " << header.nPrimaries << " particles of " << header.nEvents
+           << " events written to " << m_fileName << G4endl;
+}
+
+void PhaseSpaceRecorder::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_fileCmd.get())
+    {
+        m_fileName = (newValue == "none") ? "" : newValue;
+    }
+    else if (command == m_centerCmd.get())
+    {
+        m_center = m_centerCmd->GetNew3VectorValue(newValue);
+    }
+    else if (command == m_radiusCmd.get())
+    {
+        m_radius = m_radiusCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_halfLengthCmd.get())
+    {
+        m_halfLength = m_halfLengthCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_particlesCmd.get())
+    {
+        m_gammasOnly = (newValue == "gamma");
+    }
+    else
+    {
+        throw runtime_error("Unknown command in PhaseSpaceRecorder::SetNewValue()");
+    }
+}
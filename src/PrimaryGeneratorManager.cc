@@ -8,8 +8,14 @@
 #include "generator/GammaDecayScheme/GammaDecaySchemeGen.hh"
 #include "generator/PositronGun/PositronGunGen.hh"
 #include "generator/NuclideGun/NuclideGunGen.hh"
+#include "generator/EventFileGun/EventFileGunGen.hh"
+#include "generator/Composite/CompositeGen.hh"
+#include "generator/BackgroundGun/BackgroundGunGen.hh"
+
+#include "TwoTierRun.hh"
 
 #include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
 #include "G4UIcmdWithAString.hh"
 
 #include <stdexcept>
@@ -23,7 +29,7 @@ PrimaryGeneratorManager::PrimaryGeneratorManager()
     m_selectPGcmd = make_shared<G4UIcmdWithAString>("/PrimaryGenerator/select", this);
     m_selectPGcmd->SetGuidance("Choose primary generator.");
     m_selectPGcmd->SetParameterName("Primary generator name.", false);
-    m_selectPGcmd->SetCandidates("IsotropicGun GammaDecayScheme PositronGun NuclideGun PrimaryGun");
+    m_selectPGcmd->SetCandidates("IsotropicGun GammaDecayScheme PositronGun NuclideGun PrimaryGun EventFileGun Composite BackgroundGun");
 
     /// Initialize primary generators
     m_pgIsotropicGun     = make_shared<IsotropicGunGen>();
@@ -31,11 +37,17 @@ PrimaryGeneratorManager::PrimaryGeneratorManager()
     m_pgPositronGun = make_shared<PositronGunGen>();
     m_pgNuclideGun = make_shared<NuclideGunGen>();
     m_pgPrimaryGun = make_shared<PrimaryGunGen>();
+    m_pgEventFileGun = make_shared<EventFileGunGen>();
+    m_pgComposite = make_shared<CompositeGen>();
+    m_pgBackgroundGun = make_shared<BackgroundGunGen>();
 }
 
 
 void PrimaryGeneratorManager::GeneratePrimaries(G4Event* anEvent)
 {
+    // replay of a two-tier run: the engine starts where the screened event did
+    const G4double weight = TwoTierRun::BeginOfPrimaries(anEvent);
+
     switch (m_selectedPG)
     {
         case pgIsotropicGun:
@@ -58,6 +70,18 @@ void PrimaryGeneratorManager::GeneratePrimaries(G4Event* anEvent)
             m_pgPrimaryGun->GeneratePrimaries(anEvent);
             break;
 
+        case pgEventFileGun:
+            m_pgEventFileGun->GeneratePrimaries(anEvent);
+            break;
+
+        case pgComposite:
+            m_pgComposite->GeneratePrimaries(anEvent);
+            break;
+
+        case pgBackgroundGun:
+            m_pgBackgroundGun->GeneratePrimaries(anEvent);
+            break;
+
         case pgUndefined:
             throw runtime_error("No primary generator selected!");
             break;
@@ -66,6 +90,37 @@ void PrimaryGeneratorManager::GeneratePrimaries(G4Event* anEvent)
             throw runtime_error("Unhandled case in PrimaryGeneratorManager::GeneratePrimaries().");
             break;
     }
+
+    if (weight != 1)
+    {
+        for (G4int i = 0; i < anEvent->GetNumberOfPrimaryVertex(); i++)
+        {
+            G4PrimaryVertex* vertex = anEvent->GetPrimaryVertex(i);
+            vertex->SetWeight(weight*vertex->GetWeight());
+        }
+    }
+}
+
+void PrimaryGeneratorManager::GetGammaLines(vector<G4double>& lines) const
+{
+    lines.clear();
+    switch (m_selectedPG)
+    {
+        case pgIsotropicGun:
+            m_pgIsotropicGun->GetGammaLines(lines);
+            break;
+
+        case pgGammaDecayScheme:
+            m_pgGammaDecayScheme->GetGammaLines(lines);
+            break;
+
+        case pgComposite:
+            m_pgComposite->GetGammaLines(lines);
+            break;
+
+        default:
+            break;
+    }
 }
 
 void PrimaryGeneratorManager::SetNewValue(G4UIcommand* command, G4String newValue)
@@ -92,6 +147,18 @@ void PrimaryGeneratorManager::SetNewValue(G4UIcommand* command, G4String newValu
         {
             m_selectedPG = pgPrimaryGun;
         }
+        else if (newValue == "EventFileGun")
+        {
+            m_selectedPG = pgEventFileGun;
+        }
+        else if (newValue == "Composite")
+        {
+            m_selectedPG = pgComposite;
+        }
+        else if (newValue == "BackgroundGun")
+        {
+            m_selectedPG = pgBackgroundGun;
+        }
         else
         {
             G4cerr << "Unknown primary generator to be selected: " << newValue << G4endl;
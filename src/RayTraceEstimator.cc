@@ -0,0 +1,338 @@
+#include "RayTraceEstimator.hh"
+
+#include "DetectorConstruction.hh"
+#include "EmissionBias.hh"
+
+#include "G4EmCalculator.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Material.hh"
+#include "G4Navigator.hh"
+#include "G4RunManager.hh"
+#include "G4Timer.hh"
+#include "G4TransportationManager.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWith3VectorAndUnit.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+#include "G4SystemOfUnits.hh"
+using CLHEP::cm;
+using CLHEP::keV;
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include <memory>
+using std::make_shared;
+
+#include <stdexcept>
+using std::runtime_error;
+
+namespace
+{
+    // Bounding spheres of all placements of volume below mother, whose
+    // points p are at rotation*p + translation in the world
+    void FindPlacements(const G4LogicalVolume* mother, const G4LogicalVolume* volume,
+                        const G4RotationMatrix& rotation, const G4ThreeVector& translation,
+                        vector<pair<G4ThreeVector, G4double>>& spheres)
+    {
+        for (size_t i = 0; i < mother->GetNoDaughters(); i++)
+        {
+            const G4VPhysicalVolume* daughter = mother->GetDaughter(i);
+            if (daughter->IsReplicated())
+            {
+                continue;
+            }
+            const G4RotationMatrix daughterRotation = rotation*daughter->GetObjectRotationValue();
+            const G4ThreeVector daughterTranslation = rotation*daughter->GetObjectTranslation() + translation;
+
+            const G4LogicalVolume* logical = daughter->GetLogicalVolume();
+            if (logical == volume)
+            {
+                G4ThreeVector pMin, pMax;
+                logical->GetSolid()->BoundingLimits(pMin, pMax);
+                spheres.emplace_back(daughterRotation*(0.5*(pMin + pMax)) + daughterTranslation,
+                                     0.5*(pMax - pMin).mag());
+            }
+            else
+            {
+                FindPlacements(logical, volume, daughterRotation, daughterTranslation, spheres);
+            }
+        }
+    }
+
+    // a ray stops long before this many volumes
+    const G4int maxSteps = 100000;
+}
+
+RayTraceEstimator::RayTraceEstimator(DetectorConstruction* detectorConstruction)
+    : G4UImessenger(),
+      m_detectorConstruction(detectorConstruction),
+      m_energy(1000*keV),
+      m_xMin(-3*cm), m_xMax(3*cm), m_yMin(-3*cm), m_yMax(3*cm),
+      m_spacing(0.3*cm),
+      m_z(-2.1*cm)
+{
+    m_energyCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/RayTrace/energy", this);
+    m_energyCmd->SetGuidance("Energy of the gammas.");
+    m_energyCmd->SetParameterName("energy", false);
+    m_energyCmd->SetUnitCategory("Energy");
+    m_energyCmd->SetRange("energy > 0");
+    m_energyCmd->SetToBeBroadcasted(false);
+
+    m_directionsCmd = make_shared<G4UIcmdWithAString>("/RayTrace/directions", this);
+    m_directionsCmd->SetGuidance("Number of cells in cos(theta) and phi, one ray per cell (default 64 128).");
+    m_directionsCmd->SetParameterName("cells", false);
+    m_directionsCmd->SetToBeBroadcasted(false);
+
+    m_estimateCmd = make_shared<G4UIcmdWith3VectorAndUnit>("/RayTrace/estimate", this);
+    m_estimateCmd->SetGuidance("Print the estimated efficiency of a source at this position.");
+    m_estimateCmd->SetParameterName("x", "y", "z", false);
+    m_estimateCmd->SetUnitCategory("Length");
+    m_estimateCmd->SetToBeBroadcasted(false);
+
+    m_regionCmd = make_shared<G4UIcmdWithAString>("/RayTrace/region", this);
+    m_regionCmd->SetGuidance("Region of the map: xmin xmax ymin ymax unit (default -3 3 -3 3 cm).");
+    m_regionCmd->SetParameterName("region", false);
+    m_regionCmd->SetToBeBroadcasted(false);
+
+    m_spacingCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/RayTrace/spacing", this);
+    m_spacingCmd->SetGuidance("Distance of the points of the map (default 0.3 cm).");
+    m_spacingCmd->SetParameterName("spacing", false);
+    m_spacingCmd->SetUnitCategory("Length");
+    m_spacingCmd->SetRange("spacing > 0");
+    m_spacingCmd->SetToBeBroadcasted(false);
+
+    m_zCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/RayTrace/z", this);
+    m_zCmd->SetGuidance("z of the sources of the map (default -2.1 cm).");
+    m_zCmd->SetParameterName("z", false);
+    m_zCmd->SetUnitCategory("Length");
+    m_zCmd->SetToBeBroadcasted(false);
+
+    m_mapCmd = make_shared<G4UIcmdWithAString>("/RayTrace/map", this);
+    m_mapCmd->SetGuidance("Write the estimates over the region into a text file (x y efficiency, in cm).");
+    m_mapCmd->SetParameterName("fileName", false);
+    m_mapCmd->SetToBeBroadcasted(false);
+
+    m_biasCmd = make_shared<G4UIcmdWith3VectorAndUnit>("/RayTrace/bias", this);
+    m_biasCmd->SetGuidance("Bias the emission directions of the sources towards the detector,");
+    m_biasCmd->SetGuidance("with the importance of the rays from this position.");
+    m_biasCmd->SetParameterName("x", "y", "z", false);
+    m_biasCmd->SetUnitCategory("Length");
+    m_biasCmd->SetToBeBroadcasted(false);
+
+    m_mixtureCmd = make_shared<G4UIcmdWithADouble>("/RayTrace/mixture", this);
+    m_mixtureCmd->SetGuidance("Fraction of the emissions that stays isotropic when biased (default 0.1).");
+    m_mixtureCmd->SetParameterName("mixture", false);
+    m_mixtureCmd->SetRange("mixture > 0 && mixture <= 1");
+    m_mixtureCmd->SetToBeBroadcasted(false);
+
+    m_noBiasCmd = make_shared<G4UIcmdWithoutParameter>("/RayTrace/noBias", this);
+    m_noBiasCmd->SetGuidance("Emit isotropically again.");
+    m_noBiasCmd->SetToBeBroadcasted(false);
+}
+
+void RayTraceEstimator::Prepare()
+{
+    // an empty run builds (or rebuilds) the geometry and the physics tables
+    // and closes the geometry for navigation
+    G4RunManager::GetRunManager()->BeamOn(0);
+
+    G4EmCalculator calculator;
+    const G4MaterialTable* materials = G4Material::GetMaterialTable();
+    m_attenuation.assign(materials->size(), 0);
+    for (const G4Material* material : *materials)
+    {
+        const G4double length = calculator.ComputeGammaAttenuationLength(m_energy, material);
+        m_attenuation[material->GetIndex()] = (length > 0 && length < DBL_MAX) ? 1/length : 0;
+    }
+
+    const G4VPhysicalVolume* world = G4TransportationManager::GetTransportationManager()
+                                     ->GetNavigatorForTracking()->GetWorldVolume();
+    m_targets.clear();
+    FindPlacements(world->GetLogicalVolume(), m_detectorConstruction->GetScoringVolume(),
+                   G4RotationMatrix(), world->GetObjectTranslation(), m_targets);
+    if (m_targets.empty())
+    {
+        throw runtime_error("RayTraceEstimator: the active volume is not placed in the geometry");
+    }
+}
+
+G4double RayTraceEstimator::Estimate(const G4ThreeVector& position, vector<G4double>* rays)
+{
+    G4Navigator navigator;
+    navigator.SetWorldVolume(G4TransportationManager::GetTransportationManager()
+                             ->GetNavigatorForTracking()->GetWorldVolume());
+    const G4LogicalVolume* scoringVolume = m_detectorConstruction->GetScoringVolume();
+
+    const G4int nCells = m_nCosTheta*m_nPhi;
+    if (rays)
+    {
+        rays->assign(nCells, 0);
+    }
+
+    G4double sum = 0;
+    for (G4int cell = 0; cell < nCells; cell++)
+    {
+        const G4ThreeVector direction = EmissionBias::GetDirection(m_nCosTheta, m_nPhi, cell, 0.5, 0.5);
+
+        // distance after which the ray cannot reach the active volume any more
+        G4double reach = -1;
+        for (const auto& target : m_targets)
+        {
+            const G4ThreeVector toCenter = target.first - position;
+            const G4double along = toCenter.dot(direction);
+            const G4double radius2 = target.second*target.second;
+            if (toCenter.mag2() - along*along <= radius2 && (along > 0 || toCenter.mag2() <= radius2))
+            {
+                reach = std::max(reach, along + target.second);
+            }
+        }
+        if (reach < 0)
+        {
+            continue;
+        }
+
+        G4ThreeVector point = position;
+        G4double travelled = 0;
+        G4double transmission = 1;
+        G4double probability = 0;
+        G4VPhysicalVolume* volume = navigator.LocateGlobalPointAndSetup(point, &direction, false, false);
+        for (G4int step = 0; volume && step < maxSteps && travelled < reach; step++)
+        {
+            G4double safety = 0;
+            const G4double length = navigator.ComputeStep(point, direction, kInfinity, safety);
+            if (length >= kInfinity)
+            {
+                break;
+            }
+
+            const G4LogicalVolume* logical = volume->GetLogicalVolume();
+            const G4double survival = std::exp(-m_attenuation[logical->GetMaterial()->GetIndex()]*length);
+            if (logical == scoringVolume)
+            {
+                probability += transmission*(1 - survival);
+            }
+            transmission *= survival;
+
+            point += length*direction;
+            travelled += length;
+            navigator.SetGeometricallyLimitedStep();
+            volume = navigator.LocateGlobalPointAndSetup(point, &direction, true);
+        }
+
+        sum += probability;
+        if (rays)
+        {
+            (*rays)[cell] = probability;
+        }
+    }
+    return sum/nCells;
+}
+
+void RayTraceEstimator::WriteMap(const G4String& fileName)
+{
+    std::ofstream output(fileName);
+    if (!output)
+    {
+        throw runtime_error("RayTraceEstimator: could not create " + fileName);
+    }
+
+    G4Timer timer;
+    timer.Start();
+    const G4int nX = static_cast<G4int>(std::floor((m_xMax - m_xMin)/m_spacing + 0.5)) + 1;
+    const G4int nY = static_cast<G4int>(std::floor((m_yMax - m_yMin)/m_spacing + 0.5)) + 1;
+    for (G4int i = 0; i < nX; i++)
+    {
+        for (G4int j = 0; j < nY; j++)
+        {
+            const G4ThreeVector position(m_xMin + i*m_spacing, m_yMin + j*m_spacing, m_z);
+            output << position.x()/cm << " " << position.y()/cm << " " << Estimate(position) << "\n";
+        }
+    }
+    timer.Stop();
+
+    G4cout << "RayTraceEstimator: " << nX*nY << " points written to " << fileName
+           << " in " << timer.GetRealElapsed() << " s" << G4endl;
+}
+
+void RayTraceEstimator::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_energyCmd.get())
+    {
+        m_energy = m_energyCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_directionsCmd.get())
+    {
+        std::istringstream input(newValue);
+        G4int nCosTheta, nPhi;
+        if (!(input >> nCosTheta >> nPhi) || nCosTheta <= 0 || nPhi <= 0)
+        {
+            G4cerr << "Expected \"nCosTheta nPhi\", got '" << newValue << "'." << G4endl;
+            return;
+        }
+        m_nCosTheta = nCosTheta;
+        m_nPhi = nPhi;
+    }
+    else if (command == m_estimateCmd.get())
+    {
+        const G4ThreeVector position = m_estimateCmd->GetNew3VectorValue(newValue);
+        Prepare();
+        G4cout << "RayTraceEstimator: efficiency at " << position/cm << " cm: " << Estimate(position) << G4endl;
+    }
+    else if (command == m_regionCmd.get())
+    {
+        std::istringstream input(newValue);
+        G4double xMin, xMax, yMin, yMax;
+        G4String unit;
+        if (!(input >> xMin >> xMax >> yMin >> yMax >> unit) || xMin > xMax || yMin > yMax)
+        {
+            G4cerr << "Expected \"xmin xmax ymin ymax unit\", got '" << newValue << "'." << G4endl;
+            return;
+        }
+        const G4double scale = G4UIcommand::ValueOf(unit);
+        m_xMin = xMin*scale;
+        m_xMax = xMax*scale;
+        m_yMin = yMin*scale;
+        m_yMax = yMax*scale;
+    }
+    else if (command == m_spacingCmd.get())
+    {
+        m_spacing = m_spacingCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_zCmd.get())
+    {
+        m_z = m_zCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_mapCmd.get())
+    {
+        Prepare();
+        WriteMap(newValue);
+    }
+    else if (command == m_biasCmd.get())
+    {
+        const G4ThreeVector position = m_biasCmd->GetNew3VectorValue(newValue);
+        Prepare();
+        vector<G4double> rays;
+        const G4double efficiency = Estimate(position, &rays);
+        EmissionBias::SetCurrent(make_shared<EmissionBias>(m_nCosTheta, m_nPhi, rays, m_mixture));
+        G4cout << "RayTraceEstimator: emission biased towards the detector, estimated efficiency "
+               << efficiency << G4endl;
+    }
+    else if (command == m_mixtureCmd.get())
+    {
+        m_mixture = m_mixtureCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_noBiasCmd.get())
+    {
+        EmissionBias::SetCurrent(nullptr);
+    }
+    else
+    {
+        throw runtime_error("Unknown command in RayTraceEstimator::SetNewValue()");
+    }
+}
@@ -0,0 +1,310 @@
+#include "ResultCache.hh"
+
+#include "EnergyHistogram.hh"
+#include "G4HPGeVersion.hh"
+
+#include "G4RunManager.hh"
+#include "G4UImanager.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4Version.hh"
+#include "Randomize.hh"
+
+#include "TFile.h"
+#include "TH1D.h"
+#include "TKey.h"
+#include "TList.h"
+#include "TNamed.h"
+#include "TParameter.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <memory>
+using std::make_shared;
+
+#include <stdexcept>
+using std::runtime_error;
+
+namespace
+{
+    const uint64_t fnvOffset = 0xCBF29CE484222325ULL;
+
+    uint64_t Fnv1a(const char* data, size_t size, uint64_t hash)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 0x100000001B3ULL;
+        }
+        return hash;
+    }
+
+    // SplitMix64, used to spread the key over the seed space
+    uint64_t SplitMix64(uint64_t x)
+    {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    // Commands that cannot change the spectra
+    const char* const defaultIgnored[] = {
+        "/control/", "/vis/", "/gui/", "/Cache/", "/Output/", "/LiveExport/",
+        "/Shard/", "/Scan/", "/EfficiencyMap/",
+        "/run/beamOn", "/run/printProgress", "/run/verbose", "/event/verbose", "/tracking/verbose",
+        // the engine state is part of the key
+        "/random/"
+    };
+}
+
+ResultCache::ResultCache(EnergyHistogram* energyHistogram)
+    : G4UImessenger(),
+      m_energyHistogram(energyHistogram),
+      m_ignored(std::begin(defaultIgnored), std::end(defaultIgnored))
+{
+    // the key is made from the command history, which is otherwise cut at 20
+    G4UImanager::GetUIpointer()->SetMaxHistSize(std::numeric_limits<G4int>::max());
+
+    m_directoryCmd = make_shared<G4UIcmdWithAString>("/Cache/directory", this);
+    m_directoryCmd->SetGuidance("Directory of the cached results (default ./cache).");
+    m_directoryCmd->SetParameterName("directory", false);
+    m_directoryCmd->SetToBeBroadcasted(false);
+
+    m_ignoreCmd = make_shared<G4UIcmdWithAString>("/Cache/ignore", this);
+    m_ignoreCmd->SetGuidance("Leave the commands starting with this out of the key,");
+    m_ignoreCmd->SetGuidance("only for commands that cannot change the spectra.");
+    m_ignoreCmd->SetParameterName("prefix", false);
+    m_ignoreCmd->SetToBeBroadcasted(false);
+
+    m_beamOnCmd = make_shared<G4UIcmdWithAnInteger>("/Cache/beamOn", this);
+    m_beamOnCmd->SetGuidance("Fill the spectra with at least N events of the current configuration,");
+    m_beamOnCmd->SetGuidance("simulating only those that are not in the cache.");
+    m_beamOnCmd->SetParameterName("N", false);
+    m_beamOnCmd->SetRange("N >= 0");
+    m_beamOnCmd->SetToBeBroadcasted(false);
+}
+
+string ResultCache::GetState() const
+{
+    std::ostringstream state;
+    state.precision(17);
+    state << "version " << G4HPGE_VERSION << "\n";
+    state << "geant4 " << G4Version << "\n";
+    state << "histogram " << m_energyHistogram->GetNbins() << " " << m_energyHistogram->GetEmin()
+          << " " << m_energyHistogram->GetEmax() << "\n";
+
+    CLHEP::HepRandomEngine* engine = G4Random::getTheEngine();
+    state << "engine " << engine->name();
+    for (const unsigned long value : engine->put())
+    {
+        state << " " << value;
+    }
+    state << "\n";
+
+    std::map<string, uint64_t> files;
+    const G4UImanager* UImanager = G4UImanager::GetUIpointer();
+    for (G4int i = 0; i < UImanager->GetNumberOfHistory(); i++)
+    {
+        const string command = UImanager->GetPreviousCommand(i);
+        G4bool ignored = false;
+        for (const string& prefix : m_ignored)
+        {
+            ignored = ignored || command.compare(0, prefix.size(), prefix) == 0;
+        }
+        if (ignored)
+        {
+            continue;
+        }
+
+        std::istringstream tokens(command);
+        string token;
+        string separator = "";
+        while (tokens >> token)
+        {
+            state << separator << token;
+            separator = " ";
+
+            struct stat status;
+            if (files.count(token) == 0 && stat(token.c_str(), &status) == 0 && S_ISREG(status.st_mode))
+            {
+                std::ifstream file(token, std::ios::binary);
+                uint64_t hash = fnvOffset;
+                char buffer[65536];
+                while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+                {
+                    hash = Fnv1a(buffer, file.gcount(), hash);
+                }
+                files[token] = hash;
+            }
+        }
+        state << "\n";
+    }
+
+    for (const auto& file : files)
+    {
+        state << "file " << file.first << " " << std::hex << file.second << std::dec << "\n";
+    }
+    return state.str();
+}
+
+uint64_t ResultCache::Hash(const string& text)
+{
+    return SplitMix64(Fnv1a(text.data(), text.size(), fnvOffset));
+}
+
+void ResultCache::SeedEngine(const uint64_t key, const G4long events)
+{
+    const uint64_t x = SplitMix64(key + static_cast<uint64_t>(events));
+
+    // RanecuEngine accepts seeds in [1, 2^31-2]
+    long seeds[3];
+    seeds[0] = 1 + static_cast<long>((x & 0xFFFFFFFFULL) % 2147483646ULL);
+    seeds[1] = 1 + static_cast<long>((x >> 32) % 2147483646ULL);
+    seeds[2] = 0;
+    G4Random::setTheSeeds(seeds);
+}
+
+G4long ResultCache::Load(const string& fileName, const string& state, vector<unique_ptr<TH1D>>& histograms) const
+{
+    if (access(fileName.c_str(), R_OK) != 0)
+    {
+        return 0;
+    }
+
+    unique_ptr<TFile> file(TFile::Open(fileName.c_str(), "READ"));
+    if (!file || file->IsZombie())
+    {
+        G4cerr << "ResultCache: could not read " << fileName << ", it is simulated again." << G4endl;
+        return 0;
+    }
+
+    TNamed* stateObject = nullptr;
+    TParameter<Long64_t>* eventsObject = nullptr;
+    file->GetObject("state", stateObject);
+    file->GetObject("events", eventsObject);
+    unique_ptr<TNamed> storedState(stateObject);
+    unique_ptr<TParameter<Long64_t>> events(eventsObject);
+    // the state is compared as well, two states with the same hash are not mixed up
+    if (!storedState || !events || state != storedState->GetTitle())
+    {
+        G4cerr << "ResultCache: " << fileName << " belongs to another configuration, it is replaced." << G4endl;
+        return 0;
+    }
+
+    TIter next(file->GetListOfKeys());
+    while (TKey* key = static_cast<TKey*>(next()))
+    {
+        if (string(key->GetClassName()) == "TH1D")
+        {
+            TH1D* histogram = nullptr;
+            file->GetObject(key->GetName(), histogram);
+            if (histogram)
+            {
+                histogram->SetDirectory(nullptr);
+                histograms.emplace_back(histogram);
+            }
+        }
+    }
+    return events->GetVal();
+}
+
+void ResultCache::Store(const string& fileName, const string& state, const G4long events) const
+{
+    // written next to the entry and renamed, so that other processes never
+    // read a partial entry
+    std::ostringstream temporaryName;
+    temporaryName << fileName << ".tmp" << getpid();
+
+    vector<unique_ptr<TH1D>> histograms;
+    m_energyHistogram->CloneHistograms(histograms);
+
+    TFile file(temporaryName.str().c_str(), "RECREATE");
+    if (file.IsZombie())
+    {
+        G4cerr << "ResultCache: could not write " << temporaryName.str() << G4endl;
+        return;
+    }
+    for (auto& histogram : histograms)
+    {
+        histogram->Write();
+    }
+    TNamed("state", state.c_str()).Write();
+    TParameter<Long64_t>("events", events).Write();
+    file.Close();
+
+    if (std::rename(temporaryName.str().c_str(), fileName.c_str()) != 0)
+    {
+        G4cerr << "ResultCache: could not write " << fileName << G4endl;
+        std::remove(temporaryName.str().c_str());
+    }
+}
+
+void ResultCache::BeamOn(const G4int nEvents)
+{
+    if (mkdir(m_directory.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        throw runtime_error("ResultCache: could not create the directory " + m_directory);
+    }
+
+    const string state = GetState();
+    const uint64_t key = Hash(state);
+    std::ostringstream fileName;
+    fileName << m_directory << "/" << std::hex;
+    fileName.width(16);
+    fileName.fill('0');
+    fileName << key << ".root";
+
+    vector<unique_ptr<TH1D>> stored;
+    const G4long storedEvents = Load(fileName.str(), state, stored);
+
+    m_energyHistogram->Reset();
+    if (storedEvents >= nEvents)
+    {
+        G4cout << "ResultCache: " << storedEvents << " events from " << fileName.str() << G4endl;
+        m_energyHistogram->Add(stored);
+    }
+    else
+    {
+        G4cout << "ResultCache: " << storedEvents << " events from " << fileName.str()
+               << ", simulating " << nEvents - storedEvents << G4endl;
+        SeedEngine(key, storedEvents);
+        G4RunManager::GetRunManager()->BeamOn(nEvents - storedEvents);
+
+        // runs stopped early (/RunControl/precision) have fewer events
+        const G4long simulatedEvents = static_cast<G4long>(m_energyHistogram->GetHistogram()->GetEntries());
+        m_energyHistogram->Add(stored);
+        Store(fileName.str(), state, storedEvents + simulatedEvents);
+    }
+
+    // the same engine state for the next key, found or not
+    SeedEngine(key, -1);
+}
+
+void ResultCache::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_directoryCmd.get())
+    {
+        m_directory = newValue;
+    }
+    else if (command == m_ignoreCmd.get())
+    {
+        m_ignored.push_back(newValue);
+    }
+    else if (command == m_beamOnCmd.get())
+    {
+        BeamOn(m_beamOnCmd->GetNewIntValue(newValue));
+    }
+    else
+    {
+        throw runtime_error("Unknown command in ResultCache::SetNewValue()");
+    }
+}
@@ -0,0 +1,63 @@
+#include "RunAction.hh"
+
+#include "AsyncWriter.hh"
+#include "DecayChainLimits.hh"
+#include "LiveExport.hh"
+#include "PhaseSpaceRecorder.hh"
+#include "RunControl.hh"
+#include "ThreadPlacement.hh"
+#include "generator/BackgroundGun/BackgroundGunGen.hh"
+
+#include "G4Run.hh"
+
+RunAction::RunAction(RunControl* runControl, LiveExport* liveExport, DecayChainLimits* decayChainLimits,
+                     PhaseSpaceRecorder* phaseSpaceRecorder, AsyncWriter* asyncWriter)
+    : G4UserRunAction(),
+      m_runControl(runControl),
+      m_liveExport(liveExport),
+      m_decayChainLimits(decayChainLimits),
+      m_phaseSpaceRecorder(phaseSpaceRecorder),
+      m_asyncWriter(asyncWriter)
+{}
+
+
+RunAction::~RunAction()
+{}
+
+
+void RunAction::BeginOfRunAction(const G4Run* run)
+{
+    if (IsMaster())
+    {
+        m_runControl->BeginOfRun();
+        m_liveExport->BeginOfRun(run->GetRunID());
+        m_decayChainLimits->BeginOfRun();
+        m_phaseSpaceRecorder->BeginOfRun();
+        m_asyncWriter->BeginOfRun(run->GetRunID());
+        BackgroundGunGen::BeginOfRun();
+        ThreadPlacement::BeginOfRun();
+    }
+    else
+    {
+        ThreadPlacement::BeginOfWorkerRun();
+    }
+}
+
+
+void RunAction::EndOfRunAction(const G4Run* run)
+{
+    if (IsMaster())
+    {
+        m_runControl->EndOfRun();
+        m_liveExport->EndOfRun();
+        m_decayChainLimits->EndOfRun();
+        m_phaseSpaceRecorder->EndOfRun();
+        m_asyncWriter->EndOfRun();
+        BackgroundGunGen::EndOfRun();
+        ThreadPlacement::EndOfRun();
+    }
+    else
+    {
+        ThreadPlacement::EndOfWorkerRun(run->GetNumberOfEvent());
+    }
+}
@@ -0,0 +1,230 @@
+#include "RunControl.hh"
+
+#include "EnergyHistogram.hh"
+#include "PrimaryGeneratorManager.hh"
+
+#include "G4RunManager.hh"
+#ifdef G4MULTITHREADED
+#include "G4MTRunManager.hh"
+#endif
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+#include "G4SystemOfUnits.hh"
+using CLHEP::keV;
+using CLHEP::s;
+
+#include <algorithm>
+#include <cfloat>
+
+#include <memory>
+using std::make_shared;
+
+#include <stdexcept>
+using std::runtime_error;
+
+RunControl::RunControl(EnergyHistogram* energyHistogram)
+    : G4UImessenger(),
+      m_energyHistogram(energyHistogram),
+      m_peakHalfWidth(1.5*keV)
+{
+    m_precisionCmd = make_shared<G4UIcmdWithADouble>("/RunControl/precision", this);
+    m_precisionCmd->SetGuidance("Stop the run once the full-energy peaks of all lines are known to this");
+    m_precisionCmd->SetGuidance("relative statistical uncertainty (e.g. 0.01), 0 disables it.");
+    m_precisionCmd->SetParameterName("precision", false);
+    m_precisionCmd->SetRange("precision >= 0");
+    m_precisionCmd->SetToBeBroadcasted(false);
+
+    m_timeLimitCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/RunControl/timeLimit", this);
+    m_timeLimitCmd->SetGuidance("Stop the run after this wall time, 0 disables it.");
+    m_timeLimitCmd->SetParameterName("time", false);
+    m_timeLimitCmd->SetUnitCategory("Time");
+    m_timeLimitCmd->SetDefaultUnit("s");
+    m_timeLimitCmd->SetRange("time >= 0");
+    m_timeLimitCmd->SetToBeBroadcasted(false);
+
+    m_checkIntervalCmd = make_shared<G4UIcmdWithAnInteger>("/RunControl/checkInterval", this);
+    m_checkIntervalCmd->SetGuidance("Number of events (over all threads) between two checks.");
+    m_checkIntervalCmd->SetParameterName("events", false);
+    m_checkIntervalCmd->SetRange("events > 0");
+    m_checkIntervalCmd->SetToBeBroadcasted(false);
+
+    m_peakHalfWidthCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/RunControl/peakHalfWidth", this);
+    m_peakHalfWidthCmd->SetGuidance("Half width of the peak window, the side bands have the same width.");
+    m_peakHalfWidthCmd->SetParameterName("halfWidth", false);
+    m_peakHalfWidthCmd->SetUnitCategory("Energy");
+    m_peakHalfWidthCmd->SetRange("halfWidth > 0");
+    m_peakHalfWidthCmd->SetToBeBroadcasted(false);
+
+    m_addLineCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/RunControl/addLine", this);
+    m_addLineCmd->SetGuidance("Add a gamma line whose full-energy peak has to reach the precision.");
+    m_addLineCmd->SetGuidance("Without explicit lines the lines of the selected generator are used.");
+    m_addLineCmd->SetParameterName("energy", false);
+    m_addLineCmd->SetUnitCategory("Energy");
+    m_addLineCmd->SetToBeBroadcasted(false);
+
+    m_clearLinesCmd = make_shared<G4UIcmdWithoutParameter>("/RunControl/clearLines", this);
+    m_clearLinesCmd->SetGuidance("Remove the explicit lines, use those of the selected generator.");
+    m_clearLinesCmd->SetToBeBroadcasted(false);
+}
+
+void RunControl::BeginOfRun()
+{
+    m_events = 0;
+    m_stopped = false;
+    m_startTime = std::chrono::steady_clock::now();
+
+    G4AutoLock lock(&m_mutex);
+    m_stopReason = "";
+    m_lastPrecision = -1;
+}
+
+void RunControl::EndOfRun()
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+
+    G4AutoLock lock(&m_mutex);
+    G4cout << "RunControl: " << m_events.load() << " events";
+    if (m_stopped)
+    {
+        G4cout << ", stopped by the " << m_stopReason;
+    }
+    if (m_lastPrecision >= 0)
+    {
+        G4cout << ", relative uncertainty of the weakest peak " << m_lastPrecision;
+    }
+    G4cout << G4endl;
+}
+
+void RunControl::EndOfEvent()
+{
+    const G4int events = ++m_events;
+    if (!IsEnabled() || m_stopped || events % m_checkInterval != 0)
+    {
+        return;
+    }
+
+    if (m_timeLimit > 0)
+    {
+        const std::chrono::duration<G4double> elapsed = std::chrono::steady_clock::now() - m_startTime;
+        if (elapsed.count()*s >= m_timeLimit)
+        {
+            Stop("time limit");
+            return;
+        }
+    }
+
+    if (m_precision > 0)
+    {
+        vector<G4double> lines;
+        GetLines(lines);
+        if (lines.empty())
+        {
+            return;
+        }
+
+        const G4double precision = EstimatePrecision(lines);
+        {
+            G4AutoLock lock(&m_mutex);
+            m_lastPrecision = precision;
+        }
+        if (precision <= m_precision)
+        {
+            Stop("precision target");
+        }
+    }
+}
+
+void RunControl::GetLines(vector<G4double>& lines) const
+{
+    if (!m_lines.empty())
+    {
+        lines = m_lines;
+        return;
+    }
+
+    auto generator = static_cast<const PrimaryGeneratorManager*>
+                     (G4RunManager::GetRunManager()->GetUserPrimaryGeneratorAction());
+    if (generator)
+    {
+        generator->GetGammaLines(lines);
+    }
+}
+
+G4double RunControl::EstimatePrecision(const vector<G4double>& lines) const
+{
+    G4double worst = 0;
+    for (const auto line : lines)
+    {
+        G4double net, sigma;
+        m_energyHistogram->GetPeak(line, m_peakHalfWidth, net, sigma);
+        if (net <= 0)
+        {
+            return DBL_MAX;
+        }
+        worst = std::max(worst, sigma/net);
+    }
+    return worst;
+}
+
+void RunControl::Stop(const G4String& reason)
+{
+    if (m_stopped.exchange(true))
+    {
+        return;
+    }
+
+    {
+        G4AutoLock lock(&m_mutex);
+        m_stopReason = reason;
+    }
+    G4cout << "RunControl: " << reason << " reached after " << m_events.load() << " events, stopping the run." << G4endl;
+
+    // in multithreaded mode the master aborts all workers
+#ifdef G4MULTITHREADED
+    auto masterRunManager = G4MTRunManager::GetMasterRunManager();
+    if (masterRunManager)
+    {
+        masterRunManager->AbortRun(true);
+        return;
+    }
+#endif
+    G4RunManager::GetRunManager()->AbortRun(true);
+}
+
+void RunControl::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_precisionCmd.get())
+    {
+        m_precision = m_precisionCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_timeLimitCmd.get())
+    {
+        m_timeLimit = m_timeLimitCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_checkIntervalCmd.get())
+    {
+        m_checkInterval = m_checkIntervalCmd->GetNewIntValue(newValue);
+    }
+    else if (command == m_peakHalfWidthCmd.get())
+    {
+        m_peakHalfWidth = m_peakHalfWidthCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_addLineCmd.get())
+    {
+        m_lines.push_back(m_addLineCmd->GetNewDoubleValue(newValue));
+    }
+    else if (command == m_clearLinesCmd.get())
+    {
+        m_lines.clear();
+    }
+    else
+    {
+        throw runtime_error("Unknown command in RunControl::SetNewValue()");
+    }
+}
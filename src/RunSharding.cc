@@ -0,0 +1,143 @@
+#include "RunSharding.hh"
+
+#include "G4RunManager.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "Randomize.hh"
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include <sstream>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <memory>
+using std::make_shared;
+
+#include <stdexcept>
+using std::runtime_error;
+
+namespace
+{
+    // SplitMix64, used to spread (base seed, shard index) over the seed space
+    uint64_t SplitMix64(uint64_t x)
+    {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+}
+
+G4int RunSharding::s_nShards = 1;
+G4int RunSharding::s_shardIndex = 0;
+
+RunSharding::RunSharding(G4int nShards, G4int shardIndex, G4long baseSeed)
+    : G4UImessenger(),
+      m_nShards(nShards),
+      m_shardIndex(shardIndex),
+      m_baseSeed(baseSeed)
+{
+    s_nShards = nShards;
+    s_shardIndex = shardIndex;
+
+    m_beamOnCmd = make_shared<G4UIcmdWithAnInteger>("/Shard/beamOn", this);
+    m_beamOnCmd->SetGuidance("Start a run with the share of this shard of the given total number of events.");
+    m_beamOnCmd->SetParameterName("N", false);
+    m_beamOnCmd->SetRange("N >= 0");
+    m_beamOnCmd->SetToBeBroadcasted(false);
+}
+
+G4int RunSharding::Launch(G4int nShards)
+{
+    std::vector<pid_t> children;
+
+    for (G4int i = 0; i < nShards; i++)
+    {
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            throw runtime_error("RunSharding::Launch(): fork() failed.");
+        }
+        if (pid == 0)
+        {
+            std::ostringstream logName;
+            logName << "shard_" << i << ".log";
+            if (!freopen(logName.str().c_str(), "w", stdout) || !freopen(logName.str().c_str(), "a", stderr))
+            {
+                exit(99);
+            }
+            // one worker thread per shard, the shards themselves provide the parallelism
+            setenv("G4FORCENUMBEROFTHREADS", "1", 0);
+            return i;
+        }
+        children.push_back(pid);
+    }
+
+    G4int failed = 0;
+    for (size_t i = 0; i < children.size(); i++)
+    {
+        int status = 0;
+        waitpid(children[i], &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            G4cerr << "Shard " << i << " failed, see shard_" << i << ".log" << G4endl;
+            failed++;
+        }
+    }
+
+    G4cout << nShards - failed << " of " << nShards << " shards finished." << G4endl;
+    G4cout << "Merge the outputs with: G4_HPGe_merge sim.root sim_*.root" << G4endl;
+
+    exit(failed == 0 ? 0 : 1);
+}
+
+void RunSharding::SeedEngine() const
+{
+    const uint64_t x = SplitMix64(SplitMix64(static_cast<uint64_t>(m_baseSeed)) + static_cast<uint64_t>(m_shardIndex));
+
+    // RanecuEngine accepts seeds in [1, 2^31-2]
+    long seeds[3];
+    seeds[0] = 1 + static_cast<long>((x & 0xFFFFFFFFULL) % 2147483646ULL);
+    seeds[1] = 1 + static_cast<long>((x >> 32) % 2147483646ULL);
+    seeds[2] = 0;
+
+    G4Random::setTheSeeds(seeds);
+
+    G4cout << "Shard " << m_shardIndex << " of " << m_nShards
+           << " seeded with " << seeds[0] << " " << seeds[1] << G4endl;
+}
+
+G4String RunSharding::GetOutputFileName() const
+{
+    std::ostringstream fileName;
+    fileName << "./sim_" << m_shardIndex << ".root";
+    return fileName.str();
+}
+
+G4int RunSharding::GetShardEvents(G4int nEvents) const
+{
+    G4int events = nEvents / m_nShards;
+    if (m_shardIndex < nEvents % m_nShards)
+    {
+        events++;
+    }
+    return events;
+}
+
+void RunSharding::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_beamOnCmd.get())
+    {
+        const G4int events = GetShardEvents(m_beamOnCmd->GetNewIntValue(newValue));
+        G4cout << "Shard " << m_shardIndex << " processes " << events << " events." << G4endl;
+        G4RunManager::GetRunManager()->BeamOn(events);
+    }
+    else
+    {
+        throw runtime_error("Unknown command in RunSharding::SetNewValue()");
+    }
+}
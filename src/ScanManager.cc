@@ -0,0 +1,467 @@
+#include "ScanManager.hh"
+
+#include "DetectorConstruction.hh"
+#include "GeometryObject.hh"
+#include "EnergyHistogram.hh"
+
+#include "G4RunManager.hh"
+#include "G4UIcommand.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4ThreeVector.hh"
+#include "G4RotationMatrix.hh"
+#include "G4Timer.hh"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TROOT.h"
+
+#include "G4SystemOfUnits.hh"
+using CLHEP::mm;
+using CLHEP::deg;
+
+#include <cmath>
+#include <map>
+#include <sstream>
+
+#include <memory>
+using std::make_shared;
+
+#include <stdexcept>
+using std::runtime_error;
+
+ScanManager::ScanManager(DetectorConstruction* detectorConstruction, EnergyHistogram* energyHistogram)
+    : G4UImessenger(),
+      m_detectorConstruction(detectorConstruction),
+      m_energyHistogram(energyHistogram)
+{
+    m_addDimensionCmd = make_shared<G4UIcmdWithAString>("/Scan/addDimension", this);
+    m_addDimensionCmd->SetGuidance("Add a scan axis: object dimension from to step unit");
+    m_addDimensionCmd->SetGuidance("e.g. \"/Scan/addDimension HPGeDetector detectorHoleDepth 70 80 2 mm\".");
+    m_addDimensionCmd->SetParameterName("axis", false);
+    m_addDimensionCmd->SetToBeBroadcasted(false);
+
+    m_addPositionCmd = make_shared<G4UIcmdWithAString>("/Scan/addPosition", this);
+    m_addPositionCmd->SetGuidance("Add a scan axis for one position coordinate: object x|y|z from to step unit");
+    m_addPositionCmd->SetGuidance("e.g. \"/Scan/addPosition HPGeDetector z 0 100 10 mm\".");
+    m_addPositionCmd->SetParameterName("axis", false);
+    m_addPositionCmd->SetToBeBroadcasted(false);
+
+    m_addRotationCmd = make_shared<G4UIcmdWithAString>("/Scan/addRotation", this);
+    m_addRotationCmd->SetGuidance("Add a scan axis rotating the object: object x|y|z from to step unit");
+    m_addRotationCmd->SetGuidance("The rotation is applied on top of the rotation set before the scan,");
+    m_addRotationCmd->SetGuidance("e.g. \"/Scan/addRotation HPGeDetector y 0 30 10 deg\".");
+    m_addRotationCmd->SetParameterName("axis", false);
+    m_addRotationCmd->SetToBeBroadcasted(false);
+
+    m_addDetailCmd = make_shared<G4UIcmdWithAString>("/Scan/addDetail", this);
+    m_addDetailCmd->SetGuidance("Add a scan axis over levels of detail: object level [level ...]");
+    m_addDetailCmd->SetGuidance("e.g. \"/Scan/addDetail TargetHolderC12 full simplified homogenized\".");
+    m_addDetailCmd->SetParameterName("axis", false);
+    m_addDetailCmd->SetToBeBroadcasted(false);
+
+    m_checkOverlapsCmd = make_shared<G4UIcmdWithABool>("/Scan/checkOverlaps", this);
+    m_checkOverlapsCmd->SetGuidance("Check the moved volumes for overlaps and skip the points where they overlap");
+    m_checkOverlapsCmd->SetGuidance("(on by default).");
+    m_checkOverlapsCmd->SetParameterName("check", true);
+    m_checkOverlapsCmd->SetDefaultValue(true);
+    m_checkOverlapsCmd->SetToBeBroadcasted(false);
+
+    m_clearCmd = make_shared<G4UIcmdWithoutParameter>("/Scan/clear", this);
+    m_clearCmd->SetGuidance("Remove all scan axes.");
+    m_clearCmd->SetToBeBroadcasted(false);
+
+    m_fileNameCmd = make_shared<G4UIcmdWithAString>("/Scan/fileName", this);
+    m_fileNameCmd->SetGuidance("Output file of the scan.");
+    m_fileNameCmd->SetParameterName("fileName", false);
+    m_fileNameCmd->SetToBeBroadcasted(false);
+
+    m_runCmd = make_shared<G4UIcmdWithAnInteger>("/Scan/run", this);
+    m_runCmd->SetGuidance("Run the scan with the given number of events per point.");
+    m_runCmd->SetParameterName("eventsPerPoint", false);
+    m_runCmd->SetRange("eventsPerPoint > 0");
+    m_runCmd->SetToBeBroadcasted(false);
+}
+
+G4bool ScanManager::ParseAxis(const G4String& parameters, Axis& axis)
+{
+    std::istringstream input(parameters);
+    G4String objectName, dimension, unit;
+    G4double from, to, step;
+    if (!(input >> objectName >> dimension >> from >> to >> step >> unit))
+    {
+        G4cerr << "Expected \"object name from to step unit\", got '" << parameters << "'." << G4endl;
+        return false;
+    }
+
+    axis.object = m_detectorConstruction->GetGeometryObject(objectName);
+    if (!axis.object)
+    {
+        G4cerr << "Unknown geometry object '" << objectName << "'." << G4endl;
+        return false;
+    }
+    axis.dimension = dimension;
+
+    if (step <= 0 || to < from)
+    {
+        G4cerr << "Scan axis needs from <= to and a positive step." << G4endl;
+        return false;
+    }
+
+    const G4double unitValue = G4UIcommand::ValueOf(unit);
+    const G4int nValues = static_cast<G4int>(std::floor((to - from)/step + 1e-9)) + 1;
+    axis.values.clear();
+    for (G4int i = 0; i < nValues; i++)
+    {
+        axis.values.push_back((from + i*step)*unitValue);
+    }
+
+    return true;
+}
+
+void ScanManager::AddDimension(const G4String& parameters)
+{
+    Axis axis;
+    axis.type = Axis::axisDimension;
+    axis.component = 0;
+    if (!ParseAxis(parameters, axis))
+    {
+        return;
+    }
+
+    // throws for unknown dimensions
+    axis.object->GetDimension(axis.dimension);
+
+    m_axes.push_back(axis);
+    G4cout << "Scan axis " << GetAxisName(axis) << " with " << axis.values.size() << " points." << G4endl;
+}
+
+void ScanManager::AddPlacement(const G4String& parameters, G4bool rotation)
+{
+    Axis axis;
+    axis.type = rotation ? Axis::axisRotation : Axis::axisPosition;
+    if (!ParseAxis(parameters, axis))
+    {
+        return;
+    }
+
+    if (axis.dimension == "x")
+    {
+        axis.component = 0;
+    }
+    else if (axis.dimension == "y")
+    {
+        axis.component = 1;
+    }
+    else if (axis.dimension == "z")
+    {
+        axis.component = 2;
+    }
+    else
+    {
+        G4cerr << "Unknown axis '" << axis.dimension << "', use x, y or z." << G4endl;
+        return;
+    }
+
+    m_axes.push_back(axis);
+    G4cout << "Scan axis " << GetAxisName(axis) << " with " << axis.values.size() << " points." << G4endl;
+}
+
+void ScanManager::AddDetail(const G4String& parameters)
+{
+    std::istringstream input(parameters);
+    G4String objectName, level;
+    input >> objectName;
+
+    Axis axis;
+    axis.type = Axis::axisDetail;
+    axis.dimension = "detail";
+    axis.component = 0;
+    axis.object = m_detectorConstruction->GetGeometryObject(objectName);
+    if (!axis.object)
+    {
+        G4cerr << "Unknown geometry object '" << objectName << "'." << G4endl;
+        return;
+    }
+    if (!axis.object->HasDetail())
+    {
+        G4cerr << objectName << " can only be built in full detail." << G4endl;
+        return;
+    }
+
+    while (input >> level)
+    {
+        GeometryObject::Detail detail;
+        if (!GeometryObject::GetDetailFromName(level, detail))
+        {
+            G4cerr << "Unknown level of detail '" << level << "', use full, simplified or homogenized." << G4endl;
+            return;
+        }
+        axis.values.push_back(detail);
+    }
+    if (axis.values.empty())
+    {
+        G4cerr << "Expected \"object level [level ...]\", got '" << parameters << "'." << G4endl;
+        return;
+    }
+
+    m_axes.push_back(axis);
+    G4cout << "Scan axis " << GetAxisName(axis) << " with " << axis.values.size() << " points." << G4endl;
+}
+
+G4String ScanManager::GetAxisName(const Axis& axis) const
+{
+    switch (axis.type)
+    {
+        case Axis::axisPosition:
+            return axis.object->GetName() + "_position_" + axis.dimension;
+        case Axis::axisRotation:
+            return axis.object->GetName() + "_rotation_" + axis.dimension;
+        default:
+            return axis.object->GetName() + "_" + axis.dimension;
+    }
+}
+
+void ScanManager::Run(G4int eventsPerPoint)
+{
+    if (m_axes.empty())
+    {
+        G4cerr << "No scan axes defined, use /Scan/addDimension, /Scan/addPosition, /Scan/addRotation or /Scan/addDetail." << G4endl;
+        return;
+    }
+
+    G4int nPoints = 1;
+    for (const auto& axis : m_axes)
+    {
+        nPoints *= axis.values.size();
+    }
+
+    auto runManager = G4RunManager::GetRunManager();
+
+    TFile* file = TFile::Open(m_fileName.c_str(), "RECREATE");
+    if (!file || file->IsZombie())
+    {
+        throw runtime_error("ScanManager::Run(): could not create " + m_fileName);
+    }
+
+    G4int point = 0;
+    G4int events = eventsPerPoint;
+    G4double runTime = 0;
+    vector<G4double> values(m_axes.size());
+
+    auto scanTree = new TTree("scan", "scan");
+    scanTree->Branch("Point", &point, "Point/I");
+    scanTree->Branch("Events", &events, "Events/I");
+    scanTree->Branch("Time", &runTime, "Time/D");
+    for (size_t i = 0; i < m_axes.size(); i++)
+    {
+        const G4String name = GetAxisName(m_axes[i]);
+        scanTree->Branch(name.c_str(), &values[i], (name + "/D").c_str());
+    }
+
+    // histograms filled during the runs must not end up in the scan file
+    gROOT->cd();
+
+    // the placements before the scan, the placement axes start from them
+    std::map<GeometryObject*, std::pair<G4ThreeVector, G4RotationMatrix>> originalPlacements;
+    vector<G4double> originalDimensions(m_axes.size());
+    for (size_t i = 0; i < m_axes.size(); i++)
+    {
+        auto object = m_axes[i].object;
+        if (m_axes[i].type == Axis::axisDimension)
+        {
+            originalDimensions[i] = object->GetDimension(m_axes[i].dimension);
+        }
+        else if (m_axes[i].type == Axis::axisDetail)
+        {
+            originalDimensions[i] = object->GetDetail();
+        }
+        else
+        {
+            originalPlacements[object] = std::make_pair(object->GetPosition(), *object->GetRotation());
+        }
+    }
+
+    G4Timer timer;
+    G4Timer runTimer;
+    G4int skippedPoints = 0;
+
+    for (point = 0; point < nPoints; point++)
+    {
+        timer.Start();
+        auto placements = originalPlacements;
+        G4bool rebuild = false;
+
+        G4int index = point;
+        for (size_t i = m_axes.size(); i-- > 0; )
+        {
+            const auto& axis = m_axes[i];
+            const G4double value = axis.values[index % axis.values.size()];
+            index /= axis.values.size();
+
+            switch (axis.type)
+            {
+                case Axis::axisDimension:
+                    if (axis.object->GetDimension(axis.dimension) != value)
+                    {
+                        axis.object->SetDimension(axis.dimension, value);
+                        rebuild = true;
+                    }
+                    values[i] = value/mm;
+                    break;
+                case Axis::axisDetail:
+                {
+                    const auto detail = static_cast<GeometryObject::Detail>(value);
+                    if (axis.object->GetDetail() != detail)
+                    {
+                        axis.object->SetDetail(detail);
+                        rebuild = true;
+                    }
+                    values[i] = value;
+                    break;
+                }
+                case Axis::axisPosition:
+                    placements[axis.object].first[axis.component] = value;
+                    values[i] = value/mm;
+                    break;
+                case Axis::axisRotation:
+                {
+                    G4RotationMatrix rotation;
+                    rotation.rotate(value, G4ThreeVector(axis.component == 0, axis.component == 1, axis.component == 2));
+                    placements[axis.object].second = rotation*placements[axis.object].second;
+                    values[i] = value/deg;
+                    break;
+                }
+            }
+        }
+
+        // a rebuild checks the overlaps when the volumes are placed
+        G4bool overlaps = false;
+        for (const auto& placement : placements)
+        {
+            placement.first->SetPlacement(placement.second.first, placement.second.second);
+            if (!placement.first->UpdatePlacement(m_checkOverlaps && !rebuild))
+            {
+                overlaps = true;
+            }
+        }
+        if (overlaps)
+        {
+            G4cerr << "Scan point " << point + 1 << " of " << nPoints << " is skipped, the moved volumes overlap." << G4endl;
+            skippedPoints++;
+            events = 0;
+            runTime = 0;
+            scanTree->Fill();
+            continue;
+        }
+
+        if (rebuild)
+        {
+            // the modified objects are rebuilt (at their new placement) when the run starts
+            runManager->ReinitializeGeometry();
+            runManager->GeometryHasBeenModified();
+            G4cout << "Scan point " << point + 1 << " of " << nPoints << ", geometry is rebuilt" << G4endl;
+        }
+        else
+        {
+            timer.Stop();
+            G4cout << "Scan point " << point + 1 << " of " << nPoints << ", geometry moved in "
+                   << timer.GetRealElapsed()*1000 << " ms" << G4endl;
+        }
+
+        m_energyHistogram->Reset();
+        runTimer.Start();
+        runManager->BeamOn(eventsPerPoint);
+        runTimer.Stop();
+        runTime = runTimer.GetRealElapsed();
+
+        // the run control may have stopped the run early
+        events = m_energyHistogram->GetHistogram()->GetEntries();
+
+        std::ostringstream histogramName;
+        histogramName << "h1_" << point;
+        file->WriteTObject(m_energyHistogram->GetHistogram(), histogramName.str().c_str());
+        if (m_energyHistogram->GetWeightedHistogram())
+        {
+            std::ostringstream weightedName;
+            weightedName << "h1w_" << point;
+            file->WriteTObject(m_energyHistogram->GetWeightedHistogram(), weightedName.str().c_str());
+        }
+        scanTree->Fill();
+    }
+
+    // leave the geometry as it was before the scan
+    for (size_t i = 0; i < m_axes.size(); i++)
+    {
+        if (m_axes[i].type == Axis::axisDimension)
+        {
+            m_axes[i].object->SetDimension(m_axes[i].dimension, originalDimensions[i]);
+        }
+        else if (m_axes[i].type == Axis::axisDetail)
+        {
+            m_axes[i].object->SetDetail(static_cast<GeometryObject::Detail>(originalDimensions[i]));
+        }
+    }
+    for (const auto& placement : originalPlacements)
+    {
+        placement.first->SetPlacement(placement.second.first, placement.second.second);
+        placement.first->UpdatePlacement();
+    }
+    runManager->ReinitializeGeometry();
+    runManager->GeometryHasBeenModified();
+
+    if (skippedPoints > 0)
+    {
+        G4cerr << skippedPoints << " of " << nPoints << " scan points were skipped because of overlaps." << G4endl;
+    }
+
+    file->cd();
+    scanTree->Write();
+    file->Close();
+    delete file;
+    gROOT->cd();
+
+    G4cout << "Scan of " << nPoints << " points written to " << m_fileName << G4endl;
+}
+
+void ScanManager::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_addDimensionCmd.get())
+    {
+        AddDimension(newValue);
+    }
+    else if (command == m_addPositionCmd.get())
+    {
+        AddPlacement(newValue, false);
+    }
+    else if (command == m_addRotationCmd.get())
+    {
+        AddPlacement(newValue, true);
+    }
+    else if (command == m_addDetailCmd.get())
+    {
+        AddDetail(newValue);
+    }
+    else if (command == m_checkOverlapsCmd.get())
+    {
+        m_checkOverlaps = m_checkOverlapsCmd->GetNewBoolValue(newValue);
+    }
+    else if (command == m_clearCmd.get())
+    {
+        m_axes.clear();
+    }
+    else if (command == m_fileNameCmd.get())
+    {
+        m_fileName = newValue;
+    }
+    else if (command == m_runCmd.get())
+    {
+        Run(m_runCmd->GetNewIntValue(newValue));
+    }
+    else
+    {
+        throw runtime_error("Unknown command in ScanManager::SetNewValue()");
+    }
+}
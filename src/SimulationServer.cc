@@ -0,0 +1,219 @@
+#include "SimulationServer.hh"
+
+#include "EnergyHistogram.hh"
+
+#include "G4UImanager.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <stdexcept>
+using std::runtime_error;
+
+namespace
+{
+    // jobs are macro fragments, anything larger is not meant for the server
+    const size_t maxJobSize = 1 << 20;
+}
+
+SimulationServer::SimulationServer(EnergyHistogram* energyHistogram)
+    : m_energyHistogram(energyHistogram)
+{}
+
+SimulationServer::~SimulationServer()
+{
+    if (m_socket >= 0)
+    {
+        close(m_socket);
+        unlink(m_socketName.c_str());
+    }
+}
+
+void SimulationServer::Serve(const G4String& socketName)
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketName.size() >= sizeof(address.sun_path))
+    {
+        throw runtime_error("SimulationServer: the socket name " + socketName + " is too long");
+    }
+    std::strcpy(address.sun_path, socketName.c_str());
+
+    m_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_socket < 0)
+    {
+        throw runtime_error("SimulationServer: could not create a socket");
+    }
+    m_socketName = socketName;
+
+    // a socket left behind by a previous server
+    unlink(socketName.c_str());
+    const mode_t mask = umask(0077);
+    const int bound = bind(m_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    umask(mask);
+    if (bound != 0 || listen(m_socket, SOMAXCONN) != 0)
+    {
+        throw runtime_error("SimulationServer: could not listen on " + socketName + ": " + std::strerror(errno));
+    }
+
+    G4cout << "SimulationServer: waiting for jobs on " << socketName << G4endl;
+    G4bool serving = true;
+    while (serving)
+    {
+        const int connection = accept(m_socket, nullptr, nullptr);
+        if (connection < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw runtime_error(string("SimulationServer: accept failed: ") + std::strerror(errno));
+        }
+        serving = HandleJob(connection);
+        close(connection);
+    }
+    G4cout << "SimulationServer: shut down" << G4endl;
+}
+
+G4bool SimulationServer::HandleJob(const int connection)
+{
+    // the whole job first, it ends with EOF or a line "end"
+    string job;
+    char buffer[4096];
+    while (job.size() < maxJobSize)
+    {
+        const ssize_t size = read(connection, buffer, sizeof(buffer));
+        if (size < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (size <= 0)
+        {
+            break;
+        }
+        job.append(buffer, size);
+        if (job.find("\nend\n") != string::npos || job.compare(0, 4, "end\n") == 0)
+        {
+            break;
+        }
+    }
+    if (job.size() >= maxJobSize)
+    {
+        SendLine(connection, "error -1 the job is larger than 1 MB");
+        return true;
+    }
+
+    G4bool shutdown = false;
+    std::istringstream lines(job);
+    string line;
+    while (std::getline(lines, line))
+    {
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#')
+        {
+            continue;
+        }
+        line = line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+        if (line == "end")
+        {
+            break;
+        }
+        if (line == "shutdown")
+        {
+            shutdown = true;
+            continue;
+        }
+
+        const G4bool beamOn = (line.compare(0, 11, "/run/beamOn") == 0);
+        if (beamOn)
+        {
+            m_energyHistogram->Reset();
+        }
+
+        G4int status = 0;
+        try
+        {
+            status = G4UImanager::GetUIpointer()->ApplyCommand(line);
+        }
+        catch (const std::exception& error)
+        {
+            SendLine(connection, string("error -1 ") + line + ": " + error.what());
+            return !shutdown;
+        }
+        if (status != 0)
+        {
+            std::ostringstream message;
+            message << "error " << status << " " << line;
+            SendLine(connection, message.str());
+            return !shutdown;
+        }
+
+        if (beamOn)
+        {
+            G4bool sent = SendSpectrum(connection, "h1", m_energyHistogram->GetHistogram());
+            if (sent && m_energyHistogram->GetWeightedHistogram())
+            {
+                sent = SendSpectrum(connection, "h1w", m_energyHistogram->GetWeightedHistogram());
+            }
+            vector<string> components;
+            m_energyHistogram->GetComponentNames(components);
+            for (size_t i = 0; sent && i < components.size(); i++)
+            {
+                sent = SendSpectrum(connection, "h1_" + components[i],
+                                    m_energyHistogram->GetComponentHistogram(components[i]));
+            }
+            if (!sent)
+            {
+                G4cerr << "SimulationServer: the client went away, the rest of its job is skipped." << G4endl;
+                return !shutdown;
+            }
+        }
+    }
+
+    SendLine(connection, "done");
+    return !shutdown;
+}
+
+G4bool SimulationServer::SendLine(const int connection, const string& line)
+{
+    const string text = line + "\n";
+    return Send(connection, text.data(), text.size());
+}
+
+G4bool SimulationServer::SendSpectrum(const int connection, const string& name, const TH1D* histogram)
+{
+    const int nBins = m_energyHistogram->GetNbins();
+    std::ostringstream header;
+    header.precision(17);
+    header << "spectrum " << name << " " << nBins << " " << m_energyHistogram->GetEmin() << " "
+           << m_energyHistogram->GetEmax() << " " << histogram->GetEntries();
+    return SendLine(connection, header.str())
+        && Send(connection, histogram->GetArray(), (nBins + 2)*sizeof(double));
+}
+
+G4bool SimulationServer::Send(const int connection, const void* data, size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        const ssize_t sent = send(connection, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (sent <= 0)
+        {
+            return false;
+        }
+        bytes += sent;
+        size -= sent;
+    }
+    return true;
+}
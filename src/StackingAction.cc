@@ -0,0 +1,124 @@
+#include "StackingAction.hh"
+
+#include "DecayChainLimits.hh"
+
+#include "G4EventManager.hh"
+#include "G4TrackingManager.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4HadronicProcessType.hh"
+
+#include <algorithm>
+
+
+StackingAction::StackingAction(DecayChainLimits* decayChainLimits)
+    : G4UserStackingAction(),
+      m_decayChainLimits(decayChainLimits)
+{}
+
+
+StackingAction::~StackingAction()
+{}
+
+
+G4ClassificationOfNewTrack StackingAction::ClassifyNewTrack(const G4Track* track)
+{
+    if (!m_decayChainLimits->IsEnabled())
+    {
+        return fUrgent;
+    }
+
+    const G4bool isNucleus = track->GetParticleDefinition()->GetParticleType() == "nucleus";
+
+    const G4VProcess* creator = track->GetCreatorProcess();
+    if (!creator || creator->GetProcessSubType() != fRadioactiveDecay)
+    {
+        // primary or otherwise produced nuclei start a chain
+        if (isNucleus)
+        {
+            m_nuclei[track->GetTrackID()] = {track->GetParticleDefinition(), 0};
+        }
+        return fUrgent;
+    }
+
+    // product of a radioactive decay of the parent nucleus; only a change of
+    // the nuclide is a new link of the chain, the de-excitation of a level
+    // keeps the depth of the decay that fed it
+    const G4int parentID = track->GetParentID();
+    const auto parent = m_nuclei.find(parentID);
+    G4int depth = 1;
+    if (parent != m_nuclei.end())
+    {
+        auto decayDepth = m_decayDepths.find(parentID);
+        if (decayDepth == m_decayDepths.end())
+        {
+            const G4int parentDepth = parent->second.depth;
+            const G4int newDepth = ChangesNuclide(parent->second.definition) ? parentDepth + 1 : std::max(parentDepth, 1);
+            decayDepth = m_decayDepths.emplace(parentID, newDepth).first;
+        }
+        depth = decayDepth->second;
+    }
+
+    // the products carry the time of the decay
+    if (m_firstDecayTime < 0)
+    {
+        m_firstDecayTime = track->GetGlobalTime();
+    }
+    const G4bool outsideTimeWindow
+        = m_decayChainLimits->IsOutsideTimeWindow(track->GetGlobalTime() - m_firstDecayTime);
+    if (outsideTimeWindow || m_decayChainLimits->IsTooDeep(depth))
+    {
+        if (m_cutDecays.insert(parentID).second)
+        {
+            const G4String nuclide = (parent != m_nuclei.end()) ? parent->second.definition->GetParticleName() : "unknown";
+            m_decayChainLimits->AddCut(nuclide, outsideTimeWindow);
+        }
+        return fKill;
+    }
+
+    if (isNucleus)
+    {
+        m_nuclei[track->GetTrackID()] = {track->GetParticleDefinition(), depth};
+    }
+    return fUrgent;
+}
+
+
+G4bool StackingAction::ChangesNuclide(const G4ParticleDefinition* parent) const
+{
+    // the products of the decay are the secondaries of the parent that are
+    // being stacked
+    const G4TrackVector* secondaries = G4EventManager::GetEventManager()->GetTrackingManager()->GimmeSecondaries();
+    if (!secondaries)
+    {
+        return true;
+    }
+
+    G4bool foundNucleus = false;
+    for (const G4Track* secondary : *secondaries)
+    {
+        const G4VProcess* creator = secondary->GetCreatorProcess();
+        const G4ParticleDefinition* definition = secondary->GetParticleDefinition();
+        if (!creator || creator->GetProcessSubType() != fRadioactiveDecay || definition->GetParticleType() != "nucleus")
+        {
+            continue;
+        }
+        if (definition->GetAtomicNumber() != parent->GetAtomicNumber()
+            || definition->GetAtomicMass() != parent->GetAtomicMass())
+        {
+            return true;
+        }
+        foundNucleus = true;
+    }
+    return !foundNucleus;
+}
+
+
+void StackingAction::PrepareNewEvent()
+{
+    m_nuclei.clear();
+    m_decayDepths.clear();
+    m_cutDecays.clear();
+    m_firstDecayTime = -1;
+}
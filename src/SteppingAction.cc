@@ -1,17 +1,27 @@
 #include "SteppingAction.hh"
 #include "EventAction.hh"
 #include "DetectorConstruction.hh"
+#include "HPGeDetector.hh"
+#include "TwoTierRun.hh"
+#include "AdjointSimulation.hh"
 
 #include "G4Step.hh"
 #include "G4Event.hh"
+#include "G4EventManager.hh"
 #include "G4RunManager.hh"
 #include "G4LogicalVolume.hh"
 
 
-SteppingAction::SteppingAction(EventAction* eventAction)
+SteppingAction::SteppingAction(EventAction* eventAction, PhaseSpaceRecorder::Writer* phaseSpaceWriter)
     : G4UserSteppingAction(),
       m_eventAction(eventAction),
-      m_scoringVolume(nullptr)
+      m_phaseSpaceWriter(phaseSpaceWriter),
+      m_scoringVolume(nullptr),
+      m_detectorConstruction(nullptr),
+      m_geometryVersion(-1),
+      m_detectorVolume(nullptr),
+      m_hpgeDetector(nullptr),
+      m_crystalVolume(nullptr)
 {}
 
 
@@ -21,12 +31,25 @@ SteppingAction::~SteppingAction()
 
 void SteppingAction::UserSteppingAction(const G4Step* step)
 {
-    if (!m_scoringVolume)
+    if (!m_detectorConstruction)
     {
-        const DetectorConstruction* detectorConstruction
+        m_detectorConstruction
             = static_cast<const DetectorConstruction*>
               (G4RunManager::GetRunManager()->GetUserDetectorConstruction());
-        m_scoringVolume = detectorConstruction->GetScoringVolume();
+    }
+
+    if (m_geometryVersion != m_detectorConstruction->GetGeometryVersion())
+    {
+        m_geometryVersion = m_detectorConstruction->GetGeometryVersion();
+        m_scoringVolume = m_detectorConstruction->GetScoringVolume();
+
+        auto hpgeDetector = m_detectorConstruction->GetHPGeDetector();
+        m_detectorVolume = hpgeDetector->GetCrystalVolume();
+        if (hpgeDetector->GetDepthRecordBinWidth() > 0)
+        {
+            m_hpgeDetector = hpgeDetector;
+            m_crystalVolume = hpgeDetector->GetCrystalVolume();
+        }
     }
 
     // get volume of the current step
@@ -34,6 +57,47 @@ void SteppingAction::UserSteppingAction(const G4Step* step)
         = step->GetPreStepPoint()->GetTouchableHandle()
           ->GetVolume()->GetLogicalVolume();
 
+    // adjoint runs: the adjoint phase of an event only scores track lengths
+    if (AdjointSimulation::Step(step))
+    {
+        return;
+    }
+
+    // two-tier screening: the event is kept once it reaches the crystal,
+    // nothing else about it matters
+    if (TwoTierRun::IsScreening())
+    {
+        if (volume == m_detectorVolume || volume == m_scoringVolume)
+        {
+            m_eventAction->SetNearDetector();
+            G4EventManager::GetEventManager()->AbortCurrentEvent();
+        }
+        return;
+    }
+
+    // first stage of a two-stage simulation: particles leaving the target region
+    m_phaseSpaceWriter->Step(step);
+
+    // record deposits anywhere in the crystal by their depth below the surfaces
+    if (m_crystalVolume && (volume == m_crystalVolume || volume == m_scoringVolume))
+    {
+        const G4double edepStep = step->GetTotalEnergyDeposit();
+        if (edepStep > 0)
+        {
+            // transform the step midpoint into the frame of the full crystal,
+            // which is the mother of the active volume
+            const G4VTouchable* touchable = step->GetPreStepPoint()->GetTouchable();
+            const G4int depth = (volume == m_crystalVolume) ? 0 : 1;
+            const G4ThreeVector midPoint = 0.5*(step->GetPreStepPoint()->GetPosition() + step->GetPostStepPoint()->GetPosition());
+            const G4ThreeVector crystalPosition
+                = touchable->GetHistory()->GetTransform(touchable->GetHistoryDepth() - depth).TransformPoint(midPoint);
+
+            G4double depths[4];
+            m_hpgeDetector->GetDeadLayerDepths(crystalPosition, depths);
+            m_eventAction->AddDepthDeposit(depths, edepStep);
+        }
+    }
+
     // check if we are in scoring volume
     if (volume != m_scoringVolume)
     {
@@ -42,5 +106,5 @@ void SteppingAction::UserSteppingAction(const G4Step* step)
 
     // collect energy deposited in this step
     const G4double edepStep = step->GetTotalEnergyDeposit();
-    m_eventAction->AddEdep(edepStep);
+    m_eventAction->AddEdep(edepStep, step->GetPreStepPoint()->GetWeight());
 }
@@ -24,6 +24,34 @@ using CLHEP::perCent;
 using CLHEP::cm3;
 using CLHEP::g;
 
+// Dimensions, shared by the full and the simplified model
+
+// CF100 flange upstream
+
+static const auto lengthCF100 = 18 * mm;
+static const auto rInnerCF100 = 0.5 * 37  * mm; // Assumed everything is a cylinder with an inner radius of 37 mm
+static const auto rOuterCF100 = 0.5 * 114 * mm;
+
+// CF 40 flange
+
+static const auto lengthCF40 =       13 * mm;
+static const auto rInnerCF40 = 0.5 * 37 * mm;
+static const auto rOuterCF40 = 0.5 * 70 * mm;
+
+// Tube
+
+static const auto lengthTube =     234 * mm;
+static const auto rInnerTube = 0.5* 37 * mm;
+static const auto rOuterTube = 0.5* 40 * mm;
+
+// Threaded counter flange for target holder installation
+
+static const auto lengthCounterFlange = 12.7 * mm;
+static const auto rInnerCounterFlange = 0.5 * 38 * mm;
+static const auto rOuterCounterFlange = 0.5 * 50.1 * mm - 1 * um;
+
+static const auto phiStart =   0*deg;
+static const auto phiTotal = 360*deg;
 
 TargetChamberC12::TargetChamberC12() : GeometryObject("TargetChamberC12")
 {
@@ -38,33 +66,6 @@ G4VPhysicalVolume *TargetChamberC12::Construct()
     /// Dimensions
     //
 
-    // CF100 flange upstream
-
-    const auto lengthCF100 = 18 * mm;
-    const auto rInnerCF100 = 0.5 * 37  * mm; // Assumed everything is a cylinder with an inner radius of 37 mm
-    const auto rOuterCF100 = 0.5 * 114 * mm;
-
-    // CF 40 flange
-
-    const auto lengthCF40 =       13 * mm;
-    const auto rInnerCF40 = 0.5 * 37 * mm;
-    const auto rOuterCF40 = 0.5 * 70 * mm;
-
-    // Tube
-
-    const auto lengthTube =     234 * mm;
-    const auto rInnerTube = 0.5* 37 * mm;
-    const auto rOuterTube = 0.5* 40 * mm;
-
-    // Threaded counter flange for target holder installation
-
-    const auto lengthCounterFlange = 12.7 * mm;
-    const auto rInnerCounterFlange = 0.5 * 38 * mm;
-    const auto rOuterCounterFlange = 0.5 * 50.1 * mm - 1 * um;
-
-    const auto phiStart =   0*deg;
-    const auto phiTotal = 360*deg;
-
     // Chamber itself
 
     const G4int chamberNZPlanes = 4;
@@ -98,22 +99,23 @@ G4VPhysicalVolume *TargetChamberC12::Construct()
 
     auto man = G4NistManager::Instance();
 
-    G4Material* matFe = man->FindOrBuildMaterial("G4_Fe");
-    G4Material* matCr = man->FindOrBuildMaterial("G4_Cr");
-    G4Material* matNi = man->FindOrBuildMaterial("G4_Ni");
-    G4Material* matMo = man->FindOrBuildMaterial("G4_Mo");
-
-    G4Material* matSteel = new G4Material("Steel-316", 8.0*g/cm3, 4);
-    matSteel->AddMaterial(matFe, 69*perCent);
-    matSteel->AddMaterial(matCr, 17*perCent);
-    matSteel->AddMaterial(matNi, 12*perCent);
-    matSteel->AddMaterial(matMo,  2*perCent);
+    G4Material* matSteel = GetSteel316();
 
     auto matAl    = man->FindOrBuildMaterial("G4_Al");
 
     auto matChamber = matSteel;
 
 
+    // The simplified model is a single polycone of flanges and tube
+    if (GetDetail() == detailSimplified)
+    {
+        auto logicMerged = new G4LogicalVolume(ConstructMergedSolid(), matChamber, CreateLogicalName("merged"));
+        logicMerged->SetVisAttributes(G4VisAttributes(G4Colour::Grey()));
+        PlaceVolume(logicMerged, GetMotherVolume());
+        return nullptr;
+    }
+
+
     /// Solids
     //
 
@@ -167,6 +169,59 @@ G4VPhysicalVolume *TargetChamberC12::Construct()
     return nullptr;
 }
 
+G4Polycone *TargetChamberC12::ConstructMergedSolid()
+{
+    // In the frame of the object, the counter flange ends at z = 0
+    const auto zCF40 = -(lengthCF40 + lengthTube + lengthCounterFlange);
+    const auto zTube = -(lengthTube + lengthCounterFlange);
+    const auto zCounterFlange = -lengthCounterFlange;
+
+    const G4int mergedNZPlanes = 8;
+    const G4double mergedZPlanes[] =
+    {
+        zCF40 - lengthCF100,
+        zCF40,
+        zCF40,
+        zTube,
+        zTube,
+        zCounterFlange,
+        zCounterFlange,
+        0
+    };
+
+    const G4double mergedRInner[] =
+    {
+        rInnerCF100,
+        rInnerCF100,
+        rInnerCF40,
+        rInnerCF40,
+        rInnerTube,
+        rInnerTube,
+        rInnerCounterFlange,
+        rInnerCounterFlange
+    };
+
+    const G4double mergedROuter[] =
+    {
+        rOuterCF100,
+        rOuterCF100,
+        rOuterCF40,
+        rOuterCF40,
+        rOuterTube,
+        rOuterTube,
+        rOuterCounterFlange,
+        rOuterCounterFlange
+    };
+
+    return new G4Polycone(CreateSolidName("merged"), phiStart, phiTotal,
+            mergedNZPlanes, mergedZPlanes, mergedRInner, mergedROuter);
+}
+
+G4VSolid *TargetChamberC12::ConstructHull()
+{
+    return ConstructMergedSolid();
+}
+
 void TargetChamberC12::SetNewValue(G4UIcommand* command, G4String value)
 {
     GeometryObject::SetNewValue(command, value);
@@ -39,6 +39,15 @@ using std::runtime_error;
 #include <memory>
 using std::make_shared;
 
+// Outer profile of the holder, shared by Construct() and ConstructHull()
+static const G4double lengthHolderTop = -26.2 * mm;
+static const G4double rInnerHolderTop = 0.5 * 50.1 * mm;
+static const G4double rOuterHolderTop = 0.5 * 69.0 * mm;
+
+static const G4double lengthHolderInside = -16.2 * mm;
+
+static const G4double lengthHolderHole = -12.5 * mm;
+
 TargetHolderC12::TargetHolderC12() : GeometryObject("TargetHolderC12")
 {
     fTargetCmd = make_shared<G4UIcmdWithAString>("/Geometry/TargetHolderC12/target", this);
@@ -57,6 +66,7 @@ void TargetHolderC12::SetNewValue(G4UIcommand* command, G4String newValue)
     if(command == fTargetCmd.get())
     {
         fTargetChosen = true;
+        SetModified();
 
         if (newValue == "graphite")
         {
@@ -95,16 +105,7 @@ G4VPhysicalVolume *TargetHolderC12::Construct()
 	G4Material* matAl = man->FindOrBuildMaterial("G4_Al");
 	G4Material* matC = man->FindOrBuildMaterial("G4_GRAPHITE");
 
-	G4Material* matFe = man->FindOrBuildMaterial("G4_Fe");
-	G4Material* matCr = man->FindOrBuildMaterial("G4_Cr");
-	G4Material* matNi = man->FindOrBuildMaterial("G4_Ni");
-	G4Material* matMo = man->FindOrBuildMaterial("G4_Mo");
-
-	G4Material* matSteel = new G4Material("Steel-316", 8.0*g/cm3, 4);
-	matSteel->AddMaterial(matFe, 69*perCent);
-	matSteel->AddMaterial(matCr, 17*perCent);
-	matSteel->AddMaterial(matNi, 12*perCent);
-	matSteel->AddMaterial(matMo,  2*perCent);
+	G4Material* matSteel = GetSteel316();
 
 	/// Dimensions
 	//
@@ -112,20 +113,18 @@ G4VPhysicalVolume *TargetHolderC12::Construct()
 	G4RotationMatrix noRotation;
 	const auto tolerance = -10*um;
 
+	// The simplified model has no screws, no graphite supports and no
+	// water channels, and none of the holes for them
+	const G4bool simplified = GetDetail() == detailSimplified;
+
 	G4RotationMatrix xRot;
 	xRot.rotateX(90.*deg);
 	xRot.rotateZ(0.5*45.*deg);
 
 	// Target Holder Scheme Dimensions
-	const G4double lengthHolderTop = -26.2 * mm;
-	const G4double rInnerHolderTop = 0.5 * 50.1 * mm;
-	const G4double rOuterHolderTop = 0.5 * 69.0 * mm;
-
-	const G4double lengthHolderInside = -16.2 * mm;
 	const G4double rInnerHolderInside = 0.5 * 43.5 * mm;
 	const G4double rOuterHolderInside = 0.5 * 50.3 * mm;
 
-	const G4double lengthHolderHole = -12.5 * mm;
 	const G4double rInnerHolderHole = 0.5 * 23.3 * mm;
 	const G4double rOuterHolderHole = 0.5 * 43.5 * mm;
 
@@ -354,7 +353,7 @@ G4VPhysicalVolume *TargetHolderC12::Construct()
 
 	// Now the M2.5 holes are cut in the Target Holder
 	G4VSolid* solidHolder = solidHolderPl;
-	for( int i = 0; i < 8; ++i ){  
+	for( int i = 0; i < 8 && !simplified; ++i ){  
 		solidHolder = new G4SubtractionSolid("Target_Holder_cut", solidHolder, screwHoles,
             								  G4Transform3D(noRotation,
                           						                G4ThreeVector(centerM2Holes*std::sin(i*phiM2Holes), 
@@ -363,21 +362,23 @@ G4VPhysicalVolume *TargetHolderC12::Construct()
 	};
 
 	// Now the Water Holes are cut
-	solidHolder = new G4SubtractionSolid("Target_Holder_body", solidHolder, waterHoles,
-            							G4Transform3D(xRot,
-                          				G4ThreeVector(-rOuterHolderTop*std::sin(0.5*45.*deg), rOuterHolderTop*std::cos(0.5*45.*deg), centerWaterHoles)));
-
-	solidHolder = new G4SubtractionSolid("Target_Holder_body", solidHolder, waterHoles,
-            							G4Transform3D(xRot,
-                          				G4ThreeVector(rOuterHolderTop*std::sin(0.5*45.*deg), -rOuterHolderTop*std::cos(0.5*45.*deg), centerWaterHoles)));
-
-	solidHolder = new G4SubtractionSolid("Target_Holder_body", solidHolder, waterHolesInside,
-            							G4Transform3D(xRot,
-                          				G4ThreeVector(-( rOuterHolderTop - 12 )*std::sin(0.5*45.*deg), ( rOuterHolderTop - 12 )*std::cos(0.5*45.*deg), centerWaterHoles)));
-
-	solidHolder = new G4SubtractionSolid("Target_Holder_body", solidHolder, waterHolesInside,
-            							G4Transform3D(xRot,
-                          				G4ThreeVector(( rOuterHolderTop - 12 )*std::sin(0.5*45.*deg), -(rOuterHolderTop - 12 )*std::cos(0.5*45.*deg), centerWaterHoles)));
+	if( !simplified ){
+		solidHolder = new G4SubtractionSolid("Target_Holder_body", solidHolder, waterHoles,
+	            							G4Transform3D(xRot,
+	                          				G4ThreeVector(-rOuterHolderTop*std::sin(0.5*45.*deg), rOuterHolderTop*std::cos(0.5*45.*deg), centerWaterHoles)));
+
+		solidHolder = new G4SubtractionSolid("Target_Holder_body", solidHolder, waterHoles,
+	            							G4Transform3D(xRot,
+	                          				G4ThreeVector(rOuterHolderTop*std::sin(0.5*45.*deg), -rOuterHolderTop*std::cos(0.5*45.*deg), centerWaterHoles)));
+
+		solidHolder = new G4SubtractionSolid("Target_Holder_body", solidHolder, waterHolesInside,
+	            							G4Transform3D(xRot,
+	                          				G4ThreeVector(-( rOuterHolderTop - 12 )*std::sin(0.5*45.*deg), ( rOuterHolderTop - 12 )*std::cos(0.5*45.*deg), centerWaterHoles)));
+
+		solidHolder = new G4SubtractionSolid("Target_Holder_body", solidHolder, waterHolesInside,
+	            							G4Transform3D(xRot,
+	                          				G4ThreeVector(( rOuterHolderTop - 12 )*std::sin(0.5*45.*deg), -(rOuterHolderTop - 12 )*std::cos(0.5*45.*deg), centerWaterHoles)));
+	}
 
 	// Graphite Target
 	G4Polycone* solidTargetC = new G4Polycone("Target",phiStart,phiTotal,targetGraphNZPlanes,
@@ -396,7 +397,7 @@ G4VPhysicalVolume *TargetHolderC12::Construct()
 
 	//Now the M2.5 Holes are cut in the Ta Backing
 	G4VSolid* solidBacking = solidBackingPl;
-	for( int i = 0; i < 8; ++i ){
+	for( int i = 0; i < 8 && !simplified; ++i ){
 		solidBacking = new G4SubtractionSolid("Backing_cut", solidBacking, screwHoles,
             								   G4Transform3D(noRotation,
                           						                 G4ThreeVector(centerM2Holes*std::sin(i*phiM2Holes), 
@@ -410,7 +411,7 @@ G4VPhysicalVolume *TargetHolderC12::Construct()
 
 	// Now the M2.5 Holes are cut in the Screw Backing
 	G4VSolid* solidScrewBacking = solidScrewBackingPl;
-	for( int i = 0; i < 8; ++i ){
+	for( int i = 0; i < 8 && !simplified; ++i ){
 		solidScrewBacking = new G4SubtractionSolid( "Screw_Backing_body", solidScrewBacking, screwHoles,
             									G4Transform3D(noRotation,
                           						                      G4ThreeVector(centerM2Holes*std::sin(i*phiM2Holes), 
@@ -481,15 +482,17 @@ G4VPhysicalVolume *TargetHolderC12::Construct()
 	if( fTarget == targetGraphite ){
 		G4LogicalVolume* logicTarget = new G4LogicalVolume(solidTargetC, matC,
 				solidTargetC->GetName());
+		logicTarget->SetVisAttributes(G4VisAttributes(G4Colour::Green()));
+		PlaceVolume(logicTarget, GetMotherVolume(),
+				    -G4ThreeVector(0.,0.,lengthHolderHole + zOffset));
+	}
+	if( fTarget == targetGraphite && !simplified ){
 		G4LogicalVolume* logicGraphiteSupportH = new G4LogicalVolume(solidGraphiteSupportH, matSteel, 
 				solidGraphiteSupportH->GetName());
 		G4LogicalVolume* logicGraphiteSupportV = new G4LogicalVolume(solidGraphiteSupportV, matSteel, 
 				solidGraphiteSupportV->GetName());
-		logicTarget->SetVisAttributes(G4VisAttributes(G4Colour::Green()));
 		logicGraphiteSupportH->SetVisAttributes(G4VisAttributes(G4Colour::White( )));
 		logicGraphiteSupportV->SetVisAttributes(G4VisAttributes(G4Colour::White( )));
-		PlaceVolume(logicTarget, GetMotherVolume(),
-				    -G4ThreeVector(0.,0.,lengthHolderHole + zOffset));
 		PlaceVolume(logicGraphiteSupportH, GetMotherVolume(),
 					-G4ThreeVector(graphiteSupportX, graphiteSupportY, graphiteSupportZ));
 		PlaceVolume(logicGraphiteSupportH, GetMotherVolume(),
@@ -511,7 +514,7 @@ G4VPhysicalVolume *TargetHolderC12::Construct()
 			-G4ThreeVector(0.,0.,lengthHolderHole + zOffset));
 
 	// Placing all the M2.5 Screws
-	for( int i = 0; i < 8; ++i ){
+	for( int i = 0; i < 8 && !simplified; ++i ){
 		PlaceVolume(logicScrew, GetMotherVolume(),
 					-G4ThreeVector(centerM2Holes*std::sin(i*phiM2Holes), 
 						       centerM2Holes*std::cos(i*phiM2Holes),
@@ -540,17 +543,40 @@ G4VPhysicalVolume *TargetHolderC12::Construct()
 			-G4ThreeVector(-centerWaterHoles,0.,lengthHolderHole + zOffset - lengthWaterTubes - lengthHolderBack));
 */
 
-	PlaceVolume(logicWaterTubesWater, GetMotherVolume(),
-			-G4ThreeVector(-(rOuterHolderTop - 6)*std::sin(0.5*45.*deg), (rOuterHolderTop - 6)*std::cos(0.5*45.*deg), -centerWaterHoles + lengthHolderHole), xRot);
+	if( !simplified ){
+		PlaceVolume(logicWaterTubesWater, GetMotherVolume(),
+				-G4ThreeVector(-(rOuterHolderTop - 6)*std::sin(0.5*45.*deg), (rOuterHolderTop - 6)*std::cos(0.5*45.*deg), -centerWaterHoles + lengthHolderHole), xRot);
 
-	PlaceVolume(logicWaterTubesWater, GetMotherVolume(),
-			-G4ThreeVector(( rOuterHolderTop - 6 )*std::sin(0.5*45.*deg), -( rOuterHolderTop - 6 )*std::cos(0.5*45.*deg), -centerWaterHoles + lengthHolderHole), xRot);
+		PlaceVolume(logicWaterTubesWater, GetMotherVolume(),
+				-G4ThreeVector(( rOuterHolderTop - 6 )*std::sin(0.5*45.*deg), -( rOuterHolderTop - 6 )*std::cos(0.5*45.*deg), -centerWaterHoles + lengthHolderHole), xRot);
 
-	PlaceVolume(logicWaterTubesWaterInner, GetMotherVolume(),
-			-G4ThreeVector((rOuterHolderTop - 12 - 5.41 )*std::sin(0.5*45.*deg), -( rOuterHolderTop - 12 - 5.41 )*std::cos(0.5*45.*deg), -centerWaterHoles + lengthHolderHole), xRot);
+		PlaceVolume(logicWaterTubesWaterInner, GetMotherVolume(),
+				-G4ThreeVector((rOuterHolderTop - 12 - 5.41 )*std::sin(0.5*45.*deg), -( rOuterHolderTop - 12 - 5.41 )*std::cos(0.5*45.*deg), -centerWaterHoles + lengthHolderHole), xRot);
 
-    PlaceVolume(logicWaterTubesWaterInner, GetMotherVolume(),
-			-G4ThreeVector(-( rOuterHolderTop - 12 - 5.41 )*std::sin(0.5*45.*deg), ( rOuterHolderTop - 12 - 5.41 )*std::cos(0.5*45.*deg), -centerWaterHoles + lengthHolderHole), xRot);
+		PlaceVolume(logicWaterTubesWaterInner, GetMotherVolume(),
+				-G4ThreeVector(-( rOuterHolderTop - 12 - 5.41 )*std::sin(0.5*45.*deg), ( rOuterHolderTop - 12 - 5.41 )*std::cos(0.5*45.*deg), -centerWaterHoles + lengthHolderHole), xRot);
+	}
 
 	return nullptr;
 }
+
+G4VSolid *TargetHolderC12::ConstructHull()
+{
+	// The holder filled up to its outer radius, keeping the bore at the top
+	// free for the flange of the target chamber. The holder is placed at
+	// -lengthHolderHole.
+	const G4int hullNZPlanes = 4;
+	const G4double hullZPlanes[] =
+	{
+		-lengthHolderHole,
+		lengthHolderInside - lengthHolderHole,
+		lengthHolderInside - lengthHolderHole,
+		lengthHolderTop - lengthHolderHole
+	};
+
+	const G4double hullRInner[] = {0, 0, rInnerHolderTop, rInnerHolderTop};
+	const G4double hullROuter[] = {rOuterHolderTop, rOuterHolderTop, rOuterHolderTop, rOuterHolderTop};
+
+	return new G4Polycone(CreateSolidName("hull"), 0*deg, 360*deg, hullNZPlanes,
+			hullZPlanes, hullRInner, hullROuter);
+}
@@ -0,0 +1,369 @@
+#include "ThreadPlacement.hh"
+
+#include "G4Threading.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithABool.hh"
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <tuple>
+
+#include <memory>
+using std::make_shared;
+
+#include <stdexcept>
+using std::runtime_error;
+
+ThreadPlacement* ThreadPlacement::s_instance = nullptr;
+
+namespace
+{
+    // whether this worker was pinned by the ThreadPlacement
+    G4ThreadLocal G4bool t_pinned = false;
+
+    G4int ReadInt(const std::string& fileName, const G4int defaultValue)
+    {
+        std::ifstream file(fileName);
+        G4int value;
+        if (file >> value)
+        {
+            return value;
+        }
+        return defaultValue;
+    }
+}
+
+ThreadPlacement::ThreadPlacement()
+    : G4UImessenger()
+{
+    s_instance = this;
+    ReadTopology();
+
+    m_pinCmd = make_shared<G4UIcmdWithAString>("/Threads/pin", this);
+    m_pinCmd->SetGuidance("Pin the worker threads to logical CPUs (before the first run):");
+    m_pinCmd->SetGuidance("  none:         the scheduler decides (default)");
+    m_pinCmd->SetGuidance("  cores:        one worker per physical core first, node by node");
+    m_pinCmd->SetGuidance("  hyperthreads: both hyperthreads of a core first, node by node");
+    m_pinCmd->SetGuidance("  scatter:      one worker per physical core first, alternating the nodes");
+    m_pinCmd->SetParameterName("policy", false);
+    m_pinCmd->SetCandidates("none cores hyperthreads scatter");
+    m_pinCmd->SetToBeBroadcasted(false);
+
+    m_reportCmd = make_shared<G4UIcmdWithABool>("/Threads/report", this);
+    m_reportCmd->SetGuidance("Print the CPU and the events per second of every worker after every run.");
+    m_reportCmd->SetParameterName("report", false);
+    m_reportCmd->SetToBeBroadcasted(false);
+}
+
+void ThreadPlacement::ReadTopology()
+{
+    m_cpus.clear();
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    {
+        return;
+    }
+
+    for (G4int id = 0; id < CPU_SETSIZE; id++)
+    {
+        if (!CPU_ISSET(id, &allowed))
+        {
+            continue;
+        }
+
+        const std::string dirName = "/sys/devices/system/cpu/cpu" + std::to_string(id);
+        Cpu cpu;
+        cpu.id = id;
+        cpu.package = ReadInt(dirName + "/topology/physical_package_id", 0);
+        cpu.core = ReadInt(dirName + "/topology/core_id", id);
+
+        // the node shows up as a link "node<N>" in the directory of the CPU
+        cpu.node = 0;
+        if (DIR* dir = opendir(dirName.c_str()))
+        {
+            while (const dirent* entry = readdir(dir))
+            {
+                const std::string name = entry->d_name;
+                if (name.size() > 4 && name.compare(0, 4, "node") == 0
+                    && name.find_first_not_of("0123456789", 4) == std::string::npos)
+                {
+                    cpu.node = std::atoi(name.c_str() + 4);
+                    break;
+                }
+            }
+            closedir(dir);
+        }
+
+        cpu.sibling = std::count_if(m_cpus.begin(), m_cpus.end(), [&cpu](const Cpu& other)
+        {
+            return other.package == cpu.package && other.core == cpu.core;
+        });
+        m_cpus.push_back(cpu);
+    }
+#endif
+}
+
+void ThreadPlacement::UpdateOrder()
+{
+    vector<Cpu> cpus = m_cpus;
+    if (m_policy == policyHyperthreads)
+    {
+        std::sort(cpus.begin(), cpus.end(), [](const Cpu& a, const Cpu& b)
+        {
+            return std::tie(a.node, a.package, a.core, a.sibling) < std::tie(b.node, b.package, b.core, b.sibling);
+        });
+    }
+    else
+    {
+        std::sort(cpus.begin(), cpus.end(), [](const Cpu& a, const Cpu& b)
+        {
+            return std::tie(a.sibling, a.node, a.package, a.core) < std::tie(b.sibling, b.node, b.package, b.core);
+        });
+    }
+
+    m_order.clear();
+    if (m_policy != policyScatter)
+    {
+        for (const Cpu& cpu : cpus)
+        {
+            m_order.push_back(cpu.id);
+        }
+        return;
+    }
+
+    // per hyperthread level, take the cores from the nodes in turn
+    auto levelBegin = cpus.begin();
+    while (levelBegin != cpus.end())
+    {
+        auto levelEnd = std::find_if(levelBegin, cpus.end(), [levelBegin](const Cpu& cpu)
+        {
+            return cpu.sibling != levelBegin->sibling;
+        });
+
+        std::map<G4int, vector<G4int>> nodes;
+        for (auto cpu = levelBegin; cpu != levelEnd; ++cpu)
+        {
+            nodes[cpu->node].push_back(cpu->id);
+        }
+        for (size_t i = 0; m_order.size() < size_t(levelEnd - cpus.begin()); i++)
+        {
+            for (const auto& node : nodes)
+            {
+                if (i < node.second.size())
+                {
+                    m_order.push_back(node.second[i]);
+                }
+            }
+        }
+
+        levelBegin = levelEnd;
+    }
+}
+
+G4int ThreadPlacement::GetNode(const G4int cpu) const
+{
+    for (const Cpu& entry : m_cpus)
+    {
+        if (entry.id == cpu)
+        {
+            return entry.node;
+        }
+    }
+    return -1;
+}
+
+void ThreadPlacement::PinWorker()
+{
+    const G4int thread = G4Threading::G4GetThreadId();
+    if (!s_instance || thread < 0)
+    {
+        return;
+    }
+    // leave the threads alone (or to /run/pinAffinity) unless asked
+    if (s_instance->m_policy == policyNone && !t_pinned)
+    {
+        return;
+    }
+
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (s_instance->m_policy == policyNone)
+    {
+        // unpin: all CPUs of the process
+        for (const Cpu& cpu : s_instance->m_cpus)
+        {
+            CPU_SET(cpu.id, &set);
+        }
+    }
+    else
+    {
+        const vector<G4int>& order = s_instance->m_order;
+        CPU_SET(order[thread % order.size()], &set);
+    }
+
+    const int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (error != 0)
+    {
+        G4cerr << "ThreadPlacement: worker " << thread << " could not be pinned (error " << error << ")." << G4endl;
+        return;
+    }
+    t_pinned = s_instance->m_policy != policyNone;
+#endif
+}
+
+void ThreadPlacement::BeginOfWorkerRun()
+{
+    const G4int thread = G4Threading::G4GetThreadId();
+    if (!s_instance || thread < 0)
+    {
+        return;
+    }
+    PinWorker();
+
+    G4AutoLock lock(&s_instance->m_mutex);
+    if (s_instance->m_workers.size() <= size_t(thread))
+    {
+        s_instance->m_workers.resize(thread + 1);
+    }
+    WorkerRecord& record = s_instance->m_workers[thread];
+    record.start = std::chrono::steady_clock::now();
+    record.events = -1;
+}
+
+void ThreadPlacement::EndOfWorkerRun(const G4int nEvents)
+{
+    const G4int thread = G4Threading::G4GetThreadId();
+    if (!s_instance || thread < 0)
+    {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    G4AutoLock lock(&s_instance->m_mutex);
+    WorkerRecord& record = s_instance->m_workers.at(thread);
+    record.seconds = std::chrono::duration<G4double>(now - record.start).count();
+    record.events = nEvents;
+#ifdef __linux__
+    record.cpu = sched_getcpu();
+#endif
+}
+
+void ThreadPlacement::BeginOfRun()
+{
+    if (!s_instance)
+    {
+        return;
+    }
+
+    G4AutoLock lock(&s_instance->m_mutex);
+    for (WorkerRecord& record : s_instance->m_workers)
+    {
+        record.events = -1;
+    }
+}
+
+void ThreadPlacement::EndOfRun()
+{
+    if (!s_instance || !s_instance->m_report)
+    {
+        return;
+    }
+
+    G4AutoLock lock(&s_instance->m_mutex);
+    G4int workers = 0;
+    G4long events = 0;
+    G4double total = 0;
+    G4double slowest = 0;
+    G4double fastest = 0;
+    std::map<G4int, G4double> nodes;
+
+    G4cout << "ThreadPlacement: events per second of the workers" << G4endl;
+    G4cout << "    worker    cpu   node     events   events/s" << G4endl;
+    for (size_t thread = 0; thread < s_instance->m_workers.size(); thread++)
+    {
+        const WorkerRecord& record = s_instance->m_workers[thread];
+        if (record.events < 0)
+        {
+            continue;
+        }
+
+        const G4double rate = (record.seconds > 0) ? record.events/record.seconds : 0;
+        const G4int node = s_instance->GetNode(record.cpu);
+        G4cout << std::setw(10) << thread << std::setw(7) << record.cpu << std::setw(7) << node
+               << std::setw(11) << record.events << std::setw(11) << std::fixed << std::setprecision(1) << rate
+               << std::defaultfloat << G4endl;
+
+        slowest = (workers == 0) ? rate : std::min(slowest, rate);
+        fastest = std::max(fastest, rate);
+        workers++;
+        events += record.events;
+        total += rate;
+        nodes[node] += rate;
+    }
+    if (workers == 0)
+    {
+        return;
+    }
+
+    G4cout << "ThreadPlacement: " << workers << " workers, " << events << " events, " << total
+           << " events/s in total, " << total/workers << " per worker (slowest " << slowest
+           << ", fastest " << fastest << ")" << G4endl;
+    if (nodes.size() > 1)
+    {
+        for (const auto& node : nodes)
+        {
+            G4cout << "ThreadPlacement: node " << node.first << ": " << node.second << " events/s" << G4endl;
+        }
+    }
+}
+
+void ThreadPlacement::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_pinCmd.get())
+    {
+        if (newValue == "none")
+        {
+            m_policy = policyNone;
+            return;
+        }
+        if (m_cpus.empty())
+        {
+            throw runtime_error("ThreadPlacement: the CPU topology is not available, only 'none' is possible");
+        }
+
+        if (newValue == "cores")
+        {
+            m_policy = policyCores;
+        }
+        else if (newValue == "hyperthreads")
+        {
+            m_policy = policyHyperthreads;
+        }
+        else
+        {
+            m_policy = policyScatter;
+        }
+        UpdateOrder();
+    }
+    else if (command == m_reportCmd.get())
+    {
+        m_report = m_reportCmd->GetNewBoolValue(newValue);
+    }
+    else
+    {
+        throw runtime_error("Unknown command in ThreadPlacement::SetNewValue()");
+    }
+}
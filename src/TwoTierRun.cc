@@ -0,0 +1,236 @@
+#include "TwoTierRun.hh"
+
+#include "EnergyHistogram.hh"
+
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4RunManager.hh"
+#include "G4Timer.hh"
+#include "G4UImanager.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "Randomize.hh"
+#include "CLHEP/Random/MixMaxRng.h"
+
+#include <algorithm>
+#include <climits>
+#include <sstream>
+
+#include <memory>
+using std::make_shared;
+
+#include <stdexcept>
+using std::runtime_error;
+
+TwoTierRun* TwoTierRun::s_instance = nullptr;
+
+namespace
+{
+    // the roulette draws of this worker, apart from the engine of the events
+    G4ThreadLocal CLHEP::MixMaxRng* t_rouletteEngine = nullptr;
+}
+
+TwoTierRun::TwoTierRun(EnergyHistogram* energyHistogram)
+    : G4UImessenger(),
+      m_energyHistogram(energyHistogram)
+{
+    s_instance = this;
+
+    m_screenCommandCmd = make_shared<G4UIcmdWithAString>("/TwoTier/screenCommand", this);
+    m_screenCommandCmd->SetGuidance("Command applied before the screening pass (cheap settings).");
+    m_screenCommandCmd->SetParameterName("command", false);
+    m_screenCommandCmd->SetToBeBroadcasted(false);
+
+    m_fullCommandCmd = make_shared<G4UIcmdWithAString>("/TwoTier/fullCommand", this);
+    m_fullCommandCmd->SetGuidance("Command applied before the replay of the kept events (full fidelity).");
+    m_fullCommandCmd->SetParameterName("command", false);
+    m_fullCommandCmd->SetToBeBroadcasted(false);
+
+    m_clearCommandsCmd = make_shared<G4UIcmdWithoutParameter>("/TwoTier/clearCommands", this);
+    m_clearCommandsCmd->SetGuidance("Forget the screening and full-fidelity commands.");
+    m_clearCommandsCmd->SetToBeBroadcasted(false);
+
+    m_rouletteFractionCmd = make_shared<G4UIcmdWithADouble>("/TwoTier/rouletteFraction", this);
+    m_rouletteFractionCmd->SetGuidance("Fraction of the events the screening drops that are replayed anyway,");
+    m_rouletteFractionCmd->SetGuidance("with the inverse as weight (default 0.01, 0: biased).");
+    m_rouletteFractionCmd->SetParameterName("fraction", false);
+    m_rouletteFractionCmd->SetRange("fraction >= 0 && fraction <= 1");
+    m_rouletteFractionCmd->SetToBeBroadcasted(false);
+
+    m_beamOnCmd = make_shared<G4UIcmdWithAnInteger>("/TwoTier/beamOn", this);
+    m_beamOnCmd->SetGuidance("Screen N events and replay those near the detector at full fidelity.");
+    m_beamOnCmd->SetParameterName("N", false);
+    m_beamOnCmd->SetRange("N >= 0");
+    m_beamOnCmd->SetToBeBroadcasted(false);
+}
+
+void TwoTierRun::ApplyCommands(const vector<G4String>& commands) const
+{
+    for (const G4String& command : commands)
+    {
+        if (G4UImanager::GetUIpointer()->ApplyCommand(command) != 0)
+        {
+            throw runtime_error("TwoTierRun: command '" + command + "' failed");
+        }
+    }
+}
+
+G4double TwoTierRun::BeginOfPrimaries(const G4Event* event)
+{
+    if (!s_instance || s_instance->m_mode != modeReplay)
+    {
+        return 1;
+    }
+
+    // the records do not change during the replay
+    const Record& record = s_instance->m_records.at(event->GetEventID());
+    std::istringstream status(record.engineStatus);
+    G4Random::restoreFullState(status);
+    return record.weight;
+}
+
+void TwoTierRun::EndOfEvent(const G4Event* event, const G4double edep, const G4bool nearDetector)
+{
+    if (!s_instance || s_instance->m_mode == modeOff)
+    {
+        return;
+    }
+
+    if (s_instance->m_mode == modeReplay)
+    {
+        if (!s_instance->m_records.at(event->GetEventID()).nearDetector && edep > 0)
+        {
+            s_instance->m_missedEvents++;
+        }
+        return;
+    }
+
+    // screening: the status before the primaries (/run/storeRndmStatToEvent)
+    Record record = {event->GetRandomNumberStatus(), 1, nearDetector};
+    if (!nearDetector)
+    {
+        const G4double fraction = s_instance->m_rouletteFraction;
+        if (fraction <= 0 || s_instance->DrawRoulette(event->GetEventID()) >= fraction)
+        {
+            return;
+        }
+        record.weight = 1/fraction;
+    }
+
+    G4AutoLock lock(&s_instance->m_mutex);
+    s_instance->m_records.push_back(record);
+}
+
+G4double TwoTierRun::DrawRoulette(const G4int eventID) const
+{
+    // a stream per event, independent of the thread that screened it
+    if (!t_rouletteEngine)
+    {
+        t_rouletteEngine = new CLHEP::MixMaxRng();
+    }
+    const long seeds[] = {m_rouletteSeed, eventID, 0};
+    t_rouletteEngine->setSeeds(seeds, 2);
+    return t_rouletteEngine->flat();
+}
+
+void TwoTierRun::BeamOn(const G4int nEvents)
+{
+    G4RunManager* runManager = G4RunManager::GetRunManager();
+    G4UImanager* UImanager = G4UImanager::GetUIpointer();
+    G4Timer timer;
+
+    m_records.clear();
+    m_missedEvents = 0;
+    // from the master engine, so the seeds of the run determine the roulette
+    m_rouletteSeed = static_cast<long>(G4UniformRand()*LONG_MAX);
+
+    ApplyCommands(m_screenCommands);
+    UImanager->ApplyCommand("/run/storeRndmStatToEvent 1");
+    m_mode = modeScreen;
+    timer.Start();
+    try
+    {
+        runManager->BeamOn(nEvents);
+    }
+    catch (...)
+    {
+        m_mode = modeOff;
+        throw;
+    }
+    timer.Stop();
+    m_mode = modeOff;
+    UImanager->ApplyCommand("/run/storeRndmStatToEvent 0");
+    const G4double screeningTime = timer.GetRealElapsed();
+
+    // the threads finish their events in any order
+    std::sort(m_records.begin(), m_records.end(),
+              [](const Record& a, const Record& b) {return a.engineStatus < b.engineStatus;});
+    const size_t nKept = std::count_if(m_records.begin(), m_records.end(),
+                                       [](const Record& record) {return record.nearDetector;});
+    const size_t nRoulette = m_records.size() - nKept;
+    if (m_records.size() > INT_MAX)
+    {
+        throw runtime_error("TwoTierRun: too many events to replay in one run");
+    }
+
+    ApplyCommands(m_fullCommands);
+    m_mode = modeReplay;
+    timer.Start();
+    try
+    {
+        runManager->BeamOn(static_cast<G4int>(m_records.size()));
+    }
+    catch (...)
+    {
+        m_mode = modeOff;
+        throw;
+    }
+    timer.Stop();
+    m_mode = modeOff;
+
+    // the spectra represent all screened events
+    m_energyHistogram->AddScreenedEvents(nEvents, static_cast<long>(m_records.size()));
+
+    G4cout << "TwoTierRun: screened " << nEvents << " events in " << screeningTime << " s, replayed "
+           << nKept << " near the detector and " << nRoulette << " by roulette in "
+           << timer.GetRealElapsed() << " s" << G4endl;
+    if (nRoulette > 0)
+    {
+        G4cout << "TwoTierRun: " << m_missedEvents << " of the " << nRoulette
+               << " roulette events deposited energy, the screening misses about "
+               << static_cast<G4double>(m_missedEvents)/nRoulette
+               << " of the events it drops" << G4endl;
+    }
+    m_records.clear();
+}
+
+void TwoTierRun::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_screenCommandCmd.get())
+    {
+        m_screenCommands.push_back(newValue);
+    }
+    else if (command == m_fullCommandCmd.get())
+    {
+        m_fullCommands.push_back(newValue);
+    }
+    else if (command == m_clearCommandsCmd.get())
+    {
+        m_screenCommands.clear();
+        m_fullCommands.clear();
+    }
+    else if (command == m_rouletteFractionCmd.get())
+    {
+        m_rouletteFraction = m_rouletteFractionCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_beamOnCmd.get())
+    {
+        BeamOn(m_beamOnCmd->GetNewIntValue(newValue));
+    }
+    else
+    {
+        throw runtime_error("Unknown command in TwoTierRun::SetNewValue()");
+    }
+}
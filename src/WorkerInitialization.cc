@@ -0,0 +1,8 @@
+#include "WorkerInitialization.hh"
+
+#include "ThreadPlacement.hh"
+
+void WorkerInitialization::WorkerInitialize() const
+{
+    ThreadPlacement::PinWorker();
+}
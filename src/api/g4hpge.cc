@@ -0,0 +1,257 @@
+/// \file g4hpge.cc
+/// \brief Implementation of the C interface of the simulation
+
+#include "api/g4hpge.h"
+
+#include "DetectorConstruction.hh"
+#include "ActionInitialization.hh"
+#include "PhysicsList.hh"
+#include "ScanManager.hh"
+#include "EfficiencyMap.hh"
+#include "ResultCache.hh"
+#include "RayTraceEstimator.hh"
+#include "TwoTierRun.hh"
+#include "ThreadPlacement.hh"
+#include "WorkerInitialization.hh"
+
+#ifdef G4MULTITHREADED
+#include "G4MTRunManager.hh"
+#else
+#include "G4RunManager.hh"
+#endif
+
+#include "G4StateManager.hh"
+#include "G4UImanager.hh"
+#include "Randomize.hh"
+
+#include <exception>
+#include <string>
+
+namespace
+{
+    G4RunManager* s_runManager = nullptr;
+    ActionInitialization* s_actionInitialization = nullptr;
+    ScanManager* s_scanManager = nullptr;
+    EfficiencyMap* s_efficiencyMap = nullptr;
+    ResultCache* s_resultCache = nullptr;
+    RayTraceEstimator* s_rayTraceEstimator = nullptr;
+    TwoTierRun* s_twoTierRun = nullptr;
+    ThreadPlacement* s_threadPlacement = nullptr;
+    G4bool s_finalized = false;
+
+    std::string s_lastError;
+
+    int Fail(const std::string& error)
+    {
+        s_lastError = error;
+        return -1;
+    }
+
+    int Apply(const G4String& command)
+    {
+        const G4int status = G4UImanager::GetUIpointer()->ApplyCommand(command);
+        if (status != 0)
+        {
+            return Fail("Command '" + command + "' failed with status " + std::to_string(status));
+        }
+        return 0;
+    }
+}
+
+
+int g4hpge_initialize(const char* setupMacro, const int nThreads, const long seed, const char* outputFileName)
+{
+    if (s_runManager || s_finalized)
+    {
+        return Fail("The simulation can only be initialized once per process.");
+    }
+
+    try
+    {
+        G4Random::setTheEngine(new CLHEP::RanecuEngine);
+        if (seed != 0)
+        {
+            G4Random::setTheSeed(seed);
+        }
+
+#ifdef G4MULTITHREADED
+        auto runManager = new G4MTRunManager;
+        if (nThreads > 0)
+        {
+            runManager->SetNumberOfThreads(nThreads);
+        }
+#else
+        auto runManager = new G4RunManager;
+        (void)nThreads;
+#endif
+        s_runManager = runManager;
+
+        auto detectorConstruction = new DetectorConstruction();
+        s_runManager->SetUserInitialization(detectorConstruction);
+        s_runManager->SetUserInitialization(new PhysicsList);
+        s_actionInitialization = new ActionInitialization(outputFileName ? outputFileName : "");
+        s_runManager->SetUserInitialization(s_actionInitialization);
+#ifdef G4MULTITHREADED
+        s_runManager->SetUserInitialization(new WorkerInitialization);
+#endif
+
+        // the same commands as in the executable
+        s_scanManager = new ScanManager(detectorConstruction, s_actionInitialization->GetEnergyHistogram());
+        s_efficiencyMap = new EfficiencyMap(s_actionInitialization->GetEnergyHistogram());
+        s_resultCache = new ResultCache(s_actionInitialization->GetEnergyHistogram());
+        s_rayTraceEstimator = new RayTraceEstimator(detectorConstruction);
+        s_twoTierRun = new TwoTierRun(s_actionInitialization->GetEnergyHistogram());
+        s_threadPlacement = new ThreadPlacement();
+
+        if (setupMacro && *setupMacro)
+        {
+            if (Apply(G4String("/control/execute ") + setupMacro) != 0)
+            {
+                return -1;
+            }
+        }
+        if (G4StateManager::GetStateManager()->GetCurrentState() == G4State_PreInit)
+        {
+            s_runManager->Initialize();
+        }
+    }
+    catch (const std::exception& error)
+    {
+        return Fail(error.what());
+    }
+    return 0;
+}
+
+
+int g4hpge_command(const char* command)
+{
+    if (!s_runManager)
+    {
+        return Fail("The simulation is not initialized.");
+    }
+
+    try
+    {
+        return Apply(command);
+    }
+    catch (const std::exception& error)
+    {
+        return Fail(error.what());
+    }
+}
+
+
+int g4hpge_run(const long long events)
+{
+    if (!s_runManager)
+    {
+        return Fail("The simulation is not initialized.");
+    }
+    if (events < 0 || events > 2147483647)
+    {
+        return Fail("The number of events must be within 0 and 2^31-1.");
+    }
+
+    try
+    {
+        s_actionInitialization->GetEnergyHistogram()->Reset();
+        s_runManager->BeamOn(static_cast<G4int>(events));
+    }
+    catch (const std::exception& error)
+    {
+        return Fail(error.what());
+    }
+    return 0;
+}
+
+
+const double* g4hpge_spectrum(const char* name, int* nBins, double* Emin, double* Emax, double* entries)
+{
+    if (!s_runManager)
+    {
+        Fail("The simulation is not initialized.");
+        return nullptr;
+    }
+
+    const EnergyHistogram* energyHistogram = s_actionInitialization->GetEnergyHistogram();
+    const std::string histogramName = name ? name : "h1";
+    const TH1D* histogram = nullptr;
+    if (histogramName == "h1")
+    {
+        histogram = energyHistogram->GetHistogram();
+    }
+    else if (histogramName == "h1w")
+    {
+        histogram = energyHistogram->GetWeightedHistogram();
+    }
+    else if (histogramName.compare(0, 3, "h1_") == 0)
+    {
+        histogram = energyHistogram->GetComponentHistogram(histogramName.substr(3));
+    }
+    if (!histogram)
+    {
+        Fail("There is no spectrum " + histogramName + ".");
+        return nullptr;
+    }
+
+    if (nBins)
+    {
+        *nBins = energyHistogram->GetNbins();
+    }
+    if (Emin)
+    {
+        *Emin = energyHistogram->GetEmin();
+    }
+    if (Emax)
+    {
+        *Emax = energyHistogram->GetEmax();
+    }
+    if (entries)
+    {
+        *entries = histogram->GetEntries();
+    }
+    // the bin contents of the histogram itself, the next run fills them again
+    return histogram->GetArray();
+}
+
+
+int g4hpge_finalize()
+{
+    if (!s_runManager)
+    {
+        return Fail("The simulation is not initialized.");
+    }
+
+    try
+    {
+        delete s_threadPlacement;
+        delete s_twoTierRun;
+        delete s_rayTraceEstimator;
+        delete s_resultCache;
+        delete s_efficiencyMap;
+        delete s_scanManager;
+        delete s_runManager;
+    }
+    catch (const std::exception& error)
+    {
+        s_runManager = nullptr;
+        s_finalized = true;
+        return Fail(error.what());
+    }
+    s_threadPlacement = nullptr;
+    s_twoTierRun = nullptr;
+    s_rayTraceEstimator = nullptr;
+    s_resultCache = nullptr;
+    s_efficiencyMap = nullptr;
+    s_scanManager = nullptr;
+    s_runManager = nullptr;
+    s_actionInitialization = nullptr;
+    s_finalized = true;
+    return 0;
+}
+
+
+const char* g4hpge_last_error()
+{
+    return s_lastError.c_str();
+}
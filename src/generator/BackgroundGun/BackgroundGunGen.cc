@@ -0,0 +1,282 @@
+/// \file BackgroundGunGen.cc
+/// \brief Implementation of the BackgroundGunGen class
+
+#include "generator/BackgroundGun/BackgroundGunGen.hh"
+
+#include "DetectorConstruction.hh"
+
+#include "G4Event.hh"
+#include "G4ParticleGun.hh"
+#include "G4Gamma.hh"
+#include "G4MuonPlus.hh"
+#include "G4MuonMinus.hh"
+#include "G4RandomDirection.hh"
+#include "G4RunManager.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+#include "Randomize.hh"
+
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+
+#include "G4UIcmdWith3Vector.hh"
+#include "G4UIcmdWith3VectorAndUnit.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithAString.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#include <memory>
+using std::make_shared;
+
+#include <stdexcept>
+using std::runtime_error;
+
+namespace
+{
+    // mu+/mu- at sea level
+    const G4double muonChargeRatio = 1.27;
+}
+
+std::atomic<G4long> BackgroundGunGen::s_events{0};
+std::atomic<G4double> BackgroundGunGen::s_rate{0};
+
+BackgroundGunGen::BackgroundGunGen(const G4String& commandDir)
+    : G4VUserPrimaryGeneratorAction(),
+      G4UImessenger(),
+      m_muonEnergy(4*GeV),
+      m_intensity(70/(m2*s)),
+      m_gammaEnergy(1460.8*keV),
+      m_flux(1/(cm2*s)),
+      m_up(0, 1, 0)
+{
+    m_sourceCmd = make_shared<G4UIcmdWithAString>((commandDir + "source").c_str(), this);
+    m_sourceCmd->SetGuidance("Select the background: cosmic-ray muons or gammas from the walls.");
+    m_sourceCmd->SetParameterName("source", false);
+    m_sourceCmd->SetCandidates("muon gamma");
+
+    m_muonEnergyCmd = make_shared<G4UIcmdWithADoubleAndUnit>((commandDir + "muonEnergy").c_str(), this);
+    m_muonEnergyCmd->SetGuidance("Set the energy of the muons (default 4 GeV).");
+    m_muonEnergyCmd->SetParameterName("energy", false);
+    m_muonEnergyCmd->SetRange("energy > 0");
+    m_muonEnergyCmd->SetUnitCategory("Energy");
+
+    m_intensityCmd = make_shared<G4UIcmdWithADouble>((commandDir + "intensity").c_str(), this);
+    m_intensityCmd->SetGuidance("Set the vertical intensity of the muons in 1/(m^2 s sr) (default 70).");
+    m_intensityCmd->SetParameterName("intensity", false);
+    m_intensityCmd->SetRange("intensity > 0");
+
+    m_gammaEnergyCmd = make_shared<G4UIcmdWithADoubleAndUnit>((commandDir + "gammaEnergy").c_str(), this);
+    m_gammaEnergyCmd->SetGuidance("Set the energy of the wall gammas (default 1460.8 keV).");
+    m_gammaEnergyCmd->SetParameterName("energy", false);
+    m_gammaEnergyCmd->SetRange("energy > 0");
+    m_gammaEnergyCmd->SetUnitCategory("Energy");
+
+    m_fluxCmd = make_shared<G4UIcmdWithADouble>((commandDir + "flux").c_str(), this);
+    m_fluxCmd->SetGuidance("Set the omnidirectional flux of the wall gammas in 1/(cm^2 s) (default 1).");
+    m_fluxCmd->SetParameterName("flux", false);
+    m_fluxCmd->SetRange("flux > 0");
+
+    m_upCmd = make_shared<G4UIcmdWith3Vector>((commandDir + "up").c_str(), this);
+    m_upCmd->SetGuidance("Set the vertical direction (default 0 1 0), the muons come from there.");
+    m_upCmd->SetParameterName("x", "y", "z", false);
+
+    m_radiusCmd = make_shared<G4UIcmdWithADoubleAndUnit>((commandDir + "radius").c_str(), this);
+    m_radiusCmd->SetGuidance("Set the radius of the envelope (0: around everything in the world).");
+    m_radiusCmd->SetParameterName("radius", false);
+    m_radiusCmd->SetRange("radius >= 0");
+    m_radiusCmd->SetUnitCategory("Length");
+
+    m_centerCmd = make_shared<G4UIcmdWith3VectorAndUnit>((commandDir + "center").c_str(), this);
+    m_centerCmd->SetGuidance("Set the center of the envelope, used with a radius.");
+    m_centerCmd->SetParameterName("x", "y", "z", false);
+    m_centerCmd->SetUnitCategory("Length");
+}
+
+BackgroundGunGen::~BackgroundGunGen()
+{
+    delete fParticleGun;
+}
+
+void BackgroundGunGen::UpdateEnvelope()
+{
+    const auto detectorConstruction
+        = static_cast<const DetectorConstruction*>(G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    if (m_geometryVersion == detectorConstruction->GetGeometryVersion())
+    {
+        return;
+    }
+    m_geometryVersion = detectorConstruction->GetGeometryVersion();
+
+    const G4LogicalVolume* world = detectorConstruction->GetWorldVolume()->GetLogicalVolume();
+    if (m_radius > 0)
+    {
+        m_envelopeCenter = m_center;
+        m_envelopeRadius = m_radius;
+    }
+    else
+    {
+        // bounding box of the daughters of the world
+        G4ThreeVector lower(kInfinity, kInfinity, kInfinity);
+        G4ThreeVector upper(-kInfinity, -kInfinity, -kInfinity);
+        for (size_t i = 0; i < world->GetNoDaughters(); i++)
+        {
+            const G4VPhysicalVolume* daughter = world->GetDaughter(i);
+            G4ThreeVector pMin, pMax;
+            daughter->GetLogicalVolume()->GetSolid()->BoundingLimits(pMin, pMax);
+            for (int corner = 0; corner < 8; corner++)
+            {
+                G4ThreeVector point((corner & 1) ? pMax.x() : pMin.x(),
+                                    (corner & 2) ? pMax.y() : pMin.y(),
+                                    (corner & 4) ? pMax.z() : pMin.z());
+                point = daughter->GetObjectRotationValue()*point + daughter->GetObjectTranslation();
+                for (int k = 0; k < 3; k++)
+                {
+                    lower[k] = std::min(lower[k], point[k]);
+                    upper[k] = std::max(upper[k], point[k]);
+                }
+            }
+        }
+        if (world->GetNoDaughters() == 0)
+        {
+            throw runtime_error("BackgroundGunGen: there is nothing in the world");
+        }
+        m_envelopeCenter = 0.5*(lower + upper);
+        m_envelopeRadius = 0.5*(upper - lower).mag();
+    }
+
+    // the particles start up to sqrt(2) R from the center
+    G4ThreeVector worldMin, worldMax;
+    world->GetSolid()->BoundingLimits(worldMin, worldMax);
+    const G4double reach = std::sqrt(2.)*m_envelopeRadius;
+    for (int k = 0; k < 3; k++)
+    {
+        if (m_envelopeCenter[k] - reach < worldMin[k] || m_envelopeCenter[k] + reach > worldMax[k])
+        {
+            throw runtime_error("BackgroundGunGen: the envelope does not fit into the world");
+        }
+    }
+}
+
+G4double BackgroundGunGen::GetRate() const
+{
+    const G4double area = pi*m_envelopeRadius*m_envelopeRadius;
+    if (m_source == sourceMuon)
+    {
+        // integral of cos^2(theta) over the upper hemisphere
+        return m_intensity*(2*pi/3)*area;
+    }
+    return m_flux*area;
+}
+
+void BackgroundGunGen::GeneratePrimaries(G4Event* anEvent)
+{
+    if (!fParticleGun)
+    {
+        fParticleGun = new G4ParticleGun(1);
+    }
+
+    UpdateEnvelope();
+
+    G4ThreeVector direction;
+    if (m_source == sourceMuon)
+    {
+        // zenith angle from cos^2(theta) per solid angle: cos(theta) = u^(1/3)
+        const G4double cosTheta = std::cbrt(G4UniformRand());
+        const G4double sinTheta = std::sqrt(1 - cosTheta*cosTheta);
+        const G4double phi = twopi*G4UniformRand();
+        const G4ThreeVector e1 = m_up.orthogonal().unit();
+        const G4ThreeVector e2 = m_up.cross(e1);
+        direction = -(cosTheta*m_up + sinTheta*(std::cos(phi)*e1 + std::sin(phi)*e2));
+
+        const G4bool positive = G4UniformRand() < muonChargeRatio/(1 + muonChargeRatio);
+        fParticleGun->SetParticleDefinition(positive ? static_cast<G4ParticleDefinition*>(G4MuonPlus::Definition())
+                                                     : static_cast<G4ParticleDefinition*>(G4MuonMinus::Definition()));
+        fParticleGun->SetParticleEnergy(m_muonEnergy);
+    }
+    else
+    {
+        direction = G4RandomDirection();
+        fParticleGun->SetParticleDefinition(G4Gamma::Definition());
+        fParticleGun->SetParticleEnergy(m_gammaEnergy);
+    }
+
+    // uniform on the disk of the envelope perpendicular to the direction
+    const G4ThreeVector a = direction.orthogonal().unit();
+    const G4ThreeVector b = direction.cross(a);
+    const G4double r = m_envelopeRadius*std::sqrt(G4UniformRand());
+    const G4double psi = twopi*G4UniformRand();
+    fParticleGun->SetParticlePosition(m_envelopeCenter - m_envelopeRadius*direction
+                                      + r*(std::cos(psi)*a + std::sin(psi)*b));
+    fParticleGun->SetParticleMomentumDirection(direction);
+    fParticleGun->GeneratePrimaryVertex(anEvent);
+
+    s_rate = GetRate();
+    s_events++;
+}
+
+void BackgroundGunGen::BeginOfRun()
+{
+    s_events = 0;
+}
+
+void BackgroundGunGen::EndOfRun()
+{
+    const G4long events = s_events;
+    const G4double rate = s_rate;
+    if (events > 0 && rate > 0)
+    {
+        G4cout << "BackgroundGun: " << events << " events at " << rate*s
+               << " per second through the envelope, a live time of " << events/rate/s << " s" << G4endl;
+    }
+}
+
+void BackgroundGunGen::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_sourceCmd.get())
+    {
+        m_source = (newValue == "gamma") ? sourceGamma : sourceMuon;
+    }
+    else if (command == m_muonEnergyCmd.get())
+    {
+        m_muonEnergy = m_muonEnergyCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_intensityCmd.get())
+    {
+        m_intensity = m_intensityCmd->GetNewDoubleValue(newValue)/(m2*s);
+    }
+    else if (command == m_gammaEnergyCmd.get())
+    {
+        m_gammaEnergy = m_gammaEnergyCmd->GetNewDoubleValue(newValue);
+    }
+    else if (command == m_fluxCmd.get())
+    {
+        m_flux = m_fluxCmd->GetNewDoubleValue(newValue)/(cm2*s);
+    }
+    else if (command == m_upCmd.get())
+    {
+        const G4ThreeVector up = m_upCmd->GetNew3VectorValue(newValue);
+        if (up.mag2() <= 0)
+        {
+            throw runtime_error("BackgroundGunGen: the vertical direction must not be zero");
+        }
+        m_up = up.unit();
+    }
+    else if (command == m_radiusCmd.get())
+    {
+        m_radius = m_radiusCmd->GetNewDoubleValue(newValue);
+        m_geometryVersion = -1;
+    }
+    else if (command == m_centerCmd.get())
+    {
+        m_center = m_centerCmd->GetNew3VectorValue(newValue);
+        m_geometryVersion = -1;
+    }
+    else
+    {
+        throw runtime_error("Unknown command in BackgroundGunGen::SetNewValue()");
+    }
+}
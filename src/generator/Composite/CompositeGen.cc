@@ -0,0 +1,193 @@
+/// \file CompositeGen.cc
+/// \brief Implementation of the CompositeGen class
+
+#include "generator/Composite/CompositeGen.hh"
+
+#include "generator/IsotropicGun/IsotropicGunGen.hh"
+#include "generator/PrimaryGun/PrimaryGunGen.hh"
+#include "generator/GammaDecayScheme/GammaDecaySchemeGen.hh"
+#include "generator/PositronGun/PositronGunGen.hh"
+#include "generator/NuclideGun/NuclideGunGen.hh"
+#include "generator/EventFileGun/EventFileGunGen.hh"
+
+#include "G4Event.hh"
+#include "G4UImanager.hh"
+#include "Randomize.hh"
+
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+#include <algorithm>
+#include <sstream>
+
+#include <memory>
+using std::make_shared;
+
+#include <stdexcept>
+using std::runtime_error;
+
+CompositeGen::CompositeGen()
+    : G4VUserPrimaryGeneratorAction(),
+      G4UImessenger()
+{
+    m_addCmd = make_shared<G4UIcmdWithAString>("/PrimaryGenerator/Composite/add", this);
+    m_addCmd->SetGuidance("Add a component \"name generator weight\", e.g. \"13C GammaDecayScheme 1\".");
+    m_addCmd->SetGuidance("Its commands are /PrimaryGenerator/Composite/<name>/..., see set.");
+    m_addCmd->SetParameterName("component", false);
+
+    m_setCmd = make_shared<G4UIcmdWithAString>("/PrimaryGenerator/Composite/set", this);
+    m_setCmd->SetGuidance("Apply a command to a component, \"name command parameters\",");
+    m_setCmd->SetGuidance("e.g. \"13C levelFile data/13N.txt\".");
+    m_setCmd->SetParameterName("command", false);
+
+    m_clearCmd = make_shared<G4UIcmdWithoutParameter>("/PrimaryGenerator/Composite/clear", this);
+    m_clearCmd->SetGuidance("Remove all components.");
+}
+
+CompositeGen::~CompositeGen()
+{}
+
+void CompositeGen::GeneratePrimaries(G4Event* anEvent)
+{
+    if (m_components.empty())
+    {
+        throw runtime_error("CompositeGen: no components (/PrimaryGenerator/Composite/add).");
+    }
+
+    const G4double random = G4UniformRand()*m_cumulativeWeights.back();
+    const size_t component = std::min<size_t>(
+        std::upper_bound(m_cumulativeWeights.begin(), m_cumulativeWeights.end(), random) - m_cumulativeWeights.begin(),
+        m_components.size() - 1);
+
+    m_components[component].generator->GeneratePrimaries(anEvent);
+    anEvent->SetUserInformation(new CompositeEventInformation(component, m_components[component].name));
+}
+
+void CompositeGen::GetGammaLines(vector<G4double>& lines) const
+{
+    lines.clear();
+    vector<G4double> componentLines;
+    for (const auto& component : m_components)
+    {
+        componentLines.clear();
+        if (component.type == "IsotropicGun")
+        {
+            static_cast<const IsotropicGunGen*>(component.generator.get())->GetGammaLines(componentLines);
+        }
+        else if (component.type == "GammaDecayScheme")
+        {
+            static_cast<const GammaDecaySchemeGen*>(component.generator.get())->GetGammaLines(componentLines);
+        }
+        else
+        {
+            continue;
+        }
+        lines.insert(lines.end(), componentLines.begin(), componentLines.end());
+    }
+    std::sort(lines.begin(), lines.end());
+    lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+}
+
+void CompositeGen::Add(const G4String& name, const G4String& type, const G4double weight)
+{
+    for (const auto& component : m_components)
+    {
+        if (component.name == name)
+        {
+            throw runtime_error("CompositeGen: there is already a component " + name);
+        }
+    }
+    if (!(weight > 0))
+    {
+        throw runtime_error("CompositeGen: the weight of " + name + " must be positive");
+    }
+
+    const G4String commandDir = "/PrimaryGenerator/Composite/" + name + "/";
+    Component component = {name, type, weight, nullptr};
+    if (type == "IsotropicGun")
+    {
+        component.generator = make_shared<IsotropicGunGen>(commandDir);
+    }
+    else if (type == "GammaDecayScheme")
+    {
+        component.generator = make_shared<GammaDecaySchemeGen>(commandDir);
+    }
+    else if (type == "PositronGun")
+    {
+        component.generator = make_shared<PositronGunGen>(commandDir);
+    }
+    else if (type == "NuclideGun")
+    {
+        component.generator = make_shared<NuclideGunGen>(commandDir);
+    }
+    else if (type == "PrimaryGun")
+    {
+        component.generator = make_shared<PrimaryGunGen>(commandDir);
+    }
+    else if (type == "EventFileGun")
+    {
+        component.generator = make_shared<EventFileGunGen>(commandDir);
+    }
+    else
+    {
+        throw runtime_error("CompositeGen: unknown generator " + type + " for component " + name);
+    }
+
+    m_components.push_back(component);
+    m_cumulativeWeights.push_back((m_cumulativeWeights.empty() ? 0 : m_cumulativeWeights.back()) + weight);
+}
+
+void CompositeGen::Set(const G4String& name, const G4String& command)
+{
+    for (const auto& component : m_components)
+    {
+        if (component.name == name)
+        {
+            // the component commands exist in this thread
+            const G4String fullCommand = "/PrimaryGenerator/Composite/" + name + "/" + command;
+            if (G4UImanager::GetUIpointer()->ApplyCommand(fullCommand) != 0)
+            {
+                throw runtime_error("CompositeGen: " + fullCommand + " failed");
+            }
+            return;
+        }
+    }
+    throw runtime_error("CompositeGen: there is no component " + name);
+}
+
+void CompositeGen::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_addCmd.get())
+    {
+        std::istringstream input(newValue);
+        G4String name, type;
+        G4double weight;
+        if (!(input >> name >> type >> weight))
+        {
+            throw runtime_error("CompositeGen: expected \"name generator weight\", got '" + newValue + "'");
+        }
+        Add(name, type, weight);
+    }
+    else if (command == m_setCmd.get())
+    {
+        std::istringstream input(newValue);
+        G4String name;
+        input >> name;
+        std::string componentCommand;
+        std::getline(input >> std::ws, componentCommand);
+        if (name.empty() || componentCommand.empty())
+        {
+            throw runtime_error("CompositeGen: expected \"name command parameters\", got '" + newValue + "'");
+        }
+        Set(name, componentCommand);
+    }
+    else if (command == m_clearCmd.get())
+    {
+        m_components.clear();
+        m_cumulativeWeights.clear();
+    }
+    else
+    {
+        throw runtime_error("Unknown command in CompositeGen::SetNewValue()");
+    }
+}
@@ -0,0 +1,222 @@
+/// \file EventFileGunGen.cc
+/// \brief Implementation of the EventFileGunGen class
+
+#include "generator/EventFileGun/EventFileGunGen.hh"
+
+#include "RunSharding.hh"
+
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4ParticleTable.hh"
+#include "G4IonTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWith3VectorAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithABool.hh"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <memory>
+using std::make_shared;
+
+#include <stdexcept>
+using std::runtime_error;
+
+EventFileGunGen::EventFileGunGen(const G4String& commandDir)
+    : G4VUserPrimaryGeneratorAction(),
+      G4UImessenger(),
+      m_offset(0, 0, 0)
+{
+    m_fileCmd = make_shared<G4UIcmdWithAString>((commandDir + "file").c_str(), this);
+    m_fileCmd->SetGuidance("Select the binary event file (written by G4_HPGe_convert).");
+    m_fileCmd->SetParameterName("fileName", false);
+
+    m_offsetCmd = make_shared<G4UIcmdWith3VectorAndUnit>((commandDir + "offset").c_str(), this);
+    m_offsetCmd->SetGuidance("Shift all vertices of the file by this vector.");
+    m_offsetCmd->SetParameterName("x", "y", "z", false);
+    m_offsetCmd->SetUnitCategory("Length");
+
+    m_reuseCmd = make_shared<G4UIcmdWithAnInteger>((commandDir + "reuse").c_str(), this);
+    m_reuseCmd->SetGuidance("Use every event N times, with the weights divided by N.");
+    m_reuseCmd->SetParameterName("N", false);
+    m_reuseCmd->SetRange("N >= 1");
+
+    m_rotateCmd = make_shared<G4UIcmdWithABool>((commandDir + "rotate").c_str(), this);
+    m_rotateCmd->SetGuidance("Rotate every use of an event by a random angle around the z axis.");
+    m_rotateCmd->SetParameterName("rotate", false);
+}
+
+EventFileGunGen::~EventFileGunGen()
+{
+    Close();
+}
+
+void EventFileGunGen::GeneratePrimaries(G4Event* anEvent)
+{
+    if (!m_map)
+    {
+        throw runtime_error("EventFileGunGen: no event file selected (/PrimaryGenerator/EventFileGun/file).");
+    }
+
+    // the share of this shard, the event ID selects the record in it
+    const uint64_t nShards = RunSharding::GetNumberOfShards();
+    const uint64_t shard = RunSharding::GetCurrentShard();
+    const uint64_t firstEvent = m_nEvents*shard/nShards;
+    const uint64_t shareSize = m_nEvents*(shard + 1)/nShards - firstEvent;
+    if (shareSize == 0)
+    {
+        throw runtime_error("EventFileGunGen: " + m_fileName + " has fewer events than shards.");
+    }
+
+    const uint64_t record = static_cast<uint64_t>(anEvent->GetEventID())/m_reuse;
+    if (record == shareSize && anEvent->GetEventID() % m_reuse == 0)
+    {
+        G4cerr << "EventFileGun: all " << shareSize << " events of this shard were used, starting over." << G4endl;
+    }
+    const uint64_t event = firstEvent + record % shareSize;
+
+    const G4double angle = m_rotate ? CLHEP::twopi*G4UniformRand() : 0;
+    for (uint64_t i = m_firstPrimary[event]; i < m_firstPrimary[event+1]; i++)
+    {
+        const EventFilePrimary& primary = m_primaries[i];
+
+        G4ThreeVector position = G4ThreeVector(primary.x, primary.y, primary.z)*mm;
+        G4ThreeVector direction = G4ThreeVector(primary.dx, primary.dy, primary.dz).unit();
+        if (m_rotate)
+        {
+            position.rotateZ(angle);
+            direction.rotateZ(angle);
+        }
+
+        auto vertex = new G4PrimaryVertex(position + m_offset, primary.time*ns);
+        auto particle = new G4PrimaryParticle(GetDefinition(primary.pdg));
+        particle->SetKineticEnergy(primary.energy*MeV);
+        particle->SetMomentumDirection(direction);
+        particle->SetWeight(primary.weight/m_reuse);
+
+        vertex->SetPrimary(particle);
+        anEvent->AddPrimaryVertex(vertex);
+    }
+}
+
+G4ParticleDefinition* EventFileGunGen::GetDefinition(const int32_t pdg)
+{
+    const auto cached = m_definitions.find(pdg);
+    if (cached != m_definitions.end())
+    {
+        return cached->second;
+    }
+
+    G4ParticleDefinition* definition = G4ParticleTable::GetParticleTable()->FindParticle(pdg);
+    if (!definition && pdg > 1000000000)
+    {
+        definition = G4IonTable::GetIonTable()->GetIon(pdg);
+    }
+    if (!definition)
+    {
+        throw runtime_error("EventFileGunGen: unknown PDG code " + std::to_string(pdg) + " in " + m_fileName);
+    }
+
+    m_definitions[pdg] = definition;
+    return definition;
+}
+
+void EventFileGunGen::Open(const G4String& fileName)
+{
+    const int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw runtime_error("EventFileGunGen: could not open " + fileName);
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(EventFileHeader))
+    {
+        close(fd);
+        throw runtime_error("EventFileGunGen: " + fileName + " is not an event file");
+    }
+    m_mapSize = status.st_size;
+    void* map = mmap(nullptr, m_mapSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        throw runtime_error("EventFileGunGen: could not map " + fileName);
+    }
+    m_map = map;
+    m_fileName = fileName;
+    madvise(m_map, m_mapSize, MADV_SEQUENTIAL);
+
+    // everything is checked once here, the events are used as they are
+    const auto header = static_cast<const EventFileHeader*>(m_map);
+    const uint64_t indexSize = (header->nEvents + 1)*sizeof(uint64_t);
+    if (std::memcmp(header->magic, EventFile::magic, sizeof(header->magic)) != 0
+        || header->version != EventFile::version
+        || header->primarySize != sizeof(EventFilePrimary)
+        || header->nEvents == 0
+        || m_mapSize != sizeof(EventFileHeader) + indexSize + header->nPrimaries*sizeof(EventFilePrimary))
+    {
+        Close();
+        throw runtime_error("EventFileGunGen: " + fileName + " is not an event file of version 1");
+    }
+
+    m_nEvents = header->nEvents;
+    m_firstPrimary = reinterpret_cast<const uint64_t*>(static_cast<const char*>(m_map) + sizeof(EventFileHeader));
+    m_primaries = reinterpret_cast<const EventFilePrimary*>(static_cast<const char*>(m_map) + sizeof(EventFileHeader) + indexSize);
+    for (uint64_t event = 0; event < m_nEvents; event++)
+    {
+        if (m_firstPrimary[event] > m_firstPrimary[event+1])
+        {
+            Close();
+            throw runtime_error("EventFileGunGen: the event index of " + fileName + " is corrupt");
+        }
+    }
+    if (m_firstPrimary[0] != 0 || m_firstPrimary[m_nEvents] != header->nPrimaries)
+    {
+        Close();
+        throw runtime_error("EventFileGunGen: the event index of " + fileName + " is corrupt");
+    }
+}
+
+void EventFileGunGen::Close()
+{
+    if (m_map)
+    {
+        munmap(m_map, m_mapSize);
+        m_map = nullptr;
+    }
+    m_nEvents = 0;
+    m_firstPrimary = nullptr;
+    m_primaries = nullptr;
+}
+
+void EventFileGunGen::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+    if (command == m_fileCmd.get())
+    {
+        Close();
+        Open(newValue);
+    }
+    else if (command == m_offsetCmd.get())
+    {
+        m_offset = m_offsetCmd->GetNew3VectorValue(newValue);
+    }
+    else if (command == m_reuseCmd.get())
+    {
+        m_reuse = m_reuseCmd->GetNewIntValue(newValue);
+    }
+    else if (command == m_rotateCmd.get())
+    {
+        m_rotate = m_rotateCmd->GetNewBoolValue(newValue);
+    }
+    else
+    {
+        throw runtime_error("Unknown command in EventFileGunGen::SetNewValue()");
+    }
+}
@@ -5,7 +5,8 @@
 #include "G4Gamma.hh"
 #include "G4PrimaryParticle.hh"
 #include "G4PrimaryVertex.hh"
-#include "G4RandomDirection.hh"
+#include "EmissionBias.hh"
+#include "Randomize.hh"
 
 #include "G4UIcmdWith3VectorAndUnit.hh"
 #include "G4UIcmdWithAString.hh"
@@ -38,23 +39,21 @@ using std::make_shared;
 using std::runtime_error;
 
 
-GammaDecaySchemeGen::GammaDecaySchemeGen() : G4VUserPrimaryGeneratorAction(), G4UImessenger(), m_position(0, 0, 0)
+GammaDecaySchemeGen::GammaDecaySchemeGen(const G4String& commandDir) : G4VUserPrimaryGeneratorAction(), G4UImessenger(), m_position(0, 0, 0)
 {
-    m_setPositionCmd = make_shared<G4UIcmdWith3VectorAndUnit>("/PrimaryGenerator/GammaDecayScheme/position", this);
+    m_setPositionCmd = make_shared<G4UIcmdWith3VectorAndUnit>((commandDir + "position").c_str(), this);
     m_setPositionCmd->SetGuidance("Set position of primary vertex.");
     m_setPositionCmd->SetParameterName("x", "y", "z", false);
     m_setPositionCmd->SetUnitCategory("Length");
 
-    m_setInputFileNameCmd = make_shared<G4UIcmdWithAString>("/PrimaryGenerator/GammaDecayScheme/levelFile", this);
+    m_setInputFileNameCmd = make_shared<G4UIcmdWithAString>((commandDir + "levelFile").c_str(), this);
     m_setInputFileNameCmd->SetGuidance("Set the name of the input file with the decay levels.");
     m_setInputFileNameCmd->SetParameterName("file name", false);
 
-    m_selectExcitedStateCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/PrimaryGenerator/GammaDecayScheme/excitedState", this);
+    m_selectExcitedStateCmd = make_shared<G4UIcmdWithADoubleAndUnit>((commandDir + "excitedState").c_str(), this);
     m_selectExcitedStateCmd->SetGuidance("Select the entry level of the scheme.");
     m_selectExcitedStateCmd->SetParameterName("energy", false);
     m_selectExcitedStateCmd->SetUnitCategory("Energy");
-
-    rand = new TRandom( );
 }
 
 
@@ -62,8 +61,8 @@ void GammaDecaySchemeGen::GeneratePrimaries(G4Event* anEvent)
 {
 
     // Sampling the beamspot
-    theta = rand->Rndm( )*M_PI;
-    offset = rand->Rndm( )*beam_sigma - beam_sigma/2;
+    theta = G4UniformRand( )*M_PI;
+    offset = G4UniformRand( )*beam_sigma - beam_sigma/2;
     offsetX = offset*std::cos( theta ) * mm;
     offsetY = offset*std::sin( theta ) * mm;
 
@@ -73,20 +72,33 @@ void GammaDecaySchemeGen::GeneratePrimaries(G4Event* anEvent)
     
     auto *primaryVertex = new G4PrimaryVertex( m_position_rand, 0 ); // t = 0.0
 
+    // the gammas are independent, with biased emission the event has the
+    // product of their weights
+    G4double weight = 1;
     m_levels->Start();
     while (!m_levels->IsAtEndState())
     {
         auto *primaryParticle = new G4PrimaryParticle(G4Gamma::GammaDefinition());
 
-        primaryParticle->SetMomentumDirection(G4RandomDirection());
+        primaryParticle->SetMomentumDirection(EmissionBias::SampleDirection(weight));
         primaryParticle->SetKineticEnergy(m_levels->Decay());
 
         primaryVertex->SetPrimary(primaryParticle);
     }
+    primaryVertex->SetWeight(weight);
 
     anEvent->AddPrimaryVertex(primaryVertex);
 }
 
+void GammaDecaySchemeGen::GetGammaLines(vector<G4double>& lines) const
+{
+    lines.clear();
+    if (m_levels)
+    {
+        m_levels->GetTransitionEnergies(lines);
+    }
+}
+
 void GammaDecaySchemeGen::SetNewValue(G4UIcommand* command, G4String newValue)
 {
     if (command == m_setPositionCmd.get())
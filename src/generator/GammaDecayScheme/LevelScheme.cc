@@ -4,6 +4,7 @@
 
 using CLHEP::keV;
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -191,6 +192,35 @@ G4double LevelScheme::Decay()
 }
 
 
+void LevelScheme::GetTransitionEnergies(vector<G4double> &energies) const
+{
+    energies.clear();
+    if (startLevel)
+    {
+        AddTransitionEnergies(startLevel->GetEnergy(), energies);
+    }
+}
+
+void LevelScheme::AddTransitionEnergies(G4double energy, vector<G4double> &energies) const
+{
+    const auto level = levels.at(energy);
+    if (level->IsEndState())
+    {
+        return;
+    }
+
+    for (G4int i = 0; i < level->GetNumberOfDaughters(); i++)
+    {
+        const G4double daughterEnergy = level->GetDaughterEnergy(i);
+        const G4double transition = energy - daughterEnergy;
+        if (std::find(energies.begin(), energies.end(), transition) == energies.end())
+        {
+            energies.push_back(transition);
+        }
+        AddTransitionEnergies(daughterEnergy, energies);
+    }
+}
+
 void LevelScheme::CheckConsistency(G4double startEnergy)
 {
     const auto it = levels.find(startEnergy);
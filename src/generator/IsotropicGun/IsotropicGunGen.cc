@@ -6,13 +6,24 @@
 #include "G4Event.hh"
 #include "G4ParticleGun.hh"
 #include "G4Gamma.hh"
+#include "G4ParticleTable.hh"
 #include "G4SystemOfUnits.hh"
-#include "G4RandomDirection.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4Navigator.hh"
+#include "G4TransportationManager.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4Material.hh"
+#include "Randomize.hh"
+
+#include "EmissionBias.hh"
 
 #include "G4UIcmdWith3VectorAndUnit.hh"
 #include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithAString.hh"
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <fstream>
@@ -31,47 +42,126 @@ using std::make_shared;
 #include <stdexcept>
 using std::runtime_error;
 
-IsotropicGunGen::IsotropicGunGen()
+IsotropicGunGen::IsotropicGunGen(const G4String& commandDir)
     : G4VUserPrimaryGeneratorAction(),
       G4UImessenger(), 
       fParticleGun(nullptr), 
       m_position(0, 0, 0)
 {
-    m_setPositionCmd = make_shared<G4UIcmdWith3VectorAndUnit>("/PrimaryGenerator/IsotropicGun/position", this);
+    m_setPositionCmd = make_shared<G4UIcmdWith3VectorAndUnit>((commandDir + "position").c_str(), this);
     m_setPositionCmd->SetGuidance("Set position of primary vertex.");
     m_setPositionCmd->SetParameterName("x", "y", "z", false);
     m_setPositionCmd->SetUnitCategory("Length");
 
-    m_selectEnergyCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/PrimaryGenerator/IsotropicGun/energy", this);
+    m_selectEnergyCmd = make_shared<G4UIcmdWithADoubleAndUnit>((commandDir + "energy").c_str(), this);
     m_selectEnergyCmd->SetGuidance("Select the energy of the gamma.");
     m_selectEnergyCmd->SetParameterName("energy", false);
     m_selectEnergyCmd->SetUnitCategory("Energy");
 
-    m_selectNParticlesCmd = make_shared<G4UIcmdWithADouble>("/PrimaryGenerator/IsotropicGun/number", this);
+    m_selectNParticlesCmd = make_shared<G4UIcmdWithADouble>((commandDir + "number").c_str(), this);
     m_selectNParticlesCmd->SetGuidance("Select the number of the gammas.");
     m_selectNParticlesCmd->SetParameterName("N", false);
-    
+
+    m_selectParticleCmd = make_shared<G4UIcmdWithAString>((commandDir + "particle").c_str(), this);
+    m_selectParticleCmd->SetGuidance("Select the particle (gamma by default).");
+    m_selectParticleCmd->SetParameterName("particle", false);
+
+    m_confineCmd = make_shared<G4UIcmdWithAString>((commandDir + "confine").c_str(), this);
+    m_confineCmd->SetGuidance("Emit uniformly in the mass of a geometry object within position +- halfSize,");
+    m_confineCmd->SetGuidance("\"none\" emits from the position (default).");
+    m_confineCmd->SetParameterName("object", false);
+
+    m_halfSizeCmd = make_shared<G4UIcmdWith3VectorAndUnit>((commandDir + "halfSize").c_str(), this);
+    m_halfSizeCmd->SetGuidance("Half size of the box around the position that contains the confining object.");
+    m_halfSizeCmd->SetParameterName("x", "y", "z", false);
+    m_halfSizeCmd->SetUnitCategory("Length");
 }
 
 IsotropicGunGen::~IsotropicGunGen()
 {
     delete fParticleGun;
+    delete m_navigator;
+}
+
+G4ThreeVector IsotropicGunGen::SampleConfinedPosition()
+{
+    // the volumes of an object are named "<object>_..._logical"
+    // (looked up every time, the geometry may have been rebuilt)
+    const G4String prefix = m_confine + "_";
+    G4double maxDensity = 0;
+    for (const G4LogicalVolume* logical : *G4LogicalVolumeStore::GetInstance())
+    {
+        if (logical->GetName().compare(0, prefix.size(), prefix) == 0)
+        {
+            maxDensity = std::max(maxDensity, logical->GetMaterial()->GetDensity());
+        }
+    }
+    if (maxDensity <= 0)
+    {
+        throw runtime_error("IsotropicGunGen: no volumes of '" + m_confine + "'");
+    }
+    if (!m_navigator)
+    {
+        m_navigator = new G4Navigator();
+    }
+    m_navigator->SetWorldVolume(G4TransportationManager::GetTransportationManager()
+                                ->GetNavigatorForTracking()->GetWorldVolume());
+
+    // uniform in the box, accepted in proportion to the density
+    const G4int maxAttempts = 1000000;
+    for (G4int attempt = 0; attempt < maxAttempts; attempt++)
+    {
+        const G4ThreeVector position = m_position + G4ThreeVector((2*G4UniformRand() - 1)*m_halfSize.x(),
+                                                                  (2*G4UniformRand() - 1)*m_halfSize.y(),
+                                                                  (2*G4UniformRand() - 1)*m_halfSize.z());
+        const G4VPhysicalVolume* physical = m_navigator->LocateGlobalPointAndSetup(position, nullptr, false, true);
+        if (!physical)
+        {
+            continue;
+        }
+        const G4LogicalVolume* logical = physical->GetLogicalVolume();
+        if (logical->GetName().compare(0, prefix.size(), prefix) == 0
+            && G4UniformRand()*maxDensity < logical->GetMaterial()->GetDensity())
+        {
+            return position;
+        }
+    }
+    throw runtime_error("IsotropicGunGen: the box around the position misses '" + m_confine + "'");
 }
 
 void IsotropicGunGen::GeneratePrimaries(G4Event* anEvent)
 {
     // This function is called at the begining of event
 
-    fParticleGun->SetParticleDefinition(G4Gamma::Gamma());
+    if (!fParticleGun)
+    {
+        fParticleGun = new G4ParticleGun(m_number);
+    }
+
+    fParticleGun->SetParticleDefinition(m_particle ? m_particle : G4Gamma::Gamma());
 
     fParticleGun->SetParticleEnergy(m_energy*CLHEP::MeV);
-    fParticleGun->SetParticlePosition(m_position);
+    fParticleGun->SetParticlePosition(m_confine.empty() ? m_position : SampleConfinedPosition());
 
-    // Set gun direction randomly
-    fParticleGun->SetParticleMomentumDirection(G4RandomDirection());
+    // Set gun direction randomly (towards the detector if biased)
+    G4double weight = 1;
+    fParticleGun->SetParticleMomentumDirection(EmissionBias::SampleDirection(weight));
 
     // Generate the vertex (position + particle) for the event
     fParticleGun->GeneratePrimaryVertex(anEvent);
+    if (weight != 1)
+    {
+        anEvent->GetPrimaryVertex(anEvent->GetNumberOfPrimaryVertex() - 1)->SetWeight(weight);
+    }
+}
+
+void IsotropicGunGen::GetGammaLines(vector<G4double>& lines) const
+{
+    lines.clear();
+    if ((!m_particle || m_particle == G4Gamma::Definition()) && m_energy > 0)
+    {
+        lines.push_back(m_energy);
+    }
 }
 
 void IsotropicGunGen::SetNewValue(G4UIcommand* command, G4String newValue)
@@ -87,8 +177,25 @@ void IsotropicGunGen::SetNewValue(G4UIcommand* command, G4String newValue)
     else if(command == m_selectNParticlesCmd.get())
     {
         m_number = m_selectNParticlesCmd->GetNewDoubleValue(newValue);
+        delete fParticleGun;
 	fParticleGun = new G4ParticleGun(m_number);
     }
+    else if(command == m_selectParticleCmd.get())
+    {
+        m_particle = G4ParticleTable::GetParticleTable()->FindParticle(newValue);
+        if (!m_particle)
+        {
+            throw runtime_error("Unknown particle '" + newValue + "' in IsotropicGunGen::SetNewValue()");
+        }
+    }
+    else if(command == m_confineCmd.get())
+    {
+        m_confine = (newValue == "none") ? "" : newValue;
+    }
+    else if(command == m_halfSizeCmd.get())
+    {
+        m_halfSize = m_halfSizeCmd->GetNew3VectorValue(newValue);
+    }
     else
     {
         throw runtime_error("Unknown command in GammaDecaySchemeGen::SetNewValue()");
@@ -39,6 +39,8 @@
 #include "G4SystemOfUnits.hh"
 #include "Randomize.hh"
 
+#include <cmath>
+
 #include "G4UIcmdWithADouble.hh"
 #include "G4UIcmdWith3VectorAndUnit.hh"
 
@@ -50,29 +52,27 @@ using std::runtime_error;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-NuclideGunGen::NuclideGunGen()
+NuclideGunGen::NuclideGunGen(const G4String& commandDir)
  : G4VUserPrimaryGeneratorAction(),
    fParticleGun(0),
    m_position(0, 0, 0)
 {
 
-  m_setPositionCmd = make_shared<G4UIcmdWith3VectorAndUnit>("/PrimaryGenerator/NuclideGun/position", this);
+  m_setPositionCmd = make_shared<G4UIcmdWith3VectorAndUnit>((commandDir + "position").c_str(), this);
   m_setPositionCmd->SetGuidance("Set position of primary vertex.");
   m_setPositionCmd->SetParameterName("x", "y", "z", false);
   m_setPositionCmd->SetUnitCategory("Length");
 
-  m_selectMassCmd = make_shared<G4UIcmdWithADouble>("/PrimaryGenerator/NuclideGun/mass", this);
+  m_selectMassCmd = make_shared<G4UIcmdWithADouble>((commandDir + "mass").c_str(), this);
   m_selectMassCmd->SetGuidance("Select the mass of the nuclide.");
-  m_selectChargeCmd = make_shared<G4UIcmdWithADouble>("/PrimaryGenerator/NuclideGun/charge", this);
+  m_selectChargeCmd = make_shared<G4UIcmdWithADouble>((commandDir + "charge").c_str(), this);
   m_selectChargeCmd->SetGuidance("Select the charge of the nuclide.");
   
   G4int n_particle = 1;
   fParticleGun  = new G4ParticleGun(n_particle);
 
   fParticleGun->SetParticleEnergy(0*eV);
-  fParticleGun->SetParticleMomentumDirection(G4ThreeVector(0.,0.,0.));   \
-
-  rand = new TRandom( );       
+  fParticleGun->SetParticleMomentumDirection(G4ThreeVector(0.,0.,0.));
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -87,8 +87,8 @@ NuclideGunGen::~NuclideGunGen()
 void NuclideGunGen::GeneratePrimaries(G4Event* anEvent)
 {
    // Sampling the beamspot
-  theta = rand->Rndm( )*M_PI;
-  offset = rand->Rndm( )*beam_sigma - beam_sigma/2;
+  theta = G4UniformRand( )*M_PI;
+  offset = G4UniformRand( )*beam_sigma - beam_sigma/2;
   offsetX = offset*std::cos( theta ) * mm;
   offsetY = offset*std::sin( theta ) * mm;
 
@@ -8,13 +8,13 @@
 #include "G4Positron.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4RandomDirection.hh"
+#include "Randomize.hh"
 
 #include "G4UIcmdWith3VectorAndUnit.hh"
 #include "G4UIcmdWithAString.hh"
 
 #include "TGraph.h"
 #include "TSpline.h"
-#include "TRandom.h"
 
 #include <memory>
 using std::make_shared;
@@ -22,27 +22,25 @@ using std::make_shared;
 #include <stdexcept>
 using std::runtime_error;
 
-PositronGunGen::PositronGunGen()
+PositronGunGen::PositronGunGen(const G4String& commandDir)
     : G4VUserPrimaryGeneratorAction(),
       G4UImessenger(),
       fParticleGun(nullptr),
       m_position(0, 0, 0)
 {
 
-    m_setPositionCmd = make_shared<G4UIcmdWith3VectorAndUnit>("/PrimaryGenerator/PositronGun/position", this);
+    m_setPositionCmd = make_shared<G4UIcmdWith3VectorAndUnit>((commandDir + "position").c_str(), this);
     m_setPositionCmd->SetGuidance("Set position of primary vertex.");
     m_setPositionCmd->SetParameterName("x", "y", "z", false);
     m_setPositionCmd->SetUnitCategory("Length");
 
-    m_setInputFileNameCmd = make_shared<G4UIcmdWithAString>("/PrimaryGenerator/PositronGun/file", this);
+    m_setInputFileNameCmd = make_shared<G4UIcmdWithAString>((commandDir + "file").c_str(), this);
     m_setInputFileNameCmd->SetGuidance("Set the name of the input file with the decay spectrum.");
     m_setInputFileNameCmd->SetParameterName("file name", false);
 
     G4int nofParticles = 1;
     fParticleGun = new G4ParticleGun(nofParticles);
 
-    rand = new TRandom( );
-    
     fParticleGun->SetParticleDefinition(G4Positron::Positron());
 
 }
@@ -60,8 +58,8 @@ void PositronGunGen::GeneratePrimaries(G4Event* anEvent)
 
     do
       {
-	  energy = rand->Rndm( )*m_energy;
-	  prob = rand->Rndm(  );
+	  energy = G4UniformRand( )*m_energy;
+	  prob = G4UniformRand(  );
       } while( prob > m_pdf->Eval( energy ) );
     
     fParticleGun->SetParticleEnergy(energy*CLHEP::MeV);
@@ -31,27 +31,27 @@ using std::make_shared;
 #include <stdexcept>
 using std::runtime_error;
 
-PrimaryGunGen::PrimaryGunGen()
+PrimaryGunGen::PrimaryGunGen(const G4String& commandDir)
     : G4VUserPrimaryGeneratorAction(),
       G4UImessenger(), 
       fParticleGun(nullptr), 
       m_position(0, 0, 0)
 {
-    m_setPositionCmd = make_shared<G4UIcmdWith3VectorAndUnit>("/PrimaryGenerator/PrimaryGun/position", this);
+    m_setPositionCmd = make_shared<G4UIcmdWith3VectorAndUnit>((commandDir + "position").c_str(), this);
     m_setPositionCmd->SetGuidance("Set position of primary vertex.");
     m_setPositionCmd->SetParameterName("x", "y", "z", false);
     m_setPositionCmd->SetUnitCategory("Length");
 
-    m_selectEnergyCmd = make_shared<G4UIcmdWithADoubleAndUnit>("/PrimaryGenerator/PrimaryGun/energy", this);
+    m_selectEnergyCmd = make_shared<G4UIcmdWithADoubleAndUnit>((commandDir + "energy").c_str(), this);
     m_selectEnergyCmd->SetGuidance("Select the energy of the gamma.");
     m_selectEnergyCmd->SetParameterName("energy", false);
     m_selectEnergyCmd->SetUnitCategory("Energy");
 
-    m_selectNParticlesCmd = make_shared<G4UIcmdWithADouble>("/PrimaryGenerator/PrimaryGun/number", this);
+    m_selectNParticlesCmd = make_shared<G4UIcmdWithADouble>((commandDir + "number").c_str(), this);
     m_selectNParticlesCmd->SetGuidance("Select the number of the gammas.");
     m_selectNParticlesCmd->SetParameterName("N", false);
 
-    m_selectAngleCmd = make_shared<G4UIcmdWithADouble>("/PrimaryGenerator/PrimaryGun/angle", this);
+    m_selectAngleCmd = make_shared<G4UIcmdWithADouble>((commandDir + "angle").c_str(), this);
     m_selectAngleCmd->SetGuidance("Select the angle of the gamma.");
     m_selectAngleCmd->SetParameterName("Theta", false);
 
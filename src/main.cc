@@ -41,9 +41,8 @@
 
 #ifdef G4MULTITHREADED
 #include "G4MTRunManager.hh"
-#else
-#include "G4RunManager.hh"
 #endif
+#include "G4RunManager.hh"
 
 #include "G4UImanager.hh"
 #include "G4PhysListFactory.hh"
@@ -53,15 +52,92 @@
 
 #include "Randomize.hh"
 #include "PhysicsList.hh"
+#include "AdjointPhysicsList.hh"
+#include "RunSharding.hh"
+#include "ScanManager.hh"
+#include "EfficiencyMap.hh"
+#include "SimulationServer.hh"
+#include "ResultCache.hh"
+#include "RayTraceEstimator.hh"
+#include "TwoTierRun.hh"
+#include "AdjointSimulation.hh"
+#include "ThreadPlacement.hh"
+#include "WorkerInitialization.hh"
+
+#include "G4StateManager.hh"
 
+#include <cstdlib>
+#include <string>
 
 
 int main(int argc,char** argv)
 {
-    // Detect interactive mode (if no arguments) and define UI session
+    // Parse options
+    //   --shards K : split the run into K independent processes
+    //   --seed S   : base seed of the random engine
+    //   --serve P  : run the jobs of local clients on the unix socket P,
+    //                after the macro (if given) set up the geometry
+    //   --adjoint  : reverse Monte Carlo (/Adjoint/), sequential
+    G4int nShards = 1;
+    G4long baseSeed = 0;
+    G4bool seedGiven = false;
+    G4String macroFileName = "";
+    G4String socketName = "";
+    G4bool adjoint = false;
+
+    for (G4int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--shards" && i+1 < argc)
+        {
+            nShards = std::atoi(argv[++i]);
+        }
+        else if (arg == "--seed" && i+1 < argc)
+        {
+            baseSeed = std::atol(argv[++i]);
+            seedGiven = true;
+        }
+        else if (arg == "--serve" && i+1 < argc)
+        {
+            socketName = argv[++i];
+        }
+        else if (arg == "--adjoint")
+        {
+            adjoint = true;
+        }
+        else
+        {
+            macroFileName = arg;
+        }
+    }
+
+    if (nShards > 1 && macroFileName == "")
+    {
+        G4cerr << "Sharded runs need a macro file." << G4endl;
+        return 1;
+    }
+    if (nShards > 1 && socketName != "")
+    {
+        G4cerr << "The server cannot be sharded." << G4endl;
+        return 1;
+    }
+    if (adjoint && (nShards > 1 || socketName != ""))
+    {
+        G4cerr << "Adjoint runs can be neither sharded nor served." << G4endl;
+        return 1;
+    }
+
+    // Fork the shards before any Geant4 state is created; only the children return
+    G4int shardIndex = 0;
+    if (nShards > 1)
+    {
+        shardIndex = RunSharding::Launch(nShards);
+    }
+
+    // Detect interactive mode (if no macro) and define UI session
     //
     G4UIExecutive* ui = nullptr;
-    if (argc == 1) // no command line parameters
+    if (macroFileName == "" && socketName == "") // no command line parameters
     {
         ui = new G4UIExecutive(argc, argv);
     }
@@ -69,27 +145,89 @@ int main(int argc,char** argv)
     // Choose the Random engine
     G4Random::setTheEngine(new CLHEP::RanecuEngine);
 
-    // Construct the default run manager
+    auto sharding = new RunSharding(nShards, shardIndex, baseSeed);
+    if (nShards > 1 || seedGiven)
+    {
+        sharding->SeedEngine();
+    }
+
+    // Construct the default run manager, the reverse Monte Carlo of
+    // Geant4 runs in one thread
     //
 #ifdef G4MULTITHREADED
-    auto runManager = new G4MTRunManager;
+    G4RunManager* runManager = adjoint ? new G4RunManager : new G4MTRunManager;
 #else
-    auto runManager = new G4RunManager;
+    G4RunManager* runManager = new G4RunManager;
 #endif
 
     // Set mandatory initialization classes
     //
     // Detector construction
-    runManager->SetUserInitialization(new DetectorConstruction());
+    auto detectorConstruction = new DetectorConstruction();
+    runManager->SetUserInitialization(detectorConstruction);
 
     // Physics list
     G4PhysListFactory	factory;
 
-    runManager->SetUserInitialization(new PhysicsList);
+    if (adjoint)
+    {
+        runManager->SetUserInitialization(new AdjointPhysicsList);
+    }
+    else
+    {
+        runManager->SetUserInitialization(new PhysicsList);
+    }
     //physicsList->SetVerboseLevel(1);
 
     // User action initialization
-    runManager->SetUserInitialization(new ActionInitialization());
+    ActionInitialization* actionInitialization = nullptr;
+    if (nShards > 1)
+    {
+        actionInitialization = new ActionInitialization(sharding->GetOutputFileName());
+    }
+    else if (socketName != "")
+    {
+        // the clients get the spectra of their jobs, nothing is written
+        actionInitialization = new ActionInitialization("");
+    }
+    else
+    {
+        actionInitialization = new ActionInitialization();
+    }
+
+    // Reverse Monte Carlo, before the user actions are built, which register with it
+    AdjointSimulation* adjointSimulation = nullptr;
+    if (adjoint)
+    {
+        adjointSimulation = new AdjointSimulation(detectorConstruction, actionInitialization->GetEnergyHistogram());
+    }
+    runManager->SetUserInitialization(actionInitialization);
+
+#ifdef G4MULTITHREADED
+    // Pin the workers as they start, before they allocate their memory
+    if (!adjoint)
+    {
+        runManager->SetUserInitialization(new WorkerInitialization);
+    }
+#endif
+
+    // Geometry scans
+    auto scanManager = new ScanManager(detectorConstruction, actionInitialization->GetEnergyHistogram());
+
+    // Efficiency maps over the source position
+    auto efficiencyMap = new EfficiencyMap(actionInitialization->GetEnergyHistogram());
+
+    // Results of earlier runs of the same configuration
+    auto resultCache = new ResultCache(actionInitialization->GetEnergyHistogram());
+
+    // Fast efficiency estimates and emission biasing
+    auto rayTraceEstimator = new RayTraceEstimator(detectorConstruction);
+
+    // Screening runs with full-fidelity replay of the events near the detector
+    auto twoTierRun = new TwoTierRun(actionInitialization->GetEnergyHistogram());
+
+    // Worker placement on the CPUs and their events per second
+    auto threadPlacement = new ThreadPlacement();
 
     // Initialize visualization
     //
@@ -103,12 +241,25 @@ int main(int argc,char** argv)
 
     // Process macro or start UI session
     //
-    if (!ui)
+    if (socketName != "")
+    {
+        // server mode: set up once, then the jobs of the clients
+        if (macroFileName != "")
+        {
+            UImanager->ApplyCommand("/control/execute " + macroFileName);
+        }
+        if (G4StateManager::GetStateManager()->GetCurrentState() == G4State_PreInit)
+        {
+            runManager->Initialize();
+        }
+        SimulationServer server(actionInitialization->GetEnergyHistogram());
+        server.Serve(socketName);
+    }
+    else if (!ui)
     {
         // command line parameters given, batch mode executing first parameter
         const G4String command = "/control/execute ";
-        const G4String fileName = argv[1];
-        UImanager->ApplyCommand(command + fileName);
+        UImanager->ApplyCommand(command + macroFileName);
     }
     else
     {
@@ -124,6 +275,14 @@ int main(int argc,char** argv)
     // owned and deleted by the run manager, so they should not be deleted
     // in the main() program !
 
+    delete threadPlacement;
+    delete twoTierRun;
+    delete rayTraceEstimator;
+    delete resultCache;
+    delete efficiencyMap;
+    delete scanManager;
+    delete adjointSimulation;
+    delete sharding;
     delete visManager;
     delete runManager;
 }
@@ -0,0 +1,361 @@
+// ============================================================================
+//
+// G4_HPGe_analyse: full-energy peak efficiencies of a set of scan outputs, in
+// place of analysis/Convert.ipynb and Analysis.ipynb.
+//
+// Reads the spectrum "h1" of every file <source>_<x>_<y>.root, folds it with
+// the detector resolution
+//
+//     sigma(E) = sqrt(a + b*E + c*E^2)      (E and sigma in keV)
+//
+// and determines for every line the net counts within line +- halfWidth,
+// minus a linear background from two side bands of the same width. The
+// efficiency is the net counts over the number of simulated events (the
+// entries of h1), with its statistical uncertainty. Outputs of two-tier runs
+// (with "screenedEvents") are read from the weighted spectrum "h1w" instead,
+// normalized to the screened events. The result is written to
+// <outputDir>/<source>_<line>keV.txt, one line "x y efficiency error" per
+// file, sorted by position, as in analysis/results.
+//
+// Usage:
+//     G4_HPGe_analyse [-j threads] [-o outputDir] [-w halfWidth] [-r a b c]
+//                     [-n] -l line [-l line ...] files...
+//
+// Lines and the half width (default 50) are in keV. -r 0 0 0 disables the
+// folding, -n the background subtraction. The files are read by all cores
+// (or -j threads) at once.
+//
+// ============================================================================
+
+#include "TFile.h"
+#include "TH1D.h"
+#include "TParameter.h"
+#include "TROOT.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::map;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+
+struct Resolution
+{
+    double a = 3.78288e-03;
+    double b = 6.57475e-04;
+    double c = 1.54547e-08;
+
+    double GetSigma(const double energy) const
+    {
+        return std::sqrt(std::max(a + b*energy + c*energy*energy, 0.0));
+    }
+};
+
+struct Point
+{
+    string source;
+    double x = 0;
+    double y = 0;
+    bool valid = false;
+    vector<double> efficiencies;
+    vector<double> errors;
+};
+
+
+static void PrintUsage()
+{
+    cerr << "Usage: G4_HPGe_analyse [-j threads] [-o outputDir] [-w halfWidth] [-r a b c]" << endl;
+    cerr << "                       [-n] -l line [-l line ...] files..." << endl;
+    cerr << "       energies in keV." << endl;
+}
+
+
+/// Splits <source>_<x>_<y>.root, the source may contain '_' itself
+static bool ParseName(const string &fileName, Point &point)
+{
+    string name = fileName.substr(fileName.find_last_of('/') + 1);
+    if (name.size() <= 5 || name.compare(name.size() - 5, 5, ".root") != 0)
+    {
+        return false;
+    }
+    name.erase(name.size() - 5);
+
+    const size_t ySeparator = name.find_last_of('_');
+    if (ySeparator == string::npos || ySeparator == 0)
+    {
+        return false;
+    }
+    const size_t xSeparator = name.find_last_of('_', ySeparator - 1);
+    if (xSeparator == string::npos || xSeparator == 0)
+    {
+        return false;
+    }
+
+    char *end;
+    const string x = name.substr(xSeparator + 1, ySeparator - xSeparator - 1);
+    const string y = name.substr(ySeparator + 1);
+    point.x = std::strtod(x.c_str(), &end);
+    if (x.empty() || *end)
+    {
+        return false;
+    }
+    point.y = std::strtod(y.c_str(), &end);
+    if (y.empty() || *end)
+    {
+        return false;
+    }
+    point.source = name.substr(0, xSeparator);
+    return true;
+}
+
+
+/// Counts of the folded spectrum within [low, high] (keV)
+static double GetCounts(const vector<double> &contents, const double Emin, const double binWidth,
+                        const Resolution &resolution, const bool fold, const double low, const double high)
+{
+    // only bins that can contribute, the first one holds the events without any deposit
+    const double margin = fold ? 8*resolution.GetSigma(high) + binWidth : binWidth;
+    const int nBins = contents.size() - 2;
+    const int first = std::max(2, static_cast<int>((low - margin - Emin)/binWidth) + 1);
+    const int last = std::min(nBins, static_cast<int>((high + margin - Emin)/binWidth) + 1);
+
+    double counts = 0;
+    for (int bin = first; bin <= last; bin++)
+    {
+        if (contents[bin] == 0)
+        {
+            continue;
+        }
+        const double energy = Emin + (bin - 0.5)*binWidth;
+        if (!fold)
+        {
+            counts += (energy >= low && energy < high) ? contents[bin] : 0;
+            continue;
+        }
+        const double sigma = std::sqrt(2.0)*resolution.GetSigma(energy);
+        counts += contents[bin]*0.5*(std::erfc((low - energy)/sigma) - std::erfc((high - energy)/sigma));
+    }
+    return counts;
+}
+
+
+static bool Analyse(const string &fileName, const vector<double> &lines, const double halfWidth,
+                    const Resolution &resolution, const bool fold, const bool background, Point &point)
+{
+    unique_ptr<TFile> file(TFile::Open(fileName.c_str(), "READ"));
+    if (!file || file->IsZombie())
+    {
+        cerr << "Could not open '" << fileName << "'." << endl;
+        return false;
+    }
+    TH1D *h1 = nullptr;
+    file->GetObject("h1", h1);
+    if (!h1)
+    {
+        cerr << "'" << fileName << "' contains no spectrum h1." << endl;
+        return false;
+    }
+
+    // the contents of h1 are biased after a two-tier run, its entries count the screened events
+    TParameter<Long64_t> *screenedEvents = nullptr;
+    file->GetObject("screenedEvents", screenedEvents);
+    TH1D *spectrum = h1;
+    if (screenedEvents)
+    {
+        TH1D *h1w = nullptr;
+        file->GetObject("h1w", h1w);
+        spectrum = h1w ? h1w : h1;
+    }
+
+    // the variances take the weights of h1w into account
+    const int nBins = spectrum->GetNbinsX();
+    vector<double> contents(nBins + 2);
+    vector<double> variances(nBins + 2);
+    for (int bin = 0; bin <= nBins + 1; bin++)
+    {
+        contents[bin] = spectrum->GetBinContent(bin);
+        variances[bin] = std::pow(spectrum->GetBinError(bin), 2);
+    }
+    // h1 is in MeV
+    const double Emin = spectrum->GetXaxis()->GetXmin()*1e3;
+    const double binWidth = spectrum->GetXaxis()->GetBinWidth(1)*1e3;
+    const double events = screenedEvents ? screenedEvents->GetVal() : h1->GetEntries();
+    if (events <= 0)
+    {
+        cerr << "'" << fileName << "' holds no events." << endl;
+        return false;
+    }
+
+    for (const double line : lines)
+    {
+        const double low = line - halfWidth;
+        const double high = line + halfWidth;
+        const double peak = GetCounts(contents, Emin, binWidth, resolution, fold, low, high);
+        const double peakVariance = GetCounts(variances, Emin, binWidth, resolution, fold, low, high);
+        double sides = 0;
+        double sidesVariance = 0;
+        if (background)
+        {
+            sides = GetCounts(contents, Emin, binWidth, resolution, fold, low - 2*halfWidth, low)
+                  + GetCounts(contents, Emin, binWidth, resolution, fold, high, high + 2*halfWidth);
+            sidesVariance = GetCounts(variances, Emin, binWidth, resolution, fold, low - 2*halfWidth, low)
+                          + GetCounts(variances, Emin, binWidth, resolution, fold, high, high + 2*halfWidth);
+        }
+        point.efficiencies.push_back((peak - 0.5*sides)/events);
+        point.errors.push_back(std::sqrt(peakVariance + 0.25*sidesVariance)/events);
+    }
+    point.valid = true;
+    return true;
+}
+
+
+int main(int argc, char **argv)
+{
+    int nThreads = std::max(1u, std::thread::hardware_concurrency());
+    string outputDir = ".";
+    double halfWidth = 50;
+    Resolution resolution;
+    bool background = true;
+    vector<double> lines;
+    vector<string> files;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const string arg = argv[i];
+        if (arg == "-j" && i+1 < argc)
+        {
+            nThreads = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-o" && i+1 < argc)
+        {
+            outputDir = argv[++i];
+        }
+        else if (arg == "-w" && i+1 < argc)
+        {
+            halfWidth = std::atof(argv[++i]);
+        }
+        else if (arg == "-r" && i+3 < argc)
+        {
+            resolution.a = std::atof(argv[++i]);
+            resolution.b = std::atof(argv[++i]);
+            resolution.c = std::atof(argv[++i]);
+        }
+        else if (arg == "-n")
+        {
+            background = false;
+        }
+        else if (arg == "-l" && i+1 < argc)
+        {
+            lines.push_back(std::atof(argv[++i]));
+        }
+        else if (arg[0] != '-')
+        {
+            files.push_back(arg);
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if (lines.empty() || files.empty() || halfWidth <= 0)
+    {
+        PrintUsage();
+        return 1;
+    }
+    const bool fold = (resolution.a != 0 || resolution.b != 0 || resolution.c != 0);
+
+    vector<Point> points(files.size());
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        if (!ParseName(files[i], points[i]))
+        {
+            cerr << "'" << files[i] << "' is not named <source>_<x>_<y>.root, skipped." << endl;
+        }
+    }
+
+    // every thread takes the next file until none is left
+    ROOT::EnableThreadSafety();
+    const auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next(0);
+    auto work = [&]()
+    {
+        size_t i;
+        while ((i = next++) < files.size())
+        {
+            if (!points[i].source.empty())
+            {
+                Analyse(files[i], lines, halfWidth, resolution, fold, background, points[i]);
+            }
+        }
+    };
+    vector<std::thread> threads;
+    for (int i = 0; i < std::min<int>(nThreads, files.size()); i++)
+    {
+        threads.emplace_back(work);
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // one file per source and line
+    map<string, vector<const Point*>> sources;
+    size_t nValid = 0;
+    for (const auto &point : points)
+    {
+        if (point.valid)
+        {
+            sources[point.source].push_back(&point);
+            nValid++;
+        }
+    }
+    for (auto &source : sources)
+    {
+        auto &sourcePoints = source.second;
+        std::sort(sourcePoints.begin(), sourcePoints.end(), [](const Point *a, const Point *b)
+        {
+            return (a->x != b->x) ? a->x < b->x : a->y < b->y;
+        });
+
+        for (size_t l = 0; l < lines.size(); l++)
+        {
+            char lineName[32];
+            std::snprintf(lineName, sizeof(lineName), "%g", lines[l]);
+            const string outputName = outputDir + "/" + source.first + "_" + lineName + "keV.txt";
+            std::ofstream output(outputName);
+            if (!output)
+            {
+                cerr << "Could not create '" << outputName << "'." << endl;
+                return 1;
+            }
+            output.precision(6);
+            for (const Point *point : sourcePoints)
+            {
+                output << point->x << " " << point->y << " "
+                       << point->efficiencies[l] << " " << point->errors[l] << "\n";
+            }
+            cout << outputName << ": " << sourcePoints.size() << " points" << endl;
+        }
+    }
+
+    cout << nValid << " of " << files.size() << " files analysed in " << seconds << " s" << endl;
+    return nValid == files.size() ? 0 : 1;
+}
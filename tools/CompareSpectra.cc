@@ -0,0 +1,167 @@
+// ============================================================================
+//
+// G4_HPGe_compare: compares the spectra of a scan with a reference point.
+//
+// Reads the output of /Scan/run (spectra "h1_<n>" and the tree "scan") and
+// prints for every point the simulation speed and how far its spectrum is
+// from the reference: the ratio of the counts and the chi2/ndf of the two
+// spectra within an energy window. Meant for validating simplified models,
+// e.g. a /Scan/addDetail axis with the full model as reference.
+//
+// Usage:
+//     G4_HPGe_compare [-r reference] [-e Emin Emax] scan.root
+//
+// The reference defaults to point 0, the window (in MeV) to everything
+// above the first bin, which holds the events without any deposit.
+//
+// ============================================================================
+
+#include "TFile.h"
+#include "TH1D.h"
+#include "TTree.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+
+static void PrintUsage()
+{
+    cerr << "Usage: G4_HPGe_compare [-r reference] [-e Emin Emax] scan.root" << endl;
+    cerr << "       energies in MeV." << endl;
+}
+
+
+int main(int argc, char **argv)
+{
+    int reference = 0;
+    double Emin = -1;
+    double Emax = -1;
+    string inputName;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const string arg = argv[i];
+        if (arg == "-r" && i+1 < argc)
+        {
+            reference = std::atoi(argv[++i]);
+        }
+        else if (arg == "-e" && i+2 < argc)
+        {
+            Emin = std::atof(argv[++i]);
+            Emax = std::atof(argv[++i]);
+        }
+        else if (inputName.empty() && arg[0] != '-')
+        {
+            inputName = arg;
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if (inputName.empty())
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    TH1::AddDirectory(false);
+
+    unique_ptr<TFile> input(TFile::Open(inputName.c_str(), "READ"));
+    if (!input || input->IsZombie())
+    {
+        cerr << "Could not open '" << inputName << "'." << endl;
+        return 1;
+    }
+
+    TTree *scan = nullptr;
+    input->GetObject("scan", scan);
+    if (!scan)
+    {
+        cerr << "'" << inputName << "' contains no scan tree." << endl;
+        return 1;
+    }
+
+    int point = 0;
+    int events = 0;
+    double runTime = 0;
+    const bool hasTime = scan->GetBranch("Time") != nullptr;
+    scan->SetBranchAddress("Point", &point);
+    scan->SetBranchAddress("Events", &events);
+    if (hasTime)
+    {
+        scan->SetBranchAddress("Time", &runTime);
+    }
+
+    const Long64_t nPoints = scan->GetEntries();
+    vector<unique_ptr<TH1D>> spectra(nPoints);
+    vector<double> rates(nPoints, 0);
+    for (Long64_t entry = 0; entry < nPoints; entry++)
+    {
+        scan->GetEntry(entry);
+        TH1D *h1 = nullptr;
+        input->GetObject(("h1_" + std::to_string(point)).c_str(), h1);
+        if (!h1 || point < 0 || point >= nPoints)
+        {
+            cerr << "Spectrum of point " << point << " is missing." << endl;
+            return 1;
+        }
+        spectra[point].reset(h1);
+        rates[point] = (hasTime && runTime > 0) ? events/runTime : 0;
+    }
+
+    if (reference < 0 || reference >= nPoints)
+    {
+        cerr << "Reference point " << reference << " is not in the scan." << endl;
+        return 1;
+    }
+
+    // the first bin holds the events without deposit
+    const TAxis *axis = spectra[reference]->GetXaxis();
+    const int firstBin = (Emin < 0) ? 2 : axis->FindFixBin(Emin);
+    const int lastBin = (Emax < 0) ? axis->GetNbins() : axis->FindFixBin(Emax);
+    for (auto &spectrum : spectra)
+    {
+        spectrum->GetXaxis()->SetRange(firstBin, lastBin);
+    }
+
+    const double referenceCounts = spectra[reference]->Integral(firstBin, lastBin);
+
+    cout << "Window " << axis->GetBinLowEdge(firstBin) << " - " << axis->GetBinUpEdge(lastBin)
+         << " MeV, reference point " << reference << endl;
+    printf("%6s %12s %9s %12s %10s %12s %10s\n",
+           "point", "events/s", "speedup", "counts", "ratio", "chi2/ndf", "p-value");
+    for (Long64_t n = 0; n < nPoints; n++)
+    {
+        const double counts = spectra[n]->Integral(firstBin, lastBin);
+        const double ratio = referenceCounts > 0 ? counts/referenceCounts : 0;
+        const double speedup = rates[reference] > 0 ? rates[n]/rates[reference] : 0;
+
+        double chi2 = 0;
+        double pValue = 1;
+        if (n != reference)
+        {
+            int ndf = 0;
+            int good = 0;
+            pValue = spectra[reference]->Chi2TestX(spectra[n].get(), chi2, ndf, good, "UU");
+            chi2 = ndf > 0 ? chi2/ndf : 0;
+        }
+
+        printf("%6lld %12.1f %9.2f %12.0f %10.4f %12.3f %10.3g\n",
+               n, rates[n], speedup, counts, ratio, chi2, pValue);
+    }
+
+    return 0;
+}
@@ -0,0 +1,255 @@
+// ============================================================================
+//
+// G4_HPGe_convert: converts primary events into the binary event file read by
+// /PrimaryGenerator/EventFileGun (layout in EventFileFormat.hh).
+//
+// Text input has one primary per line,
+//
+//     event  pdg  energy  x  y  z  dx  dy  dz  [weight  [time]]
+//
+// with the kinetic energy in MeV, the vertex in mm and the time in ns; lines
+// starting with '#' are ignored. ROOT input (*.root) needs a tree with
+// branches of these names (any numeric type, weight and time optional).
+// Consecutive primaries with the same event number form one event.
+//
+// Usage:
+//     G4_HPGe_convert [-t tree] input.txt|input.root output.evt
+//
+// The input is read twice, first to build the event index, then to write the
+// primaries, so that files larger than the memory can be converted.
+//
+// ============================================================================
+
+#include "generator/EventFileGun/EventFileFormat.hh"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TTreeFormula.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::function;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+typedef function<void(int64_t event, const EventFilePrimary &primary)> PrimaryCallback;
+
+
+static void PrintUsage()
+{
+    cerr << "Usage: G4_HPGe_convert [-t tree] input.txt|input.root output.evt" << endl;
+}
+
+
+static bool ReadText(const string &inputName, const PrimaryCallback &callback)
+{
+    std::ifstream input(inputName);
+    if (!input)
+    {
+        cerr << "Could not open '" << inputName << "'." << endl;
+        return false;
+    }
+
+    string line;
+    int lineNumber = 0;
+    while (std::getline(input, line))
+    {
+        lineNumber++;
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        int64_t event;
+        EventFilePrimary primary = {};
+        if (!(fields >> event >> primary.pdg >> primary.energy
+                     >> primary.x >> primary.y >> primary.z
+                     >> primary.dx >> primary.dy >> primary.dz))
+        {
+            cerr << inputName << ":" << lineNumber << ": expected event pdg energy x y z dx dy dz" << endl;
+            return false;
+        }
+        if (!(fields >> primary.weight))
+        {
+            primary.weight = 1;
+        }
+        if (!(fields >> primary.time))
+        {
+            primary.time = 0;
+        }
+        callback(event, primary);
+    }
+    return true;
+}
+
+
+static bool ReadRoot(const string &inputName, const string &treeName, const PrimaryCallback &callback)
+{
+    unique_ptr<TFile> input(TFile::Open(inputName.c_str(), "READ"));
+    if (!input || input->IsZombie())
+    {
+        cerr << "Could not open '" << inputName << "'." << endl;
+        return false;
+    }
+    TTree *tree = nullptr;
+    input->GetObject(treeName.c_str(), tree);
+    if (!tree)
+    {
+        cerr << "'" << inputName << "' contains no tree '" << treeName << "'." << endl;
+        return false;
+    }
+
+    // formulas read branches of any numeric type
+    const vector<string> names = {"event", "pdg", "energy", "x", "y", "z", "dx", "dy", "dz", "weight", "time"};
+    vector<unique_ptr<TTreeFormula>> formulas;
+    for (const auto &name : names)
+    {
+        const bool optional = (name == "weight" || name == "time");
+        if (!tree->GetBranch(name.c_str()))
+        {
+            if (!optional)
+            {
+                cerr << "Tree '" << treeName << "' has no branch '" << name << "'." << endl;
+                return false;
+            }
+            formulas.emplace_back(nullptr);
+            continue;
+        }
+        formulas.emplace_back(new TTreeFormula(name.c_str(), name.c_str(), tree));
+    }
+
+    const Long64_t nEntries = tree->GetEntries();
+    for (Long64_t entry = 0; entry < nEntries; entry++)
+    {
+        tree->LoadTree(entry);
+        double values[11];
+        for (size_t i = 0; i < formulas.size(); i++)
+        {
+            values[i] = formulas[i] ? formulas[i]->EvalInstance() : (names[i] == "weight" ? 1 : 0);
+        }
+
+        EventFilePrimary primary = {};
+        primary.pdg = static_cast<int32_t>(values[1]);
+        primary.energy = values[2];
+        primary.x = values[3];
+        primary.y = values[4];
+        primary.z = values[5];
+        primary.dx = values[6];
+        primary.dy = values[7];
+        primary.dz = values[8];
+        primary.weight = values[9];
+        primary.time = values[10];
+        callback(static_cast<int64_t>(values[0]), primary);
+    }
+    return true;
+}
+
+
+int main(int argc, char **argv)
+{
+    string treeName = "events";
+    vector<string> files;
+    for (int i = 1; i < argc; i++)
+    {
+        const string arg = argv[i];
+        if (arg == "-t" && i+1 < argc)
+        {
+            treeName = argv[++i];
+        }
+        else if (arg[0] != '-')
+        {
+            files.push_back(arg);
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if (files.size() != 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+    const string &inputName = files[0];
+    const string &outputName = files[1];
+
+    const bool isRoot = inputName.size() > 5 && inputName.compare(inputName.size() - 5, 5, ".root") == 0;
+    auto read = [&](const PrimaryCallback &callback)
+    {
+        return isRoot ? ReadRoot(inputName, treeName, callback) : ReadText(inputName, callback);
+    };
+
+    // first pass: event index
+    vector<uint64_t> firstPrimary;
+    uint64_t nPrimaries = 0;
+    bool first = true;
+    int64_t lastEvent = 0;
+    const bool indexed = read([&](int64_t event, const EventFilePrimary &)
+    {
+        if (first || event != lastEvent)
+        {
+            firstPrimary.push_back(nPrimaries);
+            lastEvent = event;
+            first = false;
+        }
+        nPrimaries++;
+    });
+    if (!indexed)
+    {
+        return 1;
+    }
+    if (firstPrimary.empty())
+    {
+        cerr << "'" << inputName << "' contains no primaries." << endl;
+        return 1;
+    }
+    firstPrimary.push_back(nPrimaries);
+
+    FILE *output = std::fopen(outputName.c_str(), "wb");
+    if (!output)
+    {
+        cerr << "Could not create '" << outputName << "'." << endl;
+        return 1;
+    }
+
+    EventFileHeader header = {};
+    std::copy(EventFile::magic, EventFile::magic + sizeof(header.magic), header.magic);
+    header.version = EventFile::version;
+    header.primarySize = sizeof(EventFilePrimary);
+    header.nEvents = firstPrimary.size() - 1;
+    header.nPrimaries = nPrimaries;
+    std::fwrite(&header, sizeof(header), 1, output);
+    std::fwrite(firstPrimary.data(), sizeof(uint64_t), firstPrimary.size(), output);
+
+    // second pass: primaries
+    uint64_t written = 0;
+    const bool converted = read([&](int64_t, const EventFilePrimary &primary)
+    {
+        written += std::fwrite(&primary, sizeof(primary), 1, output);
+    });
+    const bool closed = std::fclose(output) == 0;
+    if (!converted || !closed || written != nPrimaries)
+    {
+        cerr << "Writing '" << outputName << "' failed." << endl;
+        std::remove(outputName.c_str());
+        return 1;
+    }
+
+    cout << outputName << ": " << header.nEvents << " events, " << nPrimaries << " primaries" << endl;
+    return 0;
+}
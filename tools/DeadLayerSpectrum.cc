@@ -0,0 +1,242 @@
+// ============================================================================
+//
+// G4_HPGe_deadlayer: rebuilds the energy spectrum for other dead layers.
+//
+// Needs an output of G4_HPGe that was run with
+//     /Geometry/HPGeDetector/depthRecordBinWidth <width> <unit>
+// which stores, for every event with a deposit in the crystal, the deposits
+// binned by their depth below the four crystal surfaces (tree "dl"). For
+// every set of dead-layer thicknesses (front, outside, inside, back in mm)
+// the spectrum is rebuilt from the deposits that lie deeper than all four
+// dead layers, so one simulation covers a whole scan of the dead layers.
+//
+// The thicknesses are rounded to the nearest multiple of the bin width and
+// must be smaller than 255 bin widths. The dead layers of the simulation
+// itself do not matter: they are made of germanium as well, and deposits in
+// them are recorded like all others.
+//
+// Usage:
+//     G4_HPGe_deadlayer input.root output.root f o i b [f o i b ...]
+//     G4_HPGe_deadlayer input.root output.root @sets.txt
+//
+// The spectrum of the n-th set is written as "h1_<n>", titled with the set.
+//
+// ============================================================================
+
+#include "TFile.h"
+#include "TH1D.h"
+#include "TTree.h"
+#include "TParameter.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+// Layout of the keys, as written by DeadLayerRecord
+static const int nSurfaces = 4;
+static const unsigned int nDepthBins = 256;
+
+struct DeadLayerSet
+{
+    double thickness[nSurfaces];
+    unsigned int minBin[nSurfaces];
+};
+
+
+static void PrintUsage()
+{
+    cerr << "Usage: G4_HPGe_deadlayer input.root output.root f o i b [f o i b ...]" << endl;
+    cerr << "       G4_HPGe_deadlayer input.root output.root @sets.txt" << endl;
+    cerr << "       thicknesses of the front, outside, inside and back dead layers in mm." << endl;
+}
+
+
+static void ReadSets(const vector<string> &args, vector<double> &values)
+{
+    for (const auto &arg : args)
+    {
+        if (arg.size() > 1 && arg[0] == '@')
+        {
+            std::ifstream file(arg.substr(1));
+            if (!file)
+            {
+                cerr << "Could not open '" << arg.substr(1) << "'." << endl;
+                exit(1);
+            }
+            string line;
+            while (std::getline(file, line))
+            {
+                if (line.empty() || line[0] == '#')
+                {
+                    continue;
+                }
+                std::istringstream input(line);
+                double value;
+                while (input >> value)
+                {
+                    values.push_back(value);
+                }
+            }
+        }
+        else
+        {
+            values.push_back(std::atof(arg.c_str()));
+        }
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    const string inputName = argv[1];
+    const string outputName = argv[2];
+
+    vector<double> values;
+    ReadSets(vector<string>(argv + 3, argv + argc), values);
+    if (values.empty() || values.size() % nSurfaces != 0)
+    {
+        cerr << "The dead layers have to be given in sets of four (front, outside, inside, back)." << endl;
+        return 1;
+    }
+
+    TH1::AddDirectory(false);
+
+    unique_ptr<TFile> input(TFile::Open(inputName.c_str(), "READ"));
+    if (!input || input->IsZombie())
+    {
+        cerr << "Could not open '" << inputName << "'." << endl;
+        return 1;
+    }
+
+    TH1D *h1 = nullptr;
+    TTree *dl = nullptr;
+    TParameter<double> *binWidthParameter = nullptr;
+    input->GetObject("h1", h1);
+    input->GetObject("dl", dl);
+    input->GetObject("dlBinWidth", binWidthParameter);
+    if (!h1 || !dl || !binWidthParameter)
+    {
+        cerr << "'" << inputName << "' contains no dead-layer records, "
+             << "run the simulation with /Geometry/HPGeDetector/depthRecordBinWidth." << endl;
+        return 1;
+    }
+    const double binWidth = binWidthParameter->GetVal();
+
+    vector<DeadLayerSet> sets(values.size() / nSurfaces);
+    for (size_t n = 0; n < sets.size(); n++)
+    {
+        for (int s = 0; s < nSurfaces; s++)
+        {
+            const double thickness = values[nSurfaces*n + s];
+            const long bin = std::lround(thickness / binWidth);
+            if (thickness < 0 || bin >= static_cast<long>(nDepthBins) - 1)
+            {
+                cerr << "Dead layer of " << thickness << " mm is outside of the recorded range [0, "
+                     << (nDepthBins - 1)*binWidth << ") mm." << endl;
+                return 1;
+            }
+            sets[n].thickness[s] = thickness;
+            sets[n].minBin[s] = bin;
+        }
+    }
+
+    // Same binning as the original spectrum
+    vector<unique_ptr<TH1D>> spectra;
+    for (size_t n = 0; n < sets.size(); n++)
+    {
+        std::ostringstream name, title;
+        name << "h1_" << n;
+        title << "front " << sets[n].thickness[0] << " mm, outside " << sets[n].thickness[1]
+              << " mm, inside " << sets[n].thickness[2] << " mm, back " << sets[n].thickness[3] << " mm";
+        spectra.emplace_back(static_cast<TH1D*>(h1->Clone(name.str().c_str())));
+        spectra.back()->Reset();
+        spectra.back()->SetTitle(title.str().c_str());
+    }
+
+    // Events without any deposit in the crystal end up at zero for every set
+    const double emptyEvents = h1->GetEntries() - dl->GetEntries();
+    const double Emin = h1->GetXaxis()->GetXmin();
+    const double Emax = h1->GetXaxis()->GetXmax();
+
+    vector<unsigned int> *keys = nullptr;
+    vector<float> *edeps = nullptr;
+    dl->SetBranchAddress("Key", &keys);
+    dl->SetBranchAddress("Edep", &edeps);
+
+    vector<double> energies(sets.size());
+    const Long64_t nEntries = dl->GetEntries();
+    for (Long64_t entry = 0; entry < nEntries; entry++)
+    {
+        dl->GetEntry(entry);
+
+        for (auto &energy : energies)
+        {
+            energy = 0;
+        }
+
+        for (size_t j = 0; j < keys->size(); j++)
+        {
+            const unsigned int key = (*keys)[j];
+            for (size_t n = 0; n < sets.size(); n++)
+            {
+                bool active = true;
+                for (int s = 0; s < nSurfaces && active; s++)
+                {
+                    active = ((key >> (8*s)) & 0xFF) >= sets[n].minBin[s];
+                }
+                if (active)
+                {
+                    energies[n] += (*edeps)[j];
+                }
+            }
+        }
+
+        // out of range energies go to zero, as in the simulation
+        for (size_t n = 0; n < sets.size(); n++)
+        {
+            const double energy = energies[n];
+            spectra[n]->Fill((energy < Emin || energy > Emax) ? 0 : energy);
+        }
+    }
+
+    unique_ptr<TFile> output(TFile::Open(outputName.c_str(), "RECREATE"));
+    if (!output || output->IsZombie())
+    {
+        cerr << "Could not create '" << outputName << "'." << endl;
+        return 1;
+    }
+    for (auto &spectrum : spectra)
+    {
+        if (emptyEvents > 0)
+        {
+            const double entries = spectrum->GetEntries();
+            spectrum->Fill(0., emptyEvents);
+            spectrum->SetEntries(entries + emptyEvents);
+        }
+        spectrum->Write();
+    }
+    output->Close();
+
+    cout << "Rebuilt " << sets.size() << " spectra from " << nEntries << " recorded events ("
+         << emptyEvents << " events without deposit in the crystal) into " << outputName << "." << endl;
+
+    return 0;
+}
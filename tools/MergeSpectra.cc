@@ -0,0 +1,379 @@
+// ============================================================================
+//
+// G4_HPGe_merge: combines the outputs of many G4_HPGe runs into one file.
+//
+// The histograms of all inputs are summed by name. An input without one of
+// them counts as empty for it: spectra such as "h1w" and "h1_<component>"
+// only exist in the outputs that saw such events. The summation is spread
+// over several threads, each thread reducing its share of the files into
+// private copies that are added at the end. The trees (e.g. "t1") are then
+// merged with basket-level fast cloning, from the inputs that contain them.
+//
+// The other objects are copied. Parameters
+// (TParameter<double>, TParameter<Long64_t>) are merged following their
+// merge mode: summed by default, while those with the mode 'f' (first, e.g.
+// "dlBinWidth") and named objects must be the same in all inputs.
+//
+// Usage:
+//     G4_HPGe_merge [-j threads] [--no-trees] output.root input.root ...
+//
+// Inputs starting with '@' are read as text files with one input per line.
+//
+// ============================================================================
+
+#include "TFile.h"
+#include "TKey.h"
+#include "TH1.h"
+#include "TTree.h"
+#include "TChain.h"
+#include "TClass.h"
+#include "TList.h"
+#include "TNamed.h"
+#include "TParameter.h"
+#include "TROOT.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::atomic;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::map;
+using std::set;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+typedef map<string, unique_ptr<TH1>> HistogramMap;
+typedef map<string, unique_ptr<TObject>> ObjectMap;
+// the inputs (by index) that contain each tree
+typedef map<string, vector<size_t>> TreeMap;
+
+
+static void PrintUsage()
+{
+    cerr << "Usage: G4_HPGe_merge [-j threads] [--no-trees] output.root input.root ..." << endl;
+    cerr << "       inputs starting with '@' are lists of input files, one per line." << endl;
+}
+
+
+static void AddInput(const string &name, vector<string> &inputs)
+{
+    if (name.size() > 1 && name[0] == '@')
+    {
+        std::ifstream list(name.substr(1));
+        if (!list)
+        {
+            cerr << "Could not open input list '" << name.substr(1) << "'." << endl;
+            exit(1);
+        }
+        string line;
+        while (std::getline(list, line))
+        {
+            if (!line.empty() && line[0] != '#')
+            {
+                inputs.push_back(line);
+            }
+        }
+    }
+    else
+    {
+        inputs.push_back(name);
+    }
+}
+
+
+// Merges other into target if both are parameters of type T, sets differs if
+// a parameter that has to be the same in all inputs is not
+template <typename T>
+static bool MergeParameter(TObject *target, TObject *other, bool &differs)
+{
+    auto parameter = dynamic_cast<TParameter<T>*>(target);
+    auto input = dynamic_cast<TParameter<T>*>(other);
+    if (!parameter || !input)
+    {
+        return false;
+    }
+
+    if (parameter->TestBit(TParameter<T>::kFirst))
+    {
+        differs = parameter->GetVal() != input->GetVal();
+    }
+    else
+    {
+        TList list;
+        list.Add(input);
+        parameter->Merge(&list);
+    }
+    return true;
+}
+
+
+// Merges other into target, returns false if they have to agree but do not
+static bool MergeObject(TObject *target, TObject *other)
+{
+    bool differs = false;
+    if (MergeParameter<double>(target, other, differs) || MergeParameter<Long64_t>(target, other, differs))
+    {
+        return !differs;
+    }
+
+    auto named = dynamic_cast<TNamed*>(target);
+    auto otherNamed = dynamic_cast<TNamed*>(other);
+    if (named && otherNamed)
+    {
+        return string(named->GetTitle()) == otherNamed->GetTitle();
+    }
+    return true;
+}
+
+
+static void SumHistograms(const vector<string> &inputs, atomic<size_t> &nextInput, atomic<size_t> &failures,
+                          HistogramMap &sum, ObjectMap &objectSum, TreeMap &trees)
+{
+    for (size_t i = nextInput++; i < inputs.size(); i = nextInput++)
+    {
+        unique_ptr<TFile> file(TFile::Open(inputs[i].c_str(), "READ"));
+        if (!file || file->IsZombie())
+        {
+            cerr << "Could not open '" << inputs[i] << "', skipping it." << endl;
+            failures++;
+            continue;
+        }
+        // every name once, Get() reads the highest cycle
+        set<string> names;
+        TIter next(file->GetListOfKeys());
+        while (TKey *key = static_cast<TKey*>(next()))
+        {
+            const string name = key->GetName();
+            TClass *cl = TClass::GetClass(key->GetClassName());
+            if (!cl || !names.insert(name).second)
+            {
+                continue;
+            }
+
+            if (cl->InheritsFrom(TTree::Class()))
+            {
+                trees[name].push_back(i);
+            }
+            else if (cl->InheritsFrom(TH1::Class()))
+            {
+                TH1 *histogram = nullptr;
+                file->GetObject(name.c_str(), histogram);
+                if (!histogram)
+                {
+                    cerr << "Could not read histogram '" << name << "' from '" << inputs[i] << "'." << endl;
+                    failures++;
+                    continue;
+                }
+
+                auto it = sum.find(name);
+                if (it == sum.end())
+                {
+                    histogram->SetDirectory(nullptr);
+                    sum[name].reset(histogram);
+                }
+                else
+                {
+                    it->second->Add(histogram);
+                    delete histogram;
+                }
+            }
+            else
+            {
+                unique_ptr<TObject> object(file->Get(name.c_str()));
+                if (!object)
+                {
+                    cerr << "Could not read '" << name << "' from '" << inputs[i] << "'." << endl;
+                    failures++;
+                    continue;
+                }
+
+                auto it = objectSum.find(name);
+                if (it == objectSum.end())
+                {
+                    objectSum[name] = std::move(object);
+                }
+                else if (!MergeObject(it->second.get(), object.get()))
+                {
+                    cerr << "'" << name << "' in '" << inputs[i] << "' differs from the other inputs." << endl;
+                    failures++;
+                }
+            }
+        }
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    unsigned nThreads = std::thread::hardware_concurrency();
+    bool mergeTrees = true;
+    string outputName;
+    vector<string> inputs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const string arg = argv[i];
+        if (arg == "-j" && i+1 < argc)
+        {
+            nThreads = std::atoi(argv[++i]);
+        }
+        else if (arg == "--no-trees")
+        {
+            mergeTrees = false;
+        }
+        else if (arg == "-h" || arg == "--help")
+        {
+            PrintUsage();
+            return 0;
+        }
+        else if (outputName.empty())
+        {
+            outputName = arg;
+        }
+        else
+        {
+            AddInput(arg, inputs);
+        }
+    }
+
+    if (outputName.empty() || inputs.empty())
+    {
+        PrintUsage();
+        return 1;
+    }
+    if (nThreads < 1)
+    {
+        nThreads = 1;
+    }
+    if (nThreads > inputs.size())
+    {
+        nThreads = inputs.size();
+    }
+
+    ROOT::EnableThreadSafety();
+    TH1::AddDirectory(false);
+
+    // Each thread sums its share of the inputs into its own histograms
+    vector<HistogramMap> partialSums(nThreads);
+    vector<ObjectMap> partialObjects(nThreads);
+    vector<TreeMap> partialTrees(nThreads);
+    vector<std::thread> threads;
+    atomic<size_t> nextInput(0);
+    atomic<size_t> failures(0);
+
+    for (unsigned t = 0; t < nThreads; t++)
+    {
+        threads.emplace_back(SumHistograms, std::cref(inputs), std::ref(nextInput), std::ref(failures),
+                             std::ref(partialSums[t]), std::ref(partialObjects[t]), std::ref(partialTrees[t]));
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    HistogramMap &sum = partialSums.front();
+    for (unsigned t = 1; t < nThreads; t++)
+    {
+        for (auto &entry : partialSums[t])
+        {
+            auto it = sum.find(entry.first);
+            if (it == sum.end())
+            {
+                sum[entry.first] = std::move(entry.second);
+            }
+            else
+            {
+                it->second->Add(entry.second.get());
+            }
+        }
+    }
+
+    ObjectMap &objectSum = partialObjects.front();
+    for (unsigned t = 1; t < nThreads; t++)
+    {
+        for (auto &entry : partialObjects[t])
+        {
+            auto it = objectSum.find(entry.first);
+            if (it == objectSum.end())
+            {
+                objectSum[entry.first] = std::move(entry.second);
+            }
+            else if (!MergeObject(it->second.get(), entry.second.get()))
+            {
+                cerr << "'" << entry.first << "' differs between the inputs." << endl;
+                failures++;
+            }
+        }
+    }
+
+    // the trees keep the order of the inputs
+    TreeMap trees;
+    for (auto &partial : partialTrees)
+    {
+        for (auto &entry : partial)
+        {
+            auto &files = trees[entry.first];
+            files.insert(files.end(), entry.second.begin(), entry.second.end());
+        }
+    }
+    for (auto &entry : trees)
+    {
+        std::sort(entry.second.begin(), entry.second.end());
+    }
+
+    if (sum.empty())
+    {
+        cerr << "No histograms found in the inputs." << endl;
+        return 1;
+    }
+
+    unique_ptr<TFile> output(TFile::Open(outputName.c_str(), "RECREATE"));
+    if (!output || output->IsZombie())
+    {
+        cerr << "Could not create '" << outputName << "'." << endl;
+        return 1;
+    }
+
+    if (mergeTrees)
+    {
+        for (const auto &entry : trees)
+        {
+            // only the inputs that were read and contain the tree
+            TChain chain(entry.first.c_str());
+            for (const size_t i : entry.second)
+            {
+                chain.Add(inputs[i].c_str());
+            }
+            chain.Merge(output.get(), 0, "fast keep");
+        }
+    }
+
+    output->cd();
+    for (const auto &entry : sum)
+    {
+        entry.second->Write(entry.first.c_str());
+    }
+    for (const auto &entry : objectSum)
+    {
+        entry.second->Write(entry.first.c_str());
+    }
+    output->Close();
+
+    cout << "Merged " << inputs.size() << " files (" << sum.size() << " histograms, "
+         << (mergeTrees ? trees.size() : 0) << " trees) into " << outputName
+         << " using " << nThreads << " threads." << endl;
+
+    return failures == 0 ? 0 : 2;
+}